@@ -0,0 +1,298 @@
+/*
+ * libmacchiato - Front-end for the Macchiato modding environment
+ * Copyright (C) 2024 splatoon1enjoyer @ SDL Foundation
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Host microbenchmark for `assemble`. Measures throughput and heap
+// allocations per instruction with a cold and a warm memo, once per operand
+// form and once for generated patch corpora of growing size. Run it before
+// and after touching the assembler to catch regressions in plugin boot time.
+
+#include "LibMacchiato/Assembler.h"
+
+#include <sdl-utils/Types.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <expected>
+#include <new>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace LibMacchiato::PPCAssembler;
+
+namespace {
+    std::atomic<size_t> allocationNum = 0;
+} // namespace
+
+// Every heap allocation of the process goes through these, which is all the
+// bookkeeping the allocation count needs.
+void* operator new(size_t size) {
+    allocationNum.fetch_add(1, std::memory_order_relaxed);
+
+    if (void* memory = std::malloc(size == 0 ? 1 : size))
+        return memory;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) { return ::operator new(size); }
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, size_t) noexcept { std::free(memory); }
+
+namespace {
+    // Instructions assembled per measurement, spread over as many rounds as
+    // the input takes.
+    constexpr size_t INSTRUCTION_BUDGET = 400'000;
+
+    enum class Memo {
+        Cold,
+        Warm,
+    };
+
+    struct Result {
+        double instructionsPerSecond     = 0;
+        double allocationsPerInstruction = 0;
+    };
+
+    std::string hex(u32 value) {
+        std::array<char, 16> buffer = {};
+        std::snprintf(buffer.data(), buffer.size(), "0x%X", value);
+
+        return buffer.data();
+    }
+
+    std::string gpr(u32 reg) { return "r" + std::to_string(reg); }
+
+    // A cold memo is cleared before every round, so each distinct line
+    // misses once per round like on the first boot of a plugin.
+    Result measure(const std::vector<std::string>& lines, Memo memo) {
+        const size_t rounds =
+            std::max<size_t>(1, INSTRUCTION_BUDGET / lines.size());
+
+        clearAssemblyMemo();
+        if (memo == Memo::Warm) {
+            for (const auto& line : lines)
+                static_cast<void>(assemble(line));
+        }
+
+        volatile u32                        sink     = 0;
+        std::chrono::steady_clock::duration duration = {};
+        size_t                              allocs   = 0;
+
+        for (size_t round = 0; round < rounds; round++) {
+            if (memo == Memo::Cold)
+                clearAssemblyMemo();
+
+            const size_t allocsBefore =
+                allocationNum.load(std::memory_order_relaxed);
+            const auto start = std::chrono::steady_clock::now();
+
+            for (const auto& line : lines)
+                sink = sink + assemble(line).value_or(0);
+
+            duration += std::chrono::steady_clock::now() - start;
+            allocs +=
+                allocationNum.load(std::memory_order_relaxed) - allocsBefore;
+        }
+
+        const double total = static_cast<double>(rounds * lines.size());
+
+        return Result{
+            .instructionsPerSecond =
+                total / std::chrono::duration<double>(duration).count(),
+            .allocationsPerInstruction = static_cast<double>(allocs) / total};
+    }
+
+    void report(const char* name, const std::vector<std::string>& lines) {
+        for (const auto& line : lines) {
+            std::expected<u32, AssembleError> code = assemble(line);
+            if (!code.has_value()) {
+                std::printf("%s: \"%s\" does not assemble: %s\n", name,
+                            line.c_str(),
+                            assembleErrorToStr(code.error(), line).c_str());
+                std::exit(1);
+            }
+        }
+
+        const Result cold = measure(lines, Memo::Cold);
+        const Result warm = measure(lines, Memo::Warm);
+
+        std::printf("%-22s %7zu | cold %6.2f M/s %5.2f allocs | "
+                    "warm %6.2f M/s %5.2f allocs\n",
+                    name, lines.size(), cold.instructionsPerSecond / 1e6,
+                    cold.allocationsPerInstruction,
+                    warm.instructionsPerSecond / 1e6,
+                    warm.allocationsPerInstruction);
+    }
+
+    // Distinct lines of each form, few enough to all fit into the memo.
+    constexpr size_t FORM_LINE_NUM = 256;
+
+    std::vector<std::string> dForm(std::mt19937& random) {
+        std::vector<std::string> lines = {};
+
+        for (size_t i = 0; i < FORM_LINE_NUM; i++)
+            lines.push_back("addi " + gpr(random() % 32) + ", "
+                            + gpr(random() % 32) + ", "
+                            + hex(random() % 0x8000));
+
+        return lines;
+    }
+
+    std::vector<std::string> indirectDForm(std::mt19937& random) {
+        constexpr std::array MNEMONICS = {"lwz", "stw", "lbz", "sth", "lfs"};
+
+        std::vector<std::string> lines = {};
+
+        for (size_t i = 0; i < FORM_LINE_NUM; i++) {
+            const std::string mnemonic = MNEMONICS[i % MNEMONICS.size()];
+            const std::string dst =
+                mnemonic == "lfs" ? "f" + std::to_string(random() % 32)
+                                  : gpr(random() % 32);
+
+            lines.push_back(mnemonic + " " + dst + ", "
+                            + hex(random() % 0x2000 * 4) + "("
+                            + gpr(random() % 32) + ")");
+        }
+
+        return lines;
+    }
+
+    std::vector<std::string> bForm(std::mt19937& random) {
+        constexpr std::array MNEMONICS = {"beq", "bne", "blt", "bge"};
+
+        std::vector<std::string> lines = {};
+
+        for (size_t i = 0; i < FORM_LINE_NUM; i++)
+            lines.push_back(std::string(MNEMONICS[i % MNEMONICS.size()])
+                            + " cr" + std::to_string(random() % 8) + ", "
+                            + hex(random() % 0x2000 * 4));
+
+        return lines;
+    }
+
+    std::vector<std::string> sprMoves(std::mt19937& random) {
+        // XER, LR, CTR and the GQRs of paired singles.
+        constexpr std::array<u32, 5> SPRS = {1, 8, 9, 912, 913};
+
+        std::vector<std::string> lines = {};
+
+        for (size_t i = 0; i < FORM_LINE_NUM; i++) {
+            const std::string reg = gpr(random() % 32);
+            const std::string spr = std::to_string(SPRS[i % SPRS.size()]);
+
+            switch (i % 4) {
+            case 0:
+                lines.push_back("mfspr " + reg + ", " + spr);
+                break;
+            case 1:
+                lines.push_back("mtspr " + spr + ", " + reg);
+                break;
+            case 2:
+                lines.push_back("mflr " + reg);
+                break;
+            default:
+                lines.push_back("mtctr " + reg);
+                break;
+            }
+        }
+
+        return lines;
+    }
+
+    // Patches repeat prologues, epilogues and `nop`s a lot, the rest is
+    // loads, stores and arithmetic on varying registers and offsets.
+    std::vector<std::string> patchCorpus(size_t size, std::mt19937& random) {
+        constexpr std::array COMMON = {
+            "nop",
+            "blr",
+            "bctrl",
+            "mflr r0",
+            "mtlr r0",
+            "stw r0, 0x24(r1)",
+            "lwz r0, 0x24(r1)",
+            "stwu r1, -0x20(r1)",
+            "addi r1, r1, 0x20",
+            "li r3, 0",
+            "li r3, 1",
+            "li r4, 0",
+        };
+
+        std::vector<std::string> lines = {};
+        lines.reserve(size);
+
+        for (size_t i = 0; i < size; i++) {
+            const std::string dst = gpr(random() % 32);
+            const std::string src = gpr(random() % 32);
+
+            switch (random() % 8) {
+            case 0:
+            case 1:
+            case 2:
+                lines.emplace_back(COMMON[random() % COMMON.size()]);
+                break;
+            case 3:
+                lines.push_back("lwz " + dst + ", " + hex(random() % 0x400 * 4)
+                                + "(" + src + ")");
+                break;
+            case 4:
+                lines.push_back("stw " + dst + ", " + hex(random() % 0x400 * 4)
+                                + "(" + src + ")");
+                break;
+            case 5:
+                lines.push_back("addi " + dst + ", " + src + ", "
+                                + hex(random() % 0x1000));
+                break;
+            case 6:
+                lines.push_back("cmpwi " + dst + ", "
+                                + std::to_string(random() % 64));
+                break;
+            default:
+                lines.push_back("lis " + dst + ", " + hex(random() % 0x10000));
+                break;
+            }
+        }
+
+        return lines;
+    }
+} // namespace
+
+int main() {
+    std::mt19937 random(0x4D414343);
+
+    std::printf("assemble(), instructions per second and heap allocations "
+                "per instruction\n");
+
+    report("D-form", dForm(random));
+    report("indirect D-form", indirectDForm(random));
+    report("B-form", bForm(random));
+    report("SPR moves", sprMoves(random));
+
+    for (const size_t size : {1'000, 10'000, 100'000})
+        report("patch corpus", patchCorpus(size, random));
+
+    return 0;
+}
@@ -0,0 +1,195 @@
+/*
+ * libmacchiato - Front-end for the Macchiato modding environment
+ * Copyright (C) 2024 splatoon1enjoyer @ SDL Foundation
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Host test of `assembleBlock` and `measureBlock` against golden encodings.
+// The block assembler is not `constexpr`, so unlike the rest of the
+// assembler it cannot be checked with `static_assert`.
+
+#include "LibMacchiato/Assembler/Block.h"
+#include "LibMacchiato/Assembler/Error.h"
+
+#include <sdl-utils/Types.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <expected>
+#include <string_view>
+#include <vector>
+
+using namespace LibMacchiato::PPCAssembler;
+
+namespace {
+    // Far enough from 0 that absolute branches are shorter than relative
+    // ones to `low`.
+    constexpr u32 BASE = 0x02800000;
+
+    struct GoldenCase {
+        const char*      name;
+        std::string_view source;
+        std::vector<u32> code;
+    };
+
+    const SymbolTable SYMBOLS = {
+        {"near", BASE + 0x100},
+        {"far", BASE + 0x10000},
+        {"distant", 0x80001000},
+        {"low", 0x1000},
+        {"data", 0x80018000},
+    };
+
+    const std::vector<GoldenCase> GOLDEN_CASES = {
+        {"labels",
+         "loop:\n"
+         "    lwz r4, 0(r3)\n"
+         "    addi r3, r3, 4 ; comment\n"
+         "    # comment\n"
+         "    bne loop\n"
+         "    b end\n"
+         "    nop\n"
+         "end:\n"
+         "    blr\n",
+         {0x80830000, 0x38630004, 0x4082FFF8, 0x48000008, 0x60000000,
+          0x4E800020}},
+        {"relaxed beq",
+         "beq far\n"
+         "beq near\n",
+         {0x40820008, 0x4800FFFC, 0x418200F8}},
+        {"relaxed bl",
+         "bl near\n"
+         "bl low\n"
+         "bl distant\n",
+         {0x48000101, 0x48001003, 0x3D608000, 0x616B1000, 0x7D6903A6,
+          0x4E800421}},
+        {"relaxed jmp",
+         "jmp near\n"
+         "jmp low\n"
+         "jmp distant\n"
+         "call low\n",
+         {0x48000100, 0x48001002, 0x3D608000, 0x616B1000, 0x7D6903A6,
+          0x4E800420, 0x48001003}},
+        {"directives",
+         "    b end\n"
+         "value:\n"
+         "    .long value\n"
+         "    .long 0x12345678\n"
+         "    .float 1.5\n"
+         "    .align 4\n"
+         "end:\n"
+         "    .long end - value\n",
+         {0x48000010, BASE + 4, 0x12345678, 0x3FC00000, 0x0000000C}},
+        {"align padding",
+         "    nop\n"
+         "    .align 3\n"
+         "    blr\n",
+         {0x60000000, 0x60000000, 0x4E800020}},
+        {"ha and l",
+         "lis r5, data@ha\n"
+         "lwz r5, data@l(r5)\n"
+         "addi r6, r5, data@l\n"
+         "li r7, (end - start) / 4\n"
+         "start:\n"
+         ".long 0\n"
+         ".long 0\n"
+         "end:\n",
+         {0x3CA08002, 0x80A58000, 0x38C58000, 0x38E00002, 0, 0}},
+    };
+
+    struct ErrorCase {
+        const char*       name;
+        std::string_view  source;
+        // Counted from 1.
+        size_t            line;
+        AssembleErrorCode code;
+        std::string_view  text;
+    };
+
+    const std::vector<ErrorCase> ERROR_CASES = {
+        {"duplicate label",
+         "start:\n"
+         "    nop\n"
+         "start:\n",
+         3, AssembleErrorCode::DuplicateLabel, "start"},
+        {"undefined symbol", "    b nowhere\n", 1,
+         AssembleErrorCode::UndefinedSymbol, "nowhere"},
+        {"unknown directive", "    .quad 1\n", 1,
+         AssembleErrorCode::InvalidDirective, ".quad"},
+    };
+
+    bool check(const GoldenCase& golden) {
+        std::expected<std::vector<u32>, BlockError> code =
+            assembleBlock(golden.source, BASE, SYMBOLS);
+        if (!code.has_value()) {
+            std::printf("%s: does not assemble: %s\n", golden.name,
+                        blockErrorToStr(code.error(), golden.source).c_str());
+            return false;
+        }
+
+        bool matches = code.value() == golden.code;
+        if (!matches) {
+            std::printf("%s: got", golden.name);
+            for (const u32 word : code.value())
+                std::printf(" 0x%08X", word);
+            std::printf("\n");
+        }
+
+        // The upper bound holds wherever the block ends up.
+        const std::expected<size_t, BlockError> size =
+            measureBlock(golden.source, SYMBOLS);
+        if (!size.has_value()
+            || size.value() < code->size() * sizeof(u32)) {
+            std::printf("%s: measured below its assembled size\n",
+                        golden.name);
+            matches = false;
+        }
+
+        return matches;
+    }
+
+    bool check(const ErrorCase& expected) {
+        std::expected<std::vector<u32>, BlockError> code =
+            assembleBlock(expected.source, BASE, SYMBOLS);
+        if (code.has_value()) {
+            std::printf("%s: assembled\n", expected.name);
+            return false;
+        }
+
+        const BlockError& error = code.error();
+        if (error.line != expected.line || error.error.code != expected.code
+            || error.error.span.in(expected.source) != expected.text) {
+            std::printf("%s: unexpected error: %s\n", expected.name,
+                        blockErrorToStr(error, expected.source).c_str());
+            return false;
+        }
+
+        return true;
+    }
+} // namespace
+
+int main() {
+    size_t failed = 0;
+
+    for (const auto& golden : GOLDEN_CASES)
+        failed += check(golden) ? 0 : 1;
+
+    for (const auto& expected : ERROR_CASES)
+        failed += check(expected) ? 0 : 1;
+
+    std::printf("%zu of %zu block cases failed\n", failed,
+                GOLDEN_CASES.size() + ERROR_CASES.size());
+
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,148 @@
+/*
+ * libmacchiato - Front-end for the Macchiato modding environment
+ * Copyright (C) 2024 splatoon1enjoyer @ SDL Foundation
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Host microbenchmark for mnemonic lookup. Compares the compile-time perfect
+// hash against a linear scan (equivalent to the old `strToMnemonic` if-chain)
+// while the mnemonic set grows to a few hundred entries.
+
+#include "LibMacchiato/Assembler/MnemonicTable.h"
+#include "LibMacchiato/Assembler/PerfectHash.h"
+
+#include <sdl-utils/Types.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace LibMacchiato::PPCAssembler;
+
+namespace {
+    // Synthetic names append a `.` and two generation letters.
+    constexpr size_t SUFFIX_SIZE = 3;
+
+    // The longest real mnemonic, its suffix and the terminator.
+    constexpr size_t NAME_SIZE = [] {
+        size_t longest = 0;
+        for (const auto& spec : MNEMONIC_SPECS)
+            longest = std::max(longest, spec.name.size());
+
+        return longest + SUFFIX_SIZE + 1;
+    }();
+
+    // The real mnemonics followed by synthetic ones derived from them, so the
+    // key lengths and prefixes stay realistic.
+    template <size_t N> constexpr auto NAME_STORAGE = [] {
+        std::array<std::array<char, NAME_SIZE>, N> storage = {};
+
+        for (size_t i = 0; i < N; i++) {
+            const std::string_view base =
+                MNEMONIC_SPECS[i % MNEMONIC_SPECS.size()].name;
+            const size_t generation = i / MNEMONIC_SPECS.size();
+
+            size_t length = 0;
+            for (const char c : base)
+                storage[i][length++] = c;
+
+            if (generation > 0) {
+                storage[i][length++] = '.';
+                storage[i][length++] = static_cast<char>('a' + generation % 26);
+                storage[i][length++] = static_cast<char>('a' + generation / 26);
+            }
+        }
+
+        return storage;
+    }();
+
+    template <size_t N> constexpr auto NAMES = [] {
+        std::array<std::string_view, N> names = {};
+
+        for (size_t i = 0; i < N; i++)
+            names[i] = std::string_view(NAME_STORAGE<N>[i].data());
+
+        return names;
+    }();
+
+    template <size_t N>
+    constexpr PerfectHash<N> NAME_HASH = buildPerfectHash(NAMES<N>);
+
+    template <size_t N> std::optional<size_t> linearFind(std::string_view key) {
+        for (size_t i = 0; i < N; i++) {
+            if (NAMES<N>[i] == key)
+                return i;
+        }
+
+        return std::nullopt;
+    }
+
+    template <typename Lookup>
+    double nsPerLookup(const std::vector<std::string>& probes, Lookup lookup) {
+        constexpr size_t ROUNDS = 2000;
+
+        volatile size_t sink = 0;
+
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t round = 0; round < ROUNDS; round++) {
+            for (const auto& probe : probes)
+                sink = sink + lookup(probe).value_or(0);
+        }
+        const auto end = std::chrono::steady_clock::now();
+
+        return std::chrono::duration<double, std::nano>(end - start).count()
+               / static_cast<double>(ROUNDS * probes.size());
+    }
+
+    template <size_t N> void run() {
+        std::vector<std::string> probes = {};
+        for (const auto name : NAMES<N>)
+            probes.emplace_back(name);
+
+        // A few misses, as produced by typos or unsupported instructions.
+        for (size_t i = 0; i < N / 10 + 1; i++)
+            probes.push_back("zz" + std::to_string(i));
+
+        std::shuffle(probes.begin(), probes.end(), std::mt19937(N));
+
+        const double hashed =
+            nsPerLookup(probes, [](std::string_view key) {
+                return NAME_HASH<N>.find(key);
+            });
+        const double linear = nsPerLookup(probes, linearFind<N>);
+
+        std::printf("%5zu mnemonics | perfect hash %7.2f ns | "
+                    "linear %8.2f ns\n",
+                    N, hashed, linear);
+    }
+} // namespace
+
+int main() {
+    std::printf("Mnemonic lookup, average per token\n");
+
+    run<MNEMONIC_SPECS.size()>();
+    run<50>();
+    run<100>();
+    run<200>();
+    run<400>();
+
+    return 0;
+}
@@ -0,0 +1,126 @@
+/*
+ * libmacchiato - Front-end for the Macchiato modding environment
+ * Copyright (C) 2024 splatoon1enjoyer @ SDL Foundation
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "LibMacchiato/Patch/Batch.h"
+#include "LibMacchiato/Patch/CodeArena.h"
+#include "LibMacchiato/Patch/Transaction.h"
+
+#include <sdl-utils/Types.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <optional>
+#include <span>
+
+// Test doubles of the memory and code regions that patches write to, for
+// checking them off the console.
+namespace LibMacchiato {
+    /// Host memory at `BASE` that counts the calls of a commit, for checking
+    /// batches off the console.
+    struct CountingPatchMemory {
+        static constexpr u32 BASE = 0x1000 - 0x40;
+
+        std::array<u8, 0x80> memory        = {};
+        size_t               copies        = 0;
+        size_t               reads         = 0;
+        size_t               invalidations = 0;
+        u32                  flushAddress  = 0;
+        u32                  flushSize     = 0;
+
+        // Copies that cover this address are dropped, like writes to memory
+        // that turned out to be read-only.
+        std::optional<u32> readOnlyAddress = std::nullopt;
+
+        constexpr void copy(u32 address, std::span<const u8> bytes) {
+            this->copies++;
+
+            if (this->readOnlyAddress.has_value()
+                && this->readOnlyAddress.value() >= address
+                && this->readOnlyAddress.value() - address < bytes.size())
+                return;
+
+            std::ranges::copy(bytes,
+                              this->memory.begin() + (address - BASE));
+        }
+
+        constexpr void read(u32 address, std::span<u8> bytes) {
+            std::ranges::copy_n(this->memory.begin() + (address - BASE),
+                                bytes.size(), bytes.begin());
+            this->reads++;
+        }
+
+        [[nodiscard]] constexpr bool isMapped(u32 address, u32 size) const {
+            return address >= BASE && size <= this->memory.size()
+                   && address - BASE <= this->memory.size() - size;
+        }
+
+        constexpr void invalidateCode(u32 address, u32 size) {
+            this->flushAddress = address;
+            this->flushSize    = size;
+            this->invalidations++;
+        }
+
+        constexpr void invalidateData(u32 address, u32 size) {
+            this->invalidateCode(address, size);
+        }
+
+        [[nodiscard]] constexpr u32 word(u32 address) const {
+            std::array<u8, 4> bytes = {};
+            std::ranges::copy_n(this->memory.begin() + (address - BASE), 4,
+                                bytes.begin());
+
+            return std::bit_cast<u32>(bytes);
+        }
+    };
+
+    static_assert(PatchMemory<CountingPatchMemory>);
+
+    static_assert(JournaledPatchMemory<CountingPatchMemory>);
+
+    /// A region of made up addresses, for checking arenas off the console.
+    struct SimulatedCodeRegion {
+        static constexpr u32 BASE = 0x10000000;
+
+        u32    limit    = 4 * CODE_ARENA_SLAB_SIZE;
+        u32    next     = 0;
+        size_t reserves = 0;
+        size_t releases = 0;
+
+        [[nodiscard]] constexpr std::optional<u32> reserve(u32 size,
+                                                           u32 alignment) {
+            const u32 start = (this->next + alignment - 1) & ~(alignment - 1);
+            if (start > this->limit || this->limit - start < size)
+                return std::nullopt;
+
+            this->next = start + size;
+            this->reserves++;
+
+            return BASE + start;
+        }
+
+        constexpr void release([[maybe_unused]] u32 address,
+                               [[maybe_unused]] u32 size) {
+            this->releases++;
+        }
+    };
+
+    static_assert(CodeRegion<SimulatedCodeRegion>);
+} // namespace LibMacchiato
@@ -0,0 +1,686 @@
+/*
+ * libmacchiato - Front-end for the Macchiato modding environment
+ * Copyright (C) 2024 splatoon1enjoyer @ SDL Foundation
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Host test of the patch machinery that does not touch the console. What
+// is `constexpr` is checked with `static_assert` when this file compiles,
+// the rest when it runs: where stubs are placed and the jumps that reach
+// them.
+
+#include "PatchFixtures.h"
+
+#include "LibMacchiato/Assembler/Emitter.h"
+#include "LibMacchiato/Assembler/Literal.h"
+#include "LibMacchiato/Assembler/Peephole.h"
+#include "LibMacchiato/Assembler/Relocation.h"
+#include "LibMacchiato/Patch/Batch.h"
+#include "LibMacchiato/Patch/CodeArena.h"
+#include "LibMacchiato/Patch/Index.h"
+#include "LibMacchiato/Patch/Snapshot.h"
+#include "LibMacchiato/Patch/Transaction.h"
+
+#include <sdl-utils/Types.h>
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdio>
+#include <expected>
+#include <optional>
+#include <vector>
+
+namespace LibMacchiato::PPCAssembler {
+    // A call and a conditional branch out of reach get long forms, a branch
+    // between the displaced instructions follows its target.
+    static_assert([] {
+        using namespace Literals;
+
+        constexpr u32 HOOK = 0x02000000;
+
+        const std::array<u32, 4> displaced = {
+            "bl 0x100000"_ppc,
+            "beq cr0, 0x8"_ppc,
+            "bne cr0, 0x100"_ppc,
+            "li r3, 0"_ppc,
+        };
+
+        std::array<u32, 16> code = {};
+        Emitter             emitter(code, 0x10000000);
+
+        const std::expected<size_t, AssembleError> size = relocate(
+            emitter, DisplacedCode{.address = HOOK, .code = displaced});
+
+        return size == 11 && code[0] == "lis r11, 0x210"_ppc
+               && code[2] == "bctrl"_ppc && code[3] == "beq cr0, 0x1C"_ppc
+               && code[4] == "bne cr0, 0x8"_ppc && code[5] == "b 0x14"_ppc
+               && code[6] == "lis r11, 0x200"_ppc
+               && code[7] == "ori r11, r11, 0x108"_ppc
+               && code[9] == "bctr"_ppc && code[10] == "li r3, 0"_ppc;
+    }());
+
+    // Close enough, branches keep their form with a new displacement.
+    static_assert([] {
+        using namespace Literals;
+
+        const std::array<u32, 2> displaced = {
+            "bl 0x100"_ppc,
+            "blt cr1, 0x200"_ppc,
+        };
+
+        std::array<u32, 4> code = {};
+        Emitter            emitter(code, 0x1100);
+
+        const std::expected<size_t, AssembleError> size = relocate(
+            emitter, DisplacedCode{.address = 0x1000, .code = displaced});
+
+        return size == 2 && code[0] == "bl 0x0"_ppc
+               && code[1] == "blt cr1, 0x100"_ppc;
+    }());
+
+    static_assert([] {
+        using namespace Literals;
+
+        const std::array<u32, 4> displaced = {};
+        const std::array<u32, 3> following = {
+            "b -0x10"_ppc,
+            "nop"_ppc,
+            "beq cr0, -0xC"_ppc,
+        };
+
+        const std::optional<RelocationError> error = findBranchInto(
+            DisplacedCode{.address = 0x1000, .code = displaced}, 0x1010,
+            following);
+
+        return error.has_value() && error->branch == 0x1018
+               && error->target == 0x100C;
+    }());
+
+    static_assert([] {
+        using namespace Literals;
+
+        // The tail of a trampoline at 0x01000000 back into a function.
+        std::vector<u32> code = {
+            "mflr r0"_ppc,   "lis r3, 0"_ppc,  "ori r3, r3, 0x10"_ppc,
+            "lis r11, 0x0100"_ppc,     "ori r11, r11, 0x1000"_ppc,
+            "mtctr r11"_ppc, "bctr"_ppc};
+
+        const PeepholeStats stats = optimizeSequence(code, 0x01000000);
+
+        return stats.wordsSaved == 4 && stats.foldedLoads == 1
+               && stats.shortenedJumps == 1 && code.size() == 3
+               && code[0] == "mflr r0"_ppc && code[1] == "li r3, 0x10"_ppc
+               && code[2] == "b 0xff8"_ppc;
+    }());
+
+    static_assert([] {
+        using namespace Literals;
+
+        // Out of range of `b` and `ba`, but the address loads with `lis`.
+        std::vector<u32> code = {
+            "lis r11, 0x8000"_ppc, "ori r11, r11, 0"_ppc, "mtctr r11"_ppc,
+            "bctrl"_ppc,           "lis r4, 0xffff"_ppc,
+            "ori r4, r4, 0x8000"_ppc};
+
+        const PeepholeStats stats = optimizeSequence(code, 0x01000000);
+
+        return stats.wordsSaved == 2 && stats.shortenedJumps == 1
+               && code.size() == 4 && code[0] == "lis r11, 0x8000"_ppc
+               && code[1] == "mtctr r11"_ppc && code[2] == "bctrl"_ppc
+               && code[3] == "li r4, -0x8000"_ppc;
+    }());
+
+    static_assert([] {
+        using namespace Literals;
+
+        std::vector<u32> code = {"mtctr r12"_ppc, "stw r0, 4(r1)"_ppc,
+                                 "mtctr r12"_ppc, "bctrl"_ppc,
+                                 "mtctr r12"_ppc, "addi r12, r12, 4"_ppc,
+                                 "mtctr r12"_ppc, "bctr"_ppc};
+
+        const PeepholeStats stats = optimizeSequence(code, 0x1000);
+
+        return stats.wordsSaved == 1 && stats.removedCtrLoads == 1
+               && code.size() == 7 && code[2] == "bctrl"_ppc
+               && code[3] == "mtctr r12"_ppc && code[5] == "mtctr r12"_ppc;
+    }());
+
+    static_assert([] {
+        using namespace Literals;
+
+        // Branches within the sequence follow their target, branches out of
+        // it keep theirs.
+        std::vector<u32> code = {"beq 0x10"_ppc,   "lis r3, 0"_ppc,
+                                 "ori r3, r3, 1"_ppc, "b -0x1000"_ppc,
+                                 "blr"_ppc};
+
+        const PeepholeStats stats = optimizeSequence(code, 0x2000);
+
+        return stats.wordsSaved == 1 && code.size() == 4
+               && code[0] == "beq 0xc"_ppc && code[1] == "li r3, 1"_ppc
+               && code[2] == "b -0xffc"_ppc && code[3] == "blr"_ppc;
+    }());
+
+    static_assert([] {
+        using namespace Literals;
+
+        // The `ori` is branched to, and `bcl` is unknown to the table.
+        std::vector<u32> branchedTo = {"lis r3, 0"_ppc, "ori r3, r3, 1"_ppc,
+                                       "b -4"_ppc};
+        std::vector<u32> unknown    = {"lis r3, 0"_ppc, "ori r3, r3, 1"_ppc,
+                                       0x42800005};
+
+        return optimizeSequence(branchedTo, 0x1000).wordsSaved == 0
+               && branchedTo.size() == 3
+               && optimizeSequence(unknown, 0x1000).wordsSaved == 0
+               && unknown.size() == 3;
+    }());
+} // namespace LibMacchiato::PPCAssembler
+
+namespace LibMacchiato {
+    // A long jump written out of order is one copy and one flush of the
+    // cache lines it touches.
+    static_assert([] {
+        constexpr u32 HOOK = CountingPatchMemory::BASE + 0x1C;
+
+        CountingPatchMemory memory = {};
+        PatchBatch          batch  = {};
+
+        batch.writeWord(HOOK + 8, 0x7D6903A6);
+        batch.writeWord(HOOK, 0x3D608000);
+        batch.writeWord(HOOK + 12, 0x4E800420);
+        batch.writeWord(HOOK + 4, 0x616B1234);
+
+        const PatchCommitStats stats = batch.commit(memory);
+
+        return stats.writes == 4 && stats.runs == 1 && memory.copies == 1
+               && memory.invalidations == 1
+               && memory.flushAddress == CountingPatchMemory::BASE
+               && memory.flushSize == 2 * PATCH_CACHE_LINE_SIZE
+               && memory.word(HOOK) == 0x3D608000
+               && memory.word(HOOK + 12) == 0x4E800420 && batch.empty();
+    }());
+
+    // The last write of a word wins, gaps, targets and pages split runs.
+    static_assert([] {
+        constexpr u32 BASE = CountingPatchMemory::BASE;
+
+        CountingPatchMemory memory = {};
+        PatchBatch          batch  = {};
+
+        batch.writeWord(BASE, 0x60000000);
+        batch.writeWord(BASE, 0x4E800020);
+        batch.writeWord(BASE + 8, 0x60000000);
+        batch.writeData<u16>(BASE + 12, 0xFFFF);
+        batch.writeWord(BASE + 0x3C, 0x60000000);
+        batch.writeWord(BASE + 0x40, 0x60000000);
+
+        const PatchCommitStats stats = batch.commit(memory);
+
+        return stats.writes == 6 && stats.runs == 5 && memory.copies == 5
+               && memory.word(BASE) == 0x4E800020;
+    }());
+
+    // Overlapping data, the later write wins even at a lower address.
+    static_assert([] {
+        constexpr u32 BASE = CountingPatchMemory::BASE;
+
+        CountingPatchMemory memory = {};
+        PatchBatch          batch  = {};
+
+        batch.writeData<u8>(BASE + 1, 0xAA);
+        batch.writeData<u32>(BASE, 0x11223344);
+
+        const PatchCommitStats stats = batch.commit(memory);
+
+        return stats.runs == 1 && memory.word(BASE) == 0x11223344;
+    }());
+
+    // Covering a hook and the lines after it is a single read.
+    static_assert([] {
+        constexpr u32 BASE = CountingPatchMemory::BASE;
+
+        CountingPatchMemory memory = {};
+        for (size_t i = 0; i < memory.memory.size(); i++)
+            memory.memory[i] = static_cast<u8>(i);
+
+        OriginalSnapshot snapshot = {};
+        snapshot.cover(BASE + 8, 16);
+        snapshot.cover(BASE + 4, 4);
+        snapshot.cover(BASE + 24, 4);
+        snapshot.cover(BASE + 12, 4);
+        snapshot.cover(BASE + 0x40, 2);
+        snapshot.cover(BASE + 0x100, 4);
+        snapshot.capture(memory);
+
+        return memory.reads == 2 && snapshot.size() == 2
+               && snapshot.word(BASE + 4) == memory.word(BASE + 4)
+               && snapshot.word(BASE + 24) == memory.word(BASE + 24)
+               && !snapshot.word(BASE + 0x40).has_value()
+               && !snapshot.word(BASE + 0x100).has_value();
+    }());
+
+    static_assert([] {
+        const std::vector<PatchRun> runs = {
+            PatchRun{.address = 0x1002, .bytes = {1, 2, 3, 4, 5, 6, 7, 8}}};
+
+        const std::vector<PatchWrite> words = splitIntoWords(runs);
+
+        return words.size() == 3 && words[0].size == 2 && words[1].size == 4
+               && words[1].address == 0x1004 && words[1].bytes[0] == 3
+               && words[2].size == 2;
+    }());
+
+    // Identical words are written once and restored by the last owner,
+    // different ones conflict.
+    static_assert([] {
+        constexpr u32 BASE = CountingPatchMemory::BASE;
+
+        CountingPatchMemory memory = {};
+        memory.memory.fill(0x11);
+
+        PatchIndex index = {};
+
+        PatchBatch first = {};
+        first.writeWord(BASE, 0x60000000);
+
+        PatchBatch second = {};
+        second.writeWord(BASE, 0x60000000);
+        second.writeWord(BASE + 4, 0x4E800020);
+
+        PatchBatch third = {};
+        third.writeData<u8>(BASE + 8, 0xAA);
+        third.writeWord(BASE + 4, 0x60000000);
+
+        const PatchClaim firstClaim =
+            index.claim(first.writes, memory).value();
+        const PatchClaim secondClaim =
+            index.claim(second.writes, memory).value();
+        const PatchWriteError conflict =
+            index.claim(third.writes, memory).error();
+
+        const bool claimed = firstClaim.writes.size() == 1
+                             && secondClaim.writes.size() == 1
+                             && secondClaim.writes[0].address == BASE + 4
+                             && conflict.code == PatchWriteErrorCode::Conflict
+                             && conflict.address == BASE + 4
+                             && index.size() == 2;
+
+        const bool shared = index.release(firstClaim.addresses).empty();
+
+        const std::vector<PatchWrite> restores =
+            index.release(secondClaim.addresses);
+
+        return claimed && shared && restores.size() == 2
+               && restores[0].bytes[0] == 0x11 && index.size() == 0;
+    }());
+
+    // The originals of contiguous new words are read with one copy, the
+    // words another patch already owns are not read again.
+    static_assert([] {
+        constexpr u32 BASE = CountingPatchMemory::BASE;
+
+        CountingPatchMemory memory = {};
+        for (size_t i = 0; i < memory.memory.size(); i++)
+            memory.memory[i] = static_cast<u8>(i);
+
+        PatchIndex index = {};
+
+        PatchBatch first = {};
+        first.writeWord(BASE + 8, 0x60000000);
+
+        PatchBatch second = {};
+        for (u32 i = 0; i < 16; i++)
+            second.writeWord(BASE + i * 4, 0x60000000);
+
+        const bool firstClaimed = index.claim(first.writes, memory).has_value();
+        memory.reads            = 0;
+
+        const PatchClaim secondClaim =
+            index.claim(second.writes, memory).value();
+
+        const std::vector<PatchWrite> restores =
+            index.release(secondClaim.addresses);
+
+        return firstClaimed && memory.reads == 2
+               && secondClaim.writes.size() == 15 && index.size() == 1
+               && restores.size() == 15
+               && std::bit_cast<u32>(restores[2].bytes)
+                      == memory.word(BASE + 12);
+    }());
+
+    // Conflicts are found without claiming anything.
+    static_assert([] {
+        constexpr u32 BASE = CountingPatchMemory::BASE;
+
+        CountingPatchMemory memory = {};
+        PatchIndex          index  = {};
+
+        PatchBatch owned = {};
+        owned.writeWord(BASE + 4, 0x60000000);
+
+        PatchBatch hook = {};
+        hook.writeWord(BASE, 0x48000010);
+        hook.writeWord(BASE + 4, 0x60000000);
+
+        const bool shared =
+            index.claim(owned.writes, memory).has_value()
+            && !index.findConflict(hook.writes).has_value();
+
+        hook.writeWord(BASE + 4, 0x4E800020);
+
+        const std::optional<PatchWriteError> conflict =
+            index.findConflict(hook.writes);
+
+        return shared && conflict.has_value()
+               && conflict->address == BASE + 4 && index.size() == 1;
+    }());
+
+    // Sixteen contiguous words are a single read.
+    static_assert([] {
+        CountingPatchMemory memory = {};
+
+        PatchBatch batch = {};
+        for (u32 i = 0; i < 16; i++)
+            batch.writeWord(CountingPatchMemory::BASE + i * 4, 0x60000000);
+
+        PatchIndex index = {};
+        const PatchClaim claim = index.claim(batch.writes, memory).value();
+
+        return memory.reads == 1 && claim.writes.size() == 16
+               && index.size() == 16;
+    }());
+
+    // The originals a patch captured are neither read again by the index
+    // nor by the transaction, which only reads back what it wrote.
+    static_assert([] {
+        constexpr u32 BASE = CountingPatchMemory::BASE;
+
+        CountingPatchMemory memory = {};
+        for (size_t i = 0; i < memory.memory.size(); i++)
+            memory.memory[i] = static_cast<u8>(i);
+
+        const u32 first = memory.word(BASE);
+        const u32 last  = memory.word(BASE + 60);
+
+        OriginalSnapshot originals = {};
+        originals.cover(BASE, 8);
+        originals.capture(memory);
+
+        PatchBatch batch = {};
+        for (u32 i = 0; i < 16; i++)
+            batch.writeWord(BASE + i * 4, 0x60000000);
+
+        PatchIndex       index = {};
+        const PatchClaim claim =
+            index.claim(batch.writes, originals, memory).value();
+
+        const bool claimed = memory.reads == 2 && originals.size() == 1;
+
+        batch.writes = claim.writes;
+        std::expected<PatchJournal, PatchWriteError> journal =
+            commitTransaction(batch, originals, memory);
+
+        const bool committed = journal.has_value() && memory.reads == 3
+                               && memory.word(BASE + 60) == 0x60000000;
+
+        journal->restore(memory);
+
+        return claimed && committed && memory.word(BASE) == first
+               && memory.word(BASE + 60) == last;
+    }());
+
+    // A transaction is undone by its journal, one copy per run.
+    static_assert([] {
+        constexpr u32 BASE = CountingPatchMemory::BASE;
+
+        CountingPatchMemory memory = {};
+        memory.memory.fill(0x11);
+
+        PatchBatch batch = {};
+        batch.writeWord(BASE, 0x60000000);
+        batch.writeWord(BASE + 4, 0x60000000);
+        batch.writeWord(BASE + 0x20, 0x4E800020);
+
+        std::expected<PatchJournal, PatchWriteError> journal =
+            commitTransaction(batch, memory);
+        if (!journal.has_value() || journal->runs.size() != 2
+            || memory.word(BASE + 4) != 0x60000000)
+            return false;
+
+        journal->restore(memory);
+
+        return memory.copies == 4 && memory.word(BASE) == 0x11111111
+               && memory.word(BASE + 0x20) == 0x11111111;
+    }());
+
+    // Nothing is written when a run is invalid, and a write that does not
+    // stick rolls back the runs before it.
+    static_assert([] {
+        constexpr u32 BASE = CountingPatchMemory::BASE;
+
+        CountingPatchMemory memory = {};
+
+        PatchBatch batch = {};
+        batch.writeWord(BASE, 0x60000000);
+        batch.writeWord(BASE + 0x100, 0x60000000);
+
+        const bool unmapped =
+            commitTransaction(batch, memory).error().code
+                == PatchWriteErrorCode::UnmappedAddress
+            && memory.copies == 0;
+
+        batch.writeWord(BASE + 2, 0x60000000);
+
+        const bool unaligned = commitTransaction(batch, memory).error().code
+                                   == PatchWriteErrorCode::UnalignedCode
+                               && memory.copies == 0;
+
+        memory.readOnlyAddress = BASE + 0x24;
+        batch.writeWord(BASE, 0x60000000);
+        batch.writeWord(BASE + 0x24, 0x60000000);
+
+        const PatchWriteError error = commitTransaction(batch, memory).error();
+
+        return unmapped && unaligned
+               && error.code == PatchWriteErrorCode::WriteFailed
+               && error.address == BASE + 0x24 && memory.word(BASE) == 0;
+    }());
+
+    // Stubs are packed into one slab on cache lines, until it is full.
+    static_assert([] {
+        BasicCodePool<SimulatedCodeRegion>  pool;
+        BasicCodeArena<SimulatedCodeRegion> arena(pool);
+
+        const u32 first  = arena.allocate(5 * sizeof(u32)).value();
+        const u32 second = arena.allocate(16 * sizeof(u32)).value();
+
+        const bool packed = first == SimulatedCodeRegion::BASE
+                            && second == first + PATCH_CACHE_LINE_SIZE
+                            && pool.stats().usedBytes
+                                   == 3 * PATCH_CACHE_LINE_SIZE;
+
+        const u32 third = arena.allocate(CODE_ARENA_SLAB_SIZE).value();
+
+        const CodePoolStats stats = pool.stats();
+
+        const bool placed =
+            packed && third == first + CODE_ARENA_SLAB_SIZE
+            && stats.slabs == 2 && arena.size() == 3
+            && stats.reservedBytes == 2 * CODE_ARENA_SLAB_SIZE
+            && arena.contains(second) && !arena.contains(third - 4);
+
+        arena.release();
+        return placed;
+    }());
+
+    // Arenas share the slabs of their pool. Shrunk and released bytes are
+    // reused, a slab goes back to the region once both arenas are done with
+    // it, and a full region fails the allocation.
+    static_assert([] {
+        BasicCodePool<SimulatedCodeRegion> pool(
+            SimulatedCodeRegion{.limit = CODE_ARENA_SLAB_SIZE});
+        BasicCodeArena<SimulatedCodeRegion> first(pool);
+        BasicCodeArena<SimulatedCodeRegion> second(pool);
+
+        const u32 a = first.allocate(64).value();
+        const u32 b = second.allocate(16 * sizeof(u32)).value();
+
+        first.shrink(a, 0);
+        second.shrink(b, 3 * sizeof(u32));
+
+        const bool shrunk = pool.stats().slabs == 1
+                            && pool.stats().usedBytes == PATCH_CACHE_LINE_SIZE
+                            && first.size() == 0 && second.size() == 1
+                            && first.allocate(4).value() == a
+                            && first.allocate(64).value() == b + 32;
+
+        const bool full = !second.allocate(2 * CODE_ARENA_SLAB_SIZE);
+
+        first.release();
+
+        const bool kept = pool.stats().slabs == 1 && second.contains(b)
+                          && pool.getRegion().releases == 0;
+
+        second.release();
+
+        return shrunk && full && kept && pool.stats().slabs == 0
+               && pool.getRegion().releases == 1;
+    }());
+
+    // Near stubs come from a cave or a slab in range of a `b`, the rest only
+    // from the region. Caves are handed out once, whichever arena asks.
+    static_assert([] {
+        constexpr u32 CAVE = 0x01800010;
+        constexpr u32 TEXT = 0x02000000;
+
+        BasicCodePool<SimulatedCodeRegion> pool;
+        pool.addCave(CAVE, 0x1000);
+
+        BasicCodeArena<SimulatedCodeRegion> first(pool);
+        BasicCodeArena<SimulatedCodeRegion> second(pool);
+
+        const u32 far   = first.allocate(64).value();
+        const u32 near  = first.allocateNear(TEXT, 64).value();
+        const u32 other = second.allocateNear(TEXT, 64).value();
+
+        const bool placed =
+            far == SimulatedCodeRegion::BASE && near == CAVE + 0x10
+            && other == near + 64
+            && !first.allocateNear(TEXT + 0x8000000, 64).has_value()
+            && second.allocateNear(far + 0x100000, 32).value() == far + 64
+            && pool.stats().caveBytes == 0xFE0;
+
+        first.release();
+
+        const bool reused = second.allocateNear(TEXT, 4).value() == near;
+
+        second.release();
+
+        return placed && reused && pool.stats().slabs == 0
+               && pool.stats().usedBytes == 0;
+    }());
+} // namespace LibMacchiato
+
+using namespace LibMacchiato;
+
+namespace {
+    using SimulatedPool  = BasicCodePool<SimulatedCodeRegion>;
+    using SimulatedArena = BasicCodeArena<SimulatedCodeRegion>;
+
+    // A cave in the text of the module, below that of the title.
+    constexpr u32 CAVE = 0x01800000;
+    constexpr u32 TEXT = 0x02000000;
+
+    // Words of a trampoline stub, enough for any displaced instructions.
+    constexpr u32 STUB_SIZE = 24 * sizeof(u32);
+
+    // Words of the hook at `address` that jumps to `stub`.
+    size_t hookSize(u32 address, u32 stub) {
+        // The longest jump is `lis/ori/mtctr/bctr`.
+        std::array<u32, 4>    code = {};
+        PPCAssembler::Emitter emitter(code, address);
+        emitter.jmp(stub);
+
+        const size_t size = emitter.finish().value();
+
+        // A single `b`, without the absolute or link bits.
+        if (size == 1 && (code[0] & 0xFC000003) != 0x48000000)
+            return 0;
+
+        return size;
+    }
+
+    // Hooks of two patches share the cave of the pool: both are a single
+    // `b` into stubs of their own.
+    bool checkHooksInCave() {
+        SimulatedPool pool;
+        pool.addCave(CAVE, 0x1000);
+
+        SimulatedArena first(pool);
+        SimulatedArena second(pool);
+
+        const std::optional<u32> a = first.allocateNear(TEXT, STUB_SIZE);
+        const std::optional<u32> b =
+            second.allocateNear(TEXT + 0x40000, STUB_SIZE);
+
+        bool passed = a.has_value() && b.has_value()
+                      && (a.value() + STUB_SIZE <= b.value()
+                          || b.value() + STUB_SIZE <= a.value())
+                      && hookSize(TEXT, a.value()) == 1
+                      && hookSize(TEXT + 0x40000, b.value()) == 1;
+
+        first.release();
+        second.release();
+
+        if (!passed)
+            std::printf("hooks in cave: not a single b\n");
+
+        return passed;
+    }
+
+    // Without a cave in reach the stub comes from the heap, and the hook
+    // takes the long jump.
+    bool checkHookOutOfReach() {
+        SimulatedPool  pool;
+        SimulatedArena arena(pool);
+
+        const std::optional<u32> stub =
+            arena.allocateNear(TEXT, STUB_SIZE).or_else([&] {
+                return arena.allocate(STUB_SIZE);
+            });
+
+        const bool passed =
+            stub.has_value() && hookSize(TEXT, stub.value()) > 1;
+
+        arena.release();
+
+        if (!passed)
+            std::printf("hook out of reach: not a long jump\n");
+
+        return passed;
+    }
+} // namespace
+
+int main() {
+    size_t failed = 0;
+
+    failed += checkHooksInCave() ? 0 : 1;
+    failed += checkHookOutOfReach() ? 0 : 1;
+
+    std::printf("%zu of 2 patch cases failed\n", failed);
+
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+/*
+ * libmacchiato - Front-end for the Macchiato modding environment
+ * Copyright (C) 2024 splatoon1enjoyer @ SDL Foundation
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Host stress test of the sharded assembly memo. Many threads assemble the
+// same distinct instructions in different orders, while another one clears
+// and toggles the memo, and every result has to match single-threaded
+// `assembleView`. Build it with `-fsanitize=thread` to also catch races that
+// happen to produce the right words.
+
+#include "LibMacchiato/Assembler.h"
+
+#include <sdl-utils/Types.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <expected>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace LibMacchiato::PPCAssembler;
+
+namespace {
+    constexpr size_t THREAD_NUM = 16;
+    constexpr size_t ROUND_NUM  = 20;
+
+    // More than the memo holds, so that threads also race on evictions.
+    constexpr size_t INSTRUCTION_NUM = 6000;
+
+    // Instructions assembled again after every other one, which stay in the
+    // memo so that threads also race on hits.
+    constexpr size_t HOT_NUM = 64;
+
+    std::string gpr(u32 reg) { return "r" + std::to_string(reg); }
+
+    std::vector<std::string> instructions() {
+        constexpr std::array MNEMONICS = {"addi", "lwz", "stw", "ori",
+                                          "cmpwi", "fadd", "beq", "rlwinm"};
+
+        std::mt19937             random(INSTRUCTION_NUM);
+        std::vector<std::string> lines = {};
+
+        while (lines.size() < INSTRUCTION_NUM) {
+            const std::string mnemonic = MNEMONICS[lines.size() % 8];
+            const std::string dst      = gpr(random() % 32);
+            const std::string src      = gpr(random() % 32);
+            const std::string value    = std::to_string(random() % 0x1000);
+
+            if (mnemonic == "lwz" || mnemonic == "stw")
+                lines.push_back(mnemonic + " " + dst + ", " + value + "("
+                                + src + ")");
+            else if (mnemonic == "cmpwi")
+                lines.push_back("cmpwi cr" + std::to_string(random() % 8)
+                                + ", " + src + ", " + value);
+            else if (mnemonic == "fadd")
+                lines.push_back("fadd f" + std::to_string(random() % 32)
+                                + ", f" + std::to_string(random() % 32)
+                                + ", f" + std::to_string(random() % 32));
+            else if (mnemonic == "beq")
+                lines.push_back("beq cr" + std::to_string(random() % 8) + ", "
+                                + std::to_string(random() % 0x1000 * 4));
+            else if (mnemonic == "rlwinm")
+                lines.push_back("rlwinm " + dst + ", " + src + ", "
+                                + std::to_string(random() % 32) + ", 0, 31");
+            else
+                lines.push_back(mnemonic + " " + dst + ", " + src + ", "
+                                + value);
+        }
+
+        return lines;
+    }
+} // namespace
+
+int main() {
+    const std::vector<std::string> lines = instructions();
+
+    std::vector<u32> expected = {};
+    for (const auto& line : lines) {
+        std::expected<u32, AssembleError> code = assembleView(line);
+        if (!code.has_value()) {
+            std::printf("\"%s\" does not assemble: %s\n", line.c_str(),
+                        assembleErrorToStr(code.error(), line).c_str());
+            return 1;
+        }
+
+        expected.push_back(code.value());
+    }
+
+    std::atomic<size_t> mismatches = 0;
+    std::atomic<bool>   done       = false;
+
+    std::vector<std::thread> threads = {};
+    for (size_t t = 0; t < THREAD_NUM; t++) {
+        threads.emplace_back([&, t] {
+            std::vector<size_t> order(lines.size());
+            for (size_t i = 0; i < order.size(); i++)
+                order[i] = i;
+
+            std::mt19937 random(static_cast<u32>(t));
+
+            for (size_t round = 0; round < ROUND_NUM; round++) {
+                std::ranges::shuffle(order, random);
+
+                for (const size_t i : order) {
+                    const size_t hot = i % HOT_NUM;
+
+                    if (assemble(lines[i]) != expected[i]
+                        || assemble(lines[hot]) != expected[hot])
+                        mismatches.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+
+    // Clearing and switching the memo off must not break lookups that are
+    // in flight.
+    std::thread toggler([&] {
+        for (size_t i = 0; !done.load(std::memory_order_relaxed); i++) {
+            if (i % 4096 == 0)
+                clearAssemblyMemo();
+
+            setAssemblyMemoEnabled(i % 256 != 0);
+            std::this_thread::yield();
+        }
+
+        setAssemblyMemoEnabled(true);
+    });
+
+    for (auto& thread : threads)
+        thread.join();
+
+    done.store(true, std::memory_order_relaxed);
+    toggler.join();
+
+    const AssemblyMemoStats stats = getAssemblyMemoStats();
+    std::printf("%zu threads x %zu rounds x %zu instructions, %zu memo hits, "
+                "%zu mismatches\n",
+                THREAD_NUM, ROUND_NUM, lines.size(), stats.hits,
+                mismatches.load());
+
+    return mismatches.load() == 0 ? 0 : 1;
+}
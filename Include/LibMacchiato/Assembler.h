@@ -17,14 +17,24 @@
 
 #pragma once
 
+#include "Assembler/Block.h"
+#include "Assembler/Cache.h"
+#include "Assembler/Codegen.h"
+#include "Assembler/Disassembler.h"
+#include "Assembler/Emitter.h"
 #include "Assembler/Error.h"
 #include "Assembler/Instruction.h"
 #include "Assembler/InstructionDef.h"
 #include "Assembler/InstructionDefTable.h"
+#include "Assembler/Lexer.h"
+#include "Assembler/Literal.h"
 #include "Assembler/Mask.h"
+#include "Assembler/MnemonicTable.h"
 #include "Assembler/Operand.h"
 #include "Assembler/OperandDef.h"
 #include "Assembler/PPCData.h"
+#include "Assembler/Peephole.h"
+#include "Assembler/Range.h"
 
 #include <sdl-utils/Types.h>
 
@@ -34,6 +44,19 @@
 #include <variant>
 
 namespace LibMacchiato::PPCAssembler {
+    struct AssemblyMemoStats {
+        size_t hits      = 0;
+        size_t misses    = 0;
+        size_t size      = 0;
+        size_t capacity  = 0;
+        size_t evictions = 0;
+    };
+
     [[nodiscard]] std::expected<u32, AssembleError>
     assemble(const std::string& instructionStr);
-}
+
+    [[nodiscard]] AssemblyMemoStats getAssemblyMemoStats();
+
+    void setAssemblyMemoEnabled(bool enabled);
+    void clearAssemblyMemo();
+} // namespace LibMacchiato::PPCAssembler
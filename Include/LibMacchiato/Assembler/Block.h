@@ -0,0 +1,80 @@
+/*
+ * libmacchiato - Front-end for the Macchiato modding environment
+ * Copyright (C) 2024 splatoon1enjoyer @ SDL Foundation
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "Error.h"
+
+#include <sdl-utils/Types.h>
+
+#include <cstddef>
+#include <expected>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace LibMacchiato::PPCAssembler {
+    /// Absolute addresses outside of a block that it can refer to by name,
+    /// e.g. from `ELF::findExportedFunctionVirtualAddress`.
+    typedef std::map<std::string, u32, std::less<>> SymbolTable;
+
+    /*
+     * @brief Assembles a whole snippet into one contiguous buffer that is
+     * meant to be placed at `address`. Every line holds at most one label,
+     * instruction or directive, and `#` or `;` start a comment.
+     *
+     * loop:
+     *     lwz r4, 0(r3)
+     *     addi r3, r3, 4
+     *     b loop             ; labels resolve to relative branches
+     *     bl someSymbol      ; `lis/ori/mtctr/bctrl` through r11 if too far
+     *     beq cr1, someSymbol  ; `bne cr1, 8` over a `b` if too far
+     *     li32 r3, 0x12345678  ; `li`, `lis` or `lis/ori`
+     *     la r4, value       ; `li32` with the address of a label or symbol
+     *     call 0x02001000    ; `bl`, `bla` or through the count register
+     *     lis r5, someSymbol@ha
+     *     lwz r5, someSymbol@l(r5)
+     *     li r6, (end - value) / 4
+     * value:
+     *     .long 0x12345678   ; also accepts labels and symbols
+     *     .float 1.5
+     *     .align 3           ; pads with `nop` up to 2^3 bytes
+     * end:
+     *
+     * Every integer can be an expression over labels and symbols (see
+     * `ExpressionParser`), such as `someSymbol+0x10` or `value@l`.
+     *
+     * `b`, `ba` and `bl` to a symbol use the short form whenever the target
+     * is in range from their final address, then `ba` or `bla`, and fall back
+     * to the long form otherwise, which clobbers r11 and the count register.
+     * `jmp` and `call` are `b` and `bl` that also take absolute addresses,
+     * and only exist in blocks like `li32` and `la`. The simplified
+     * conditional branches (`beq`, `bne`, `blt`, `bge`, `bgt`, `ble`) step
+     * over such a branch with the inverted condition instead, `bc` is never
+     * relaxed.
+     */
+    [[nodiscard]] std::expected<std::vector<u32>, BlockError>
+    assembleBlock(std::string_view source, u32 address,
+                  const SymbolTable& symbols = {});
+
+    /// Upper bound of the size in bytes of `source` once assembled at any
+    /// address, for allocating the memory a block gets placed in.
+    [[nodiscard]] std::expected<size_t, BlockError>
+    measureBlock(std::string_view source, const SymbolTable& symbols = {});
+} // namespace LibMacchiato::PPCAssembler
@@ -0,0 +1,158 @@
+/*
+ * libmacchiato - Front-end for the Macchiato modding environment
+ * Copyright (C) 2024 splatoon1enjoyer @ SDL Foundation
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "InstructionDefTable.h"
+#include "Mnemonic.h"
+#include "PerfectHash.h"
+
+#include <sdl-utils/Types.h>
+
+#include <functional>
+#include <map>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace LibMacchiato::PPCAssembler {
+    constexpr u32 ASSEMBLY_CACHE_MAGIC          = 0x4D414341; // "MACA"
+    constexpr u32 ASSEMBLY_CACHE_FORMAT_VERSION = 1;
+
+    /// Bumped whenever a source assembles to other words while the tables
+    /// stay the same, e.g. a new expansion of `jmp`, `call` or `li32`, or
+    /// other branch relaxation.
+    constexpr u32 ASSEMBLER_ENCODER_VERSION = 1;
+
+    /// Changes with the instruction and mnemonic tables and the encoder
+    /// version, so that the caches of a plugin rebuilt against another
+    /// assembler are rejected even if no version was bumped by hand.
+    constexpr u64 ASSEMBLER_FINGERPRINT = [] {
+        u64  hash = hashString("");
+        auto fold = [&](u64 value) {
+            hash = (hash ^ value) * 0x100000001B3;
+        };
+
+        fold(ASSEMBLER_ENCODER_VERSION);
+
+        for (const auto& spec : MNEMONIC_SPECS) {
+            fold(hashString(spec.name));
+            fold(static_cast<u64>(spec.mnemonic));
+            fold(spec.opcode);
+        }
+
+        for (const auto& def : PPC_INSTRUCTION_TABLE) {
+            fold(static_cast<u64>(def.mnemonic));
+            fold(def.mask);
+
+            for (const auto& operand : def.operands) {
+                if (!operand.has_value()) {
+                    fold(0);
+                    continue;
+                }
+
+                fold(operand->pos + 1);
+                fold(operand->bits);
+                fold(operand->type.index());
+
+                if (const auto* direct =
+                        std::get_if<DirectOperandDefType>(&operand->type))
+                    fold(static_cast<u64>(direct->regType));
+                else if (const auto* indirect =
+                             std::get_if<IndirectOperandDefType>(
+                                 &operand->type)) {
+                    fold(indirect->offsetPos);
+                    fold(indirect->offsetBits);
+                } else if (const auto* immediate =
+                               std::get_if<ImmediateOperandDefType>(
+                                   &operand->type)) {
+                    fold(immediate->shift);
+                    fold(immediate->isSigned);
+                    fold(immediate->isSpr);
+                }
+            }
+        }
+
+        return hash;
+    }();
+
+    /*
+     * @brief Assembled words of every snippet a plugin assembled, keyed by
+     * their source so that they can be reused on the next boot. A cache only
+     * belongs to the build identified by `buildHash`, a cache of any other
+     * build is rejected when it gets deserialized.
+     *
+     * Keys of code placed on the heap change with every boot, so entries
+     * that were not used since the cache was loaded get evicted before it is
+     * saved, which bounds the cache by what one boot assembles.
+     *
+     * The serialized form is a header (magic, format version, build hash,
+     * entry count) followed by the entries (key size, word count, key, words)
+     * in native byte order.
+     */
+    struct AssemblyCache {
+        struct Entry {
+            std::vector<u32> words = {};
+
+            // Whether the entry was looked up or added since it was loaded.
+            bool used = false;
+        };
+
+        u64 buildHash = 0;
+
+        std::map<std::string, Entry, std::less<>> entries = {};
+
+        // Whether entries were added or evicted since the cache was loaded.
+        bool dirty = false;
+
+        /// Marks the entry of `key` as used.
+        [[nodiscard]] std::optional<std::span<const u32>>
+        find(std::string_view key);
+
+        void insert(std::string_view key, std::span<const u32> words);
+
+        /// Drops the entries that were not used since the cache was loaded.
+        void evictUnused();
+
+        [[nodiscard]] std::vector<u8> serialize() const;
+
+        [[nodiscard]] static std::optional<AssemblyCache>
+        deserialize(std::span<const u8> data, u64 buildHash);
+    };
+
+    /// Makes `assemble` and `assembleBlock` consult and fill `cache`.
+    void installAssemblyCache(AssemblyCache cache);
+
+    /// Removes the installed cache and hands it back, e.g. for saving it.
+    [[nodiscard]] std::optional<AssemblyCache> uninstallAssemblyCache();
+
+    /// Whether a cache is installed, so that callers can skip building keys
+    /// that nothing would look up.
+    [[nodiscard]] bool isAssemblyCacheInstalled();
+
+    [[nodiscard]] std::optional<std::vector<u32>>
+    findCachedAssembly(std::string_view key);
+
+    /// `findCachedAssembly` for single instructions, without allocating.
+    [[nodiscard]] std::optional<u32>
+    findCachedInstruction(std::string_view key);
+
+    void cacheAssembly(std::string_view key, std::span<const u32> words);
+} // namespace LibMacchiato::PPCAssembler
@@ -0,0 +1,260 @@
+/*
+ * libmacchiato - Front-end for the Macchiato modding environment
+ * Copyright (C) 2024 splatoon1enjoyer @ SDL Foundation
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "Error.h"
+#include "Instruction.h"
+#include "InstructionDef.h"
+#include "InstructionDefTable.h"
+#include "Lexer.h"
+#include "Mnemonic.h"
+#include "MnemonicTable.h"
+#include "Operand.h"
+#include "OperandDef.h"
+#include "Register.h"
+
+#include <sdl-utils/Types.h>
+
+#include <bit>
+#include <cstddef>
+#include <expected>
+#include <optional>
+#include <string_view>
+#include <variant>
+
+// The assembler is `constexpr` so that it can be shared between runtime
+// assembly and compile-time literals (see `Literal.h`).
+namespace LibMacchiato::PPCAssembler {
+    constexpr u32 generateMask(size_t bitWidth) {
+        return bitWidth >= 32 ? 0xFFFFFFFF
+                              : (1U << static_cast<u32>(bitWidth)) - 1;
+    }
+
+    /// Whether `value` fits into a field of `bits` bits as a sign-extended
+    /// two's complement integer.
+    constexpr bool fitsInSignedBits(u32 value, size_t bits) {
+        if (bits >= 32)
+            return true;
+
+        const s32 signedValue = static_cast<s32>(value);
+        const s32 min         = -(s32{1} << (bits - 1));
+        const s32 max         = (s32{1} << (bits - 1)) - 1;
+
+        return signedValue >= min && signedValue <= max;
+    }
+
+    /// Whether `value` fits into a field of `bits` bits, either as an unsigned
+    /// integer or as a sign-extended two's complement integer.
+    constexpr bool fitsInBits(u32 value, size_t bits) {
+        if (bits >= 32)
+            return true;
+
+        if (static_cast<size_t>(std::bit_width(value)) <= bits)
+            return true;
+
+        return fitsInSignedBits(value, bits);
+    }
+
+    constexpr u32 placeField(u32 value, size_t pos, size_t bits) {
+        return (value & generateMask(bits)) << (32 - (pos + bits));
+    }
+
+    /// Converts between a special purpose register number and its encoding,
+    /// which stores the two 5 bit halves swapped.
+    constexpr u32 swapSprHalves(u32 spr) {
+        return ((spr & 0x1F) << 5) | ((spr >> 5) & 0x1F);
+    }
+
+    /// Asserts that the input tokens match an instruction definition.
+    constexpr std::optional<PPCInstructionDef>
+    instructionize(const PPCMnemonic mnemonic, const OperandList& operands) {
+        const MnemonicInfo& info =
+            MNEMONIC_INFO[static_cast<size_t>(mnemonic)];
+        const OperandSignature signature = operandSignature(operands);
+        const size_t end = info.definitionBegin + info.definitionCount;
+
+        for (size_t i = info.definitionBegin; i < end; i++) {
+            const DefinitionEntry& entry = MNEMONIC_DEFINITIONS[i];
+
+            if (entry.signature == signature)
+                return PPC_INSTRUCTION_TABLE[entry.definition];
+        }
+
+        return std::nullopt;
+    }
+
+    constexpr std::expected<u32, AssembleError>
+    codegenSegment(const Operand& operand, const OperandDef& operandDef) {
+        size_t pos  = operandDef.pos;
+        size_t bits = operandDef.bits;
+
+        if (auto immediate = std::get_if<ImmediateOperand>(&operand)) {
+            auto immediateDef =
+                std::get_if<ImmediateOperandDefType>(&operandDef.type);
+            if (!immediateDef) {
+                return std::unexpected(
+                    assembleError(AssembleErrorCode::OperandMismatch));
+            }
+
+            const size_t shift = immediateDef->shift;
+
+            if ((immediate->value & generateMask(shift)) != 0) {
+                AssembleError error =
+                    assembleError(AssembleErrorCode::UnalignedInteger);
+                error.value = immediate->value;
+                error.limit = static_cast<u16>(u16{1} << shift);
+
+                return std::unexpected(error);
+            }
+
+            // Displacements are always signed, a too large forward branch must
+            // not turn into a backward one. Other signed fields, e.g. of
+            // `addi`, must not take 0x8000 and up as a negative number.
+            const bool fits =
+                shift != 0 || immediateDef->isSigned
+                    ? fitsInSignedBits(immediate->value, bits + shift)
+                    : fitsInBits(immediate->value, bits + shift);
+            if (!fits) {
+                return std::unexpected(
+                    integerTooLarge(immediate->value, bits + shift));
+            }
+
+            if (immediateDef->isSpr)
+                return placeField(swapSprHalves(immediate->value), pos, bits);
+
+            return placeField(immediate->value >> shift, pos, bits);
+        } else if (auto reg = std::get_if<DirectOperand>(&operand)) {
+            if (auto regDef =
+                    std::get_if<DirectOperandDefType>(&operandDef.type)) {
+                if (reg->regType != regDef->regType)
+                    return std::unexpected(
+                        registerTypeMismatch(reg->regType, regDef->regType));
+
+                u32 regNum = regToNum(reg->reg);
+
+                if (static_cast<size_t>(std::bit_width(regNum)) > bits) {
+                    return std::unexpected(integerTooLarge(regNum, bits));
+                }
+
+                return placeField(regNum, pos, bits);
+            } else {
+                return std::unexpected(
+                    assembleError(AssembleErrorCode::OperandMismatch));
+            }
+        } else if (auto indirect = std::get_if<IndirectOperand>(&operand)) {
+            if (auto indirectDef =
+                    std::get_if<IndirectOperandDefType>(&operandDef.type)) {
+                u32    base     = regToNum(indirect->reg);
+                size_t basePos  = pos;
+                size_t baseBits = bits - indirectDef->offsetBits;
+
+                u32    offset     = indirect->offset;
+                size_t offsetPos  = indirectDef->offsetPos;
+                size_t offsetBits = indirectDef->offsetBits;
+
+                if (static_cast<size_t>(std::bit_width(base)) > baseBits) {
+                    return std::unexpected(integerTooLarge(base, baseBits));
+                }
+
+                if (!fitsInSignedBits(offset, offsetBits)) {
+                    return std::unexpected(integerTooLarge(offset, offsetBits));
+                }
+
+                return placeField(base, basePos, baseBits)
+                       | placeField(offset, offsetPos, offsetBits);
+            } else {
+                return std::unexpected(
+                    assembleError(AssembleErrorCode::OperandMismatch));
+            }
+        } else {
+            return std::unexpected(
+                assembleError(AssembleErrorCode::InvalidInstruction));
+        }
+    }
+
+    // Generates the final assembly from the tokens.
+    constexpr std::expected<u32, AssembleError>
+    codegen(const PPCInstruction&    instruction,
+            const PPCInstructionDef& instructionDef) {
+        u32 data = 0;
+
+        data = (mnemonicToOpcode(instruction.mnemonic) & 0x3F) << 26;
+        data |= instructionDef.mask;
+
+        for (size_t i = 0; i < OPERAND_NUM; i++) {
+            if (instruction.operands[i].has_value()
+                && instructionDef.operands[i].has_value()) {
+                std::expected<u32, AssembleError> result =
+                    codegenSegment(instruction.operands[i].value(),
+                                   instructionDef.operands[i].value());
+
+                if (!result.has_value()) {
+                    AssembleError error = result.error();
+                    error.operand       = static_cast<u8>(i);
+
+                    return std::unexpected(error);
+                }
+
+                data |= result.value();
+            }
+        }
+
+        return data;
+    }
+
+    /// Encodes an already tokenized instruction.
+    constexpr std::expected<u32, AssembleError>
+    encode(const PPCInstruction& instruction) {
+        std::optional<PPCInstructionDef> instructionDef =
+            instructionize(instruction.mnemonic, instruction.operands);
+        if (!instructionDef.has_value())
+            return std::unexpected(
+                assembleError(AssembleErrorCode::InvalidInstruction));
+
+        return codegen(instruction, instructionDef.value());
+    }
+
+    /// Lexes and encodes a single line of assembly without allocating.
+    /// Operands may be expressions over the symbols `resolve` knows.
+    template <typename Resolve = NoSymbols>
+    constexpr std::expected<u32, AssembleError>
+    assembleView(std::string_view instructionStr,
+                 const Resolve&   resolve = {}) {
+        const std::expected<PPCInstruction, AssembleError> instruction =
+            lexInstruction(instructionStr, resolve);
+        if (!instruction.has_value())
+            return std::unexpected(instruction.error());
+
+        std::expected<u32, AssembleError> encoded =
+            encode(instruction.value());
+        if (encoded.has_value())
+            return encoded;
+
+        // `encode` only knows the operand at fault, point at its text.
+        const AssembleError& error = encoded.error();
+        if (error.operand != NO_OPERAND) {
+            if (const std::optional<std::string_view> operandStr =
+                    operandText(instructionStr, error.operand))
+                return std::unexpected(
+                    error.at(instructionStr, operandStr.value()));
+        }
+
+        return std::unexpected(
+            error.at(instructionStr, trim(instructionStr)));
+    }
+} // namespace LibMacchiato::PPCAssembler
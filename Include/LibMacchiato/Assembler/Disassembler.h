@@ -0,0 +1,336 @@
+/*
+ * libmacchiato - Front-end for the Macchiato modding environment
+ * Copyright (C) 2024 splatoon1enjoyer @ SDL Foundation
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "Codegen.h"
+#include "Instruction.h"
+#include "InstructionDef.h"
+#include "InstructionDefTable.h"
+#include "Mnemonic.h"
+#include "Operand.h"
+#include "OperandDef.h"
+#include "PPCData.h"
+#include "Register.h"
+
+#include <sdl-utils/Types.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <variant>
+
+// Decoding walks the same `PPC_INSTRUCTION_TABLE` as the encoder, so every
+// instruction that can be assembled can also be disassembled.
+namespace LibMacchiato::PPCAssembler {
+    constexpr size_t PRIMARY_OPCODE_NUM = 1 << OPCODE_SIZE;
+
+    constexpr u32 extractField(u32 code, size_t pos, size_t bits) {
+        return (code >> (32 - (pos + bits))) & generateMask(bits);
+    }
+
+    constexpr u32 signExtend(u32 value, size_t bits) {
+        if (bits >= 32 || (value & (1U << (bits - 1))) == 0)
+            return value;
+
+        return value | ~generateMask(bits);
+    }
+
+    /// Bits of an instruction word that are occupied by operands.
+    constexpr u32 operandFieldMask(const OperandDefList& operandDefs) {
+        u32 mask = 0;
+
+        for (const auto& operandDef : operandDefs) {
+            if (!operandDef.has_value())
+                continue;
+
+            // The base register and the offset are not always adjacent, e.g.
+            // `psq_l` places `W` and `I` between them.
+            if (auto indirect =
+                    std::get_if<IndirectOperandDefType>(&operandDef->type)) {
+                mask |= placeField(0xFFFFFFFF, operandDef->pos,
+                                   operandDef->bits - indirect->offsetBits);
+                mask |= placeField(0xFFFFFFFF, indirect->offsetPos,
+                                   indirect->offsetBits);
+                continue;
+            }
+
+            mask |= placeField(0xFFFFFFFF, operandDef->pos, operandDef->bits);
+        }
+
+        return mask;
+    }
+
+    struct DecodeEntry {
+        // The bits that are not operands and their expected values.
+        u32    fixedMask  = 0;
+        u32    fixedBits  = 0;
+        size_t definition = 0;
+    };
+
+    // Definitions grouped by primary opcode. Within a group, the definitions
+    // with the most fixed bits come first, so that extended opcodes and
+    // simplified mnemonics such as `li` or `nop` win over their general form.
+    constexpr std::array<DecodeEntry, PPC_INSTRUCTION_TABLE.size()>
+        DECODE_TABLE = [] {
+            std::array<DecodeEntry, PPC_INSTRUCTION_TABLE.size()> entries = {};
+
+            for (size_t i = 0; i < PPC_INSTRUCTION_TABLE.size(); i++) {
+                const PPCInstructionDef& def = PPC_INSTRUCTION_TABLE[i];
+                const u32 fixedMask = ~operandFieldMask(def.operands);
+
+                entries[i] = DecodeEntry{
+                    .fixedMask  = fixedMask,
+                    .fixedBits  = ((mnemonicToOpcode(def.mnemonic) << 26)
+                                  | def.mask)
+                                 & fixedMask,
+                    .definition = i};
+            }
+
+            std::sort(entries.begin(), entries.end(),
+                      [](const DecodeEntry& lhs, const DecodeEntry& rhs) {
+                          const u32 lhsOpcode = lhs.fixedBits >> 26;
+                          const u32 rhsOpcode = rhs.fixedBits >> 26;
+
+                          if (lhsOpcode != rhsOpcode)
+                              return lhsOpcode < rhsOpcode;
+                          if (lhs.fixedMask != rhs.fixedMask)
+                              return std::popcount(lhs.fixedMask)
+                                     > std::popcount(rhs.fixedMask);
+
+                          return lhs.definition < rhs.definition;
+                      });
+
+            return entries;
+        }();
+
+    struct DecodeRange {
+        size_t begin = 0;
+        size_t end   = 0;
+    };
+
+    constexpr std::array<DecodeRange, PRIMARY_OPCODE_NUM> DECODE_RANGES = [] {
+        std::array<DecodeRange, PRIMARY_OPCODE_NUM> ranges = {};
+
+        for (size_t i = 0; i < DECODE_TABLE.size(); i++) {
+            DecodeRange& range = ranges[DECODE_TABLE[i].fixedBits >> 26];
+
+            if (range.begin == range.end)
+                range.begin = i;
+            range.end = i + 1;
+        }
+
+        return ranges;
+    }();
+
+    constexpr std::optional<Operand> decodeOperand(u32               code,
+                                                   const OperandDef& def) {
+        if (auto direct = std::get_if<DirectOperandDefType>(&def.type)) {
+            std::optional<Register> reg =
+                numToReg(extractField(code, def.pos, def.bits));
+            if (!reg.has_value())
+                return std::nullopt;
+
+            return DirectOperand{.regType = direct->regType,
+                                 .reg     = reg.value()};
+        }
+
+        if (auto indirect = std::get_if<IndirectOperandDefType>(&def.type)) {
+            std::optional<Register> reg = numToReg(
+                extractField(code, def.pos, def.bits - indirect->offsetBits));
+            if (!reg.has_value())
+                return std::nullopt;
+
+            return IndirectOperand{
+                .offset = signExtend(extractField(code, indirect->offsetPos,
+                                                  indirect->offsetBits),
+                                     indirect->offsetBits),
+                .reg    = reg.value()};
+        }
+
+        const auto& immediate = std::get<ImmediateOperandDefType>(def.type);
+
+        u32 value = extractField(code, def.pos, def.bits);
+        if (immediate.isSpr)
+            value = swapSprHalves(value);
+        if (immediate.isSigned)
+            value = signExtend(value, def.bits);
+
+        return ImmediateOperand{.value = value << immediate.shift};
+    }
+
+    /// Decodes an instruction word, or `std::nullopt` if no definition in
+    /// `PPC_INSTRUCTION_TABLE` matches it.
+    constexpr std::optional<PPCInstruction> disassemble(u32 code) {
+        const DecodeRange& range = DECODE_RANGES[code >> 26];
+
+        for (size_t i = range.begin; i < range.end; i++) {
+            const DecodeEntry& entry = DECODE_TABLE[i];
+            if ((code & entry.fixedMask) != entry.fixedBits)
+                continue;
+
+            const PPCInstructionDef& def =
+                PPC_INSTRUCTION_TABLE[entry.definition];
+            PPCInstruction instruction = {.mnemonic = def.mnemonic,
+                                          .operands = EMPTY_OPERAND_LIST};
+
+            for (size_t j = 0; j < OPERAND_NUM; j++) {
+                if (!def.operands[j].has_value())
+                    continue;
+
+                instruction.operands[j] =
+                    decodeOperand(code, def.operands[j].value());
+                if (!instruction.operands[j].has_value())
+                    return std::nullopt;
+            }
+
+            return instruction;
+        }
+
+        return std::nullopt;
+    }
+
+    /// Absolute destination of an unconditional `b`, `ba`, `bl` or `bla`
+    /// located at `address`.
+    constexpr std::optional<u32> branchTarget(u32 code, u32 address) {
+        std::optional<PPCInstruction> instruction = disassemble(code);
+        if (!instruction.has_value())
+            return std::nullopt;
+
+        const PPCMnemonic mnemonic = instruction->mnemonic;
+        if (mnemonic != PPCMnemonic::B && mnemonic != PPCMnemonic::BA
+            && mnemonic != PPCMnemonic::BL && mnemonic != PPCMnemonic::BLA)
+            return std::nullopt;
+
+        const u32 value =
+            std::get<ImmediateOperand>(instruction->operands[0].value()).value;
+
+        return mnemonic == PPCMnemonic::BA || mnemonic == PPCMnemonic::BLA
+                   ? value
+                   : address + value;
+    }
+
+    constexpr std::string unsignedToStr(u32 value, u32 base) {
+        constexpr char DIGITS[] = "0123456789abcdef";
+
+        std::string digits = {};
+        do {
+            digits.insert(digits.begin(), DIGITS[value % base]);
+            value /= base;
+        } while (value != 0);
+
+        return digits;
+    }
+
+    constexpr std::string immediateToStr(u32 value) {
+        if (static_cast<s32>(value) < 0)
+            return "-0x" + unsignedToStr(0 - value, 16);
+
+        return "0x" + unsignedToStr(value, 16);
+    }
+
+    constexpr std::string registerPrefix(RegisterType regType) {
+        switch (regType) {
+        case RegisterType::GPR:
+            return "r";
+        case RegisterType::FPR:
+            return "f";
+        case RegisterType::CR:
+            return "cr";
+        }
+
+        return "";
+    }
+
+    constexpr std::string operandToStr(const Operand& operand) {
+        if (auto direct = std::get_if<DirectOperand>(&operand))
+            return registerPrefix(direct->regType)
+                   + unsignedToStr(regToNum(direct->reg), 10);
+
+        if (auto indirect = std::get_if<IndirectOperand>(&operand))
+            return immediateToStr(indirect->offset) + "(r"
+                   + unsignedToStr(regToNum(indirect->reg), 10) + ")";
+
+        return immediateToStr(std::get<ImmediateOperand>(operand).value);
+    }
+
+    /// Formats an instruction in the syntax accepted by the assembler.
+    constexpr std::string instructionToStr(const PPCInstruction& instruction) {
+        std::string result = std::string(mnemonicToStr(instruction.mnemonic));
+
+        bool first = true;
+        for (const auto& operand : instruction.operands) {
+            if (!operand.has_value())
+                continue;
+
+            result += first ? " " : ", ";
+            result += operandToStr(operand.value());
+            first = false;
+        }
+
+        return result;
+    }
+
+    static_assert([] {
+        for (const u32 code :
+             {0x60000000U, 0x4E800020U, 0x4E800420U, 0x4E800421U, 0x38600001U,
+              0x3D601234U, 0x616B5678U, 0x3821FFF0U, 0x7D6903A6U, 0x80610008U,
+              0x8883FFF0U, 0x90010004U, 0x9421FFF0U, 0x4BFFFFF8U, 0x48000102U,
+              0x48000101U, 0xC0230008U, 0xFC22202AU, 0xFC2220FAU, 0xFC201090U,
+              0xE0230000U, 0xF3E3F800U, 0x102220FAU, 0x10201090U, 0x10221C20U,
+              0x10221CE0U}) {
+            std::optional<PPCInstruction> instruction = disassemble(code);
+            if (!instruction.has_value())
+                return false;
+
+            std::expected<u32, AssembleError> encoded =
+                encode(instruction.value());
+            if (!encoded.has_value() || encoded.value() != code)
+                return false;
+
+            std::expected<u32, AssembleError> reassembled =
+                assembleView(instructionToStr(instruction.value()));
+            if (!reassembled.has_value() || reassembled.value() != code)
+                return false;
+        }
+
+        return !disassemble(0x00000000).has_value();
+    }());
+
+    static_assert(disassemble(0x38600001)->mnemonic == PPCMnemonic::LI);
+    static_assert(disassemble(0x38630001)->mnemonic == PPCMnemonic::ADDI);
+    static_assert(disassemble(0x60000000)->mnemonic == PPCMnemonic::NOP);
+    static_assert(disassemble(0x7D6903A6)->mnemonic == PPCMnemonic::MTCTR);
+    static_assert(branchTarget(0x4BFFFFF8, 0x1000) == 0xFF8);
+    static_assert(branchTarget(0x48000102, 0x1000) == 0x100);
+    static_assert(branchTarget(0x48000103, 0x1000) == 0x100);
+    static_assert(!branchTarget(0x4E800020, 0x1000).has_value());
+    static_assert([] {
+        const PPCInstruction instruction = disassemble(0x8883FFF0).value();
+
+        return instructionToStr(instruction) == "lbz r4, -0x10(r3)";
+    }());
+    static_assert([] {
+        const PPCInstruction instruction = disassemble(0xF3E3F800).value();
+
+        return instructionToStr(instruction)
+               == "psq_st f31, -0x800(r3), 0x1, 0x7";
+    }());
+} // namespace LibMacchiato::PPCAssembler
@@ -0,0 +1,413 @@
+/*
+ * libmacchiato - Front-end for the Macchiato modding environment
+ * Copyright (C) 2024 splatoon1enjoyer @ SDL Foundation
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "Codegen.h"
+#include "Error.h"
+#include "Instruction.h"
+#include "Literal.h"
+#include "Mnemonic.h"
+#include "Operand.h"
+#include "Range.h"
+#include "Register.h"
+
+#include <sdl-utils/Types.h>
+
+#include <array>
+#include <cstddef>
+#include <expected>
+#include <optional>
+#include <span>
+
+namespace LibMacchiato::PPCAssembler {
+    /*
+     * @brief Encodes instructions straight from typed operands into a buffer
+     * owned by the caller, without formatting or lexing any text.
+     *
+     * std::array<u32, 4> code = {};
+     * Emitter(code, address).lis(Register::R11, target >> 16)
+     *                       .ori(Register::R11, Register::R11, target)
+     *                       .mtctr(Register::R11)
+     *                       .bctr()
+     *                       .finish();
+     *
+     * Branch targets are absolute addresses, relative branches are computed
+     * from `address`, which is where `buffer` is going to be placed. The first
+     * error is kept and every instruction after it is ignored, so a sequence
+     * only has to be checked once by `finish`.
+     */
+    struct Emitter {
+      private:
+        std::span<u32>               buffer;
+        u32                          address;
+        size_t                       size  = 0;
+        // A plain error and flag rather than an `std::optional`, which GCC
+        // wrongly warns about as maybe uninitialized once it is inlined.
+        AssembleError error  = {};
+        bool          failed = false;
+
+        // Keeps the first error only.
+        constexpr Emitter& fail(const AssembleError& error) {
+            if (!this->failed) {
+                this->error  = error;
+                this->failed = true;
+            }
+
+            return *this;
+        }
+
+        static constexpr Operand gpr(Register reg) {
+            return DirectOperand{.regType = RegisterType::GPR, .reg = reg};
+        }
+
+        static constexpr Operand immediate(u32 value) {
+            return ImmediateOperand{.value = value};
+        }
+
+      public:
+        constexpr Emitter(std::span<u32> buffer, u32 address)
+            : buffer(buffer)
+            , address(address) {}
+
+        /// Address the next instruction is going to be placed at.
+        [[nodiscard]] constexpr u32 pc() const {
+            return this->address + static_cast<u32>(this->size * sizeof(u32));
+        }
+
+        /// Number of words emitted so far.
+        [[nodiscard]] constexpr size_t getSize() const { return this->size; }
+
+        [[nodiscard]] constexpr std::expected<size_t, AssembleError>
+        finish() const {
+            if (this->failed)
+                return std::unexpected(this->error);
+
+            return this->size;
+        }
+
+        constexpr Emitter& word(u32 code) {
+            if (this->failed)
+                return *this;
+
+            if (this->size >= this->buffer.size()) {
+                AssembleError error =
+                    assembleError(AssembleErrorCode::BufferTooSmall);
+                error.value = static_cast<u32>(this->buffer.size());
+                return this->fail(error);
+            }
+
+            this->buffer[this->size++] = code;
+            return *this;
+        }
+
+        constexpr Emitter& instruction(const PPCInstruction& instruction) {
+            if (this->failed)
+                return *this;
+
+            const std::expected<u32, AssembleError> code = encode(instruction);
+            if (!code.has_value())
+                return this->fail(code.error());
+
+            return this->word(code.value());
+        }
+
+        constexpr Emitter& instruction(PPCMnemonic                   mnemonic,
+                                       std::optional<Operand> first  = {},
+                                       std::optional<Operand> second = {},
+                                       std::optional<Operand> third  = {},
+                                       std::optional<Operand> fourth = {},
+                                       std::optional<Operand> fifth  = {}) {
+            PPCInstruction instruction = {.mnemonic = mnemonic,
+                                          .operands = EMPTY_OPERAND_LIST};
+            instruction.operands[0] = first;
+            instruction.operands[1] = second;
+            instruction.operands[2] = third;
+            instruction.operands[3] = fourth;
+            instruction.operands[4] = fifth;
+
+            return this->instruction(instruction);
+        }
+
+        constexpr Emitter& nop() {
+            return this->instruction(PPCMnemonic::NOP);
+        }
+
+        constexpr Emitter& li(Register dst, s16 value) {
+            return this->instruction(PPCMnemonic::LI, gpr(dst),
+                                     immediate(static_cast<u32>(value)));
+        }
+
+        constexpr Emitter& lis(Register dst, u16 value) {
+            return this->instruction(PPCMnemonic::LIS, gpr(dst),
+                                     immediate(value));
+        }
+
+        constexpr Emitter& addi(Register dst, Register src, s16 value) {
+            return this->instruction(PPCMnemonic::ADDI, gpr(dst), gpr(src),
+                                     immediate(static_cast<u32>(value)));
+        }
+
+        constexpr Emitter& ori(Register dst, Register src, u16 value) {
+            return this->instruction(PPCMnemonic::ORI, gpr(dst), gpr(src),
+                                     immediate(value));
+        }
+
+        constexpr Emitter& lwz(Register dst, s16 offset, Register base) {
+            return this->instruction(
+                PPCMnemonic::LWZ, gpr(dst),
+                IndirectOperand{.offset = static_cast<u32>(offset),
+                                .reg    = base});
+        }
+
+        constexpr Emitter& mtctr(Register src) {
+            return this->instruction(PPCMnemonic::MTCTR, gpr(src));
+        }
+
+        constexpr Emitter& bctr() {
+            return this->instruction(PPCMnemonic::BCTR);
+        }
+
+        constexpr Emitter& bctrl() {
+            return this->instruction(PPCMnemonic::BCTRL);
+        }
+
+        constexpr Emitter& blr() { return this->instruction(PPCMnemonic::BLR); }
+
+        constexpr Emitter& b(u32 target) {
+            return this->instruction(PPCMnemonic::B,
+                                     immediate(target - this->pc()));
+        }
+
+        constexpr Emitter& ba(u32 target) {
+            return this->instruction(PPCMnemonic::BA, immediate(target));
+        }
+
+        constexpr Emitter& bl(u32 target) {
+            return this->instruction(PPCMnemonic::BL,
+                                     immediate(target - this->pc()));
+        }
+
+        constexpr Emitter& bla(u32 target) {
+            return this->instruction(PPCMnemonic::BLA, immediate(target));
+        }
+
+        /// Loads `value` with the shortest of `li`, `lis` and `lis/ori`.
+        constexpr Emitter& li32(Register dst, u32 value) {
+            if (fitsInSignedBits(value, 16))
+                return this->li(dst, static_cast<s16>(value));
+
+            this->lis(dst, static_cast<u16>(value >> 16));
+            if ((value & 0xFFFF) == 0)
+                return *this;
+
+            return this->ori(dst, dst, static_cast<u16>(value));
+        }
+
+        /// Jumps to `target` with `ba`, or through the count register when
+        /// it is out of range, which clobbers r11 and the count register. The
+        /// result does not depend on `pc`, so it can be moved afterwards.
+        constexpr Emitter& absoluteJmp(u32 target) {
+            if (absoluteBranchFits(target))
+                return this->ba(target);
+
+            return this->li32(Register::R11, target)
+                .mtctr(Register::R11)
+                .bctr();
+        }
+
+        /// Shortest jump to `target`, `b` if it is in range.
+        constexpr Emitter& jmp(u32 target) {
+            if (relativeBranchFits(this->pc(), target))
+                return this->b(target);
+
+            return this->absoluteJmp(target);
+        }
+
+        /// Jumps to the address stored at `slot`, which can change after the
+        /// code is written. Clobbers r11 and the count register.
+        constexpr Emitter& jmpThrough(u32 slot) {
+            return this
+                ->lis(Register::R11, static_cast<u16>((slot + 0x8000) >> 16))
+                .lwz(Register::R11, static_cast<s16>(slot & 0xFFFF),
+                     Register::R11)
+                .mtctr(Register::R11)
+                .bctr();
+        }
+
+        /// `jmp` that links, i.e. `bl`, `bla` or `bctrl`.
+        constexpr Emitter& call(u32 target) {
+            if (relativeBranchFits(this->pc(), target))
+                return this->bl(target);
+            if (absoluteBranchFits(target))
+                return this->bla(target);
+
+            return this->li32(Register::R11, target)
+                .mtctr(Register::R11)
+                .bctrl();
+        }
+
+        constexpr Emitter& mflr(Register dst) {
+            return this->instruction(PPCMnemonic::MFLR, gpr(dst));
+        }
+
+        constexpr Emitter& mtlr(Register src) {
+            return this->instruction(PPCMnemonic::MTLR, gpr(src));
+        }
+
+        constexpr Emitter& cmpwi(Register src, s16 value) {
+            return this->instruction(PPCMnemonic::CMPWI, gpr(src),
+                                     immediate(static_cast<u32>(value)));
+        }
+
+        constexpr Emitter& cmplwi(Register src, u16 value) {
+            return this->instruction(PPCMnemonic::CMPLWI, gpr(src),
+                                     immediate(value));
+        }
+
+        /// One of the simplified conditional branches such as `beq` or
+        /// `bge`, testing the CR field `crField`.
+        constexpr Emitter& conditionalBranch(PPCMnemonic condition,
+                                             u32 target, u32 crField = 0) {
+            const Operand offset = immediate(target - this->pc());
+            if (crField == 0)
+                return this->instruction(condition, offset);
+
+            std::optional<Register> field = numToReg(crField);
+            if (!field.has_value())
+                return this->fail(integerTooLarge(crField, 3));
+
+            return this->instruction(
+                condition,
+                DirectOperand{.regType = RegisterType::CR,
+                              .reg     = field.value()},
+                offset);
+        }
+
+        constexpr Emitter& beq(u32 target) {
+            return this->conditionalBranch(PPCMnemonic::BEQ, target);
+        }
+
+        constexpr Emitter& bne(u32 target) {
+            return this->conditionalBranch(PPCMnemonic::BNE, target);
+        }
+    };
+
+    static_assert([] {
+        std::array<u32, 9> code = {};
+
+        const std::expected<size_t, AssembleError> size =
+            Emitter(code, 0x1000)
+                .lis(Register::R11, 0x1234)
+                .ori(Register::R11, Register::R11, 0x5678)
+                .mtctr(Register::R11)
+                .bctr()
+                .bctrl()
+                .b(0xFF8)
+                .ba(0x100)
+                .bl(0x1100)
+                .addi(Register::R1, Register::R1, -16)
+                .finish();
+
+        using namespace Literals;
+
+        return size == 9 && code[0] == "lis r11, 0x1234"_ppc
+               && code[1] == "ori r11, r11, 0x5678"_ppc
+               && code[2] == "mtctr r11"_ppc && code[3] == "bctr"_ppc
+               && code[4] == "bctrl"_ppc && code[5] == "b -0x1c"_ppc
+               && code[6] == "ba 0x100"_ppc && code[7] == "bl 0xe4"_ppc
+               && code[8] == "addi r1, r1, -16"_ppc;
+    }());
+
+    // `ori` takes its destination first but encodes it second.
+    static_assert([] {
+        std::array<u32, 1> code = {};
+        Emitter(code, 0).ori(Register::R3, Register::R4, 1);
+
+        return code[0] == 0x60830001;
+    }());
+
+    static_assert([] {
+        std::array<u32, 5> code = {};
+
+        const std::expected<size_t, AssembleError> size =
+            Emitter(code, 0x1000)
+                .mflr(Register::R0)
+                .cmpwi(Register::R3, -1)
+                .beq(0x1010)
+                .conditionalBranch(PPCMnemonic::BGE, 0x1000, 7)
+                .mtlr(Register::R0)
+                .finish();
+
+        using namespace Literals;
+
+        return size == 5 && code[0] == "mflr r0"_ppc
+               && code[1] == "cmpwi r3, -1"_ppc && code[2] == "beq 8"_ppc
+               && code[3] == "bge cr7, -0xc"_ppc && code[4] == "mtlr r0"_ppc;
+    }());
+
+    static_assert([] {
+        std::array<u32, 1> code = {};
+
+        return !Emitter(code, 0).nop().nop().finish().has_value()
+               && !Emitter(code, 0).beq(0x8000).finish().has_value()
+               && !Emitter(code, 0)
+                       .conditionalBranch(PPCMnemonic::BNE, 0, 8)
+                       .finish()
+                       .has_value()
+               && !Emitter(code, 0).b(0x4000000).finish().has_value()
+               && !Emitter(code, 0).ba(0x102).finish().has_value();
+    }());
+
+    static_assert([] {
+        std::array<u32, 9> code = {};
+
+        const std::expected<size_t, AssembleError> size =
+            Emitter(code, 0x03000000)
+                .li32(Register::R3, 0xFFFFFFFF)
+                .li32(Register::R3, 0x80000000)
+                .li32(Register::R3, 0x8000)
+                .jmp(0x03000100)
+                .call(0x100)
+                .jmp(0x80000000)
+                .finish();
+
+        using namespace Literals;
+
+        return size == 9 && code[0] == "li r3, -1"_ppc
+               && code[1] == "lis r3, 0x8000"_ppc
+               && code[2] == "lis r3, 0"_ppc
+               && code[3] == "ori r3, r3, 0x8000"_ppc
+               && code[4] == "b 0xf0"_ppc && code[5] == "bla 0x100"_ppc
+               && code[6] == "lis r11, 0x8000"_ppc
+               && code[7] == "mtctr r11"_ppc && code[8] == "bctr"_ppc;
+    }());
+
+    // The low half of the slot is signed, so the high half rounds up.
+    static_assert([] {
+        std::array<u32, 4> code = {};
+
+        const std::expected<size_t, AssembleError> size =
+            Emitter(code, 0x1000).jmpThrough(0x1000A000).finish();
+
+        using namespace Literals;
+
+        return size == 4 && code[0] == "lis r11, 0x1001"_ppc
+               && code[1] == "lwz r11, -0x6000(r11)"_ppc
+               && code[2] == "mtctr r11"_ppc && code[3] == "bctr"_ppc;
+    }());
+} // namespace LibMacchiato::PPCAssembler
@@ -17,83 +17,237 @@
 
 #pragma once
 
-#include "Operand.h"
-#include "OperandDef.h"
 #include "Register.h"
 
 #include <sdl-utils/Types.h>
 
+#include <cstddef>
 #include <string>
-#include <variant>
+#include <string_view>
+#include <type_traits>
 
 namespace LibMacchiato::PPCAssembler {
-    struct InvalidInstruction {};
+    enum class AssembleErrorCode : u8 {
+        InvalidInstruction,
+        EmptyInstruction,
+        InstructionTooLarge,
+        InvalidMnemonic,
+        InvalidOperand,
+        OperandMismatch,
+        IntegerTooLarge,
+        UnalignedInteger,
+        RegisterTypeMismatch,
+        IntegerConversionFailure,
+        UndefinedSymbol,
+        DuplicateLabel,
+        InvalidDirective,
+        BufferTooSmall,
+    };
 
-    struct EmptyInstruction {};
+    /// Byte range of the text an error is about, within the string that was
+    /// assembled.
+    struct SourceSpan {
+        u32 offset = 0;
+        u32 size   = 0;
+
+        /// The text of the span, or an empty view if `source` is not the
+        /// string it was taken from.
+        [[nodiscard]] constexpr std::string_view
+        in(std::string_view source) const {
+            if (this->offset > source.size()
+                || this->size > source.size() - this->offset)
+                return {};
+
+            return source.substr(this->offset, this->size);
+        }
+    };
 
-    struct InstructionTooLarge {};
+    // Errors that do not come from any text, e.g. those of `encode`.
+    constexpr SourceSpan NO_SPAN     = {.offset = 0xFFFFFFFF, .size = 0};
+    constexpr u8         NO_OPERAND  = 0xFF;
 
-    struct InvalidMnemonic {
-        std::string mnemonic;
-    };
+    /*
+     * @brief Why an instruction could not be assembled. It is trivially
+     * copyable and never allocates, the message is only put together by
+     * `assembleErrorToStr` when it is needed.
+     */
+    struct AssembleError {
+        AssembleErrorCode code = AssembleErrorCode::InvalidInstruction;
 
-    struct InvalidOperand {
-        std::string operand;
-    };
+        // Index of the operand at fault, if known.
+        u8 operand = NO_OPERAND;
 
-    struct OperandMismatch {
-        Operand    operand;
-        OperandDef expectedOperand;
-    };
+        // `IntegerTooLarge`: the number of bits available.
+        // `UnalignedInteger`: the required alignment.
+        // `RegisterTypeMismatch`: the expected `RegisterType`.
+        u16 limit = 0;
 
-    struct IntegerTooLarge {
-        u32    integer;
-        size_t maxBits;
-    };
+        // `IntegerTooLarge` and `UnalignedInteger`: the integer.
+        // `RegisterTypeMismatch`: the `RegisterType` that was given.
+        // `BufferTooSmall`: the capacity in instructions.
+        u32 value = 0;
+
+        SourceSpan span = NO_SPAN;
+
+        [[nodiscard]] constexpr bool hasSpan() const {
+            return this->span.offset != NO_SPAN.offset;
+        }
+
+        /// The same error about `part`, a view into `source`.
+        [[nodiscard]] constexpr AssembleError at(std::string_view source,
+                                                 std::string_view part) const {
+            const auto offset = static_cast<u32>(part.data() - source.data());
+
+            AssembleError error = *this;
+            error.span.offset   = offset;
+            error.span.size     = static_cast<u32>(part.size());
+
+            return error;
+        }
 
-    struct RegisterTypeMismatch {
-        RegisterType regType;
-        RegisterType expectedRegType;
+        /// The same error with its span moved by `offset` bytes, for errors
+        /// of a substring that are passed on.
+        [[nodiscard]] constexpr AssembleError shifted(size_t offset) const {
+            AssembleError error = *this;
+            if (error.hasSpan())
+                error.span.offset += static_cast<u32>(offset);
+
+            return error;
+        }
     };
 
-    struct IntegerConversionFailure {
-        std::string integer;
+    static_assert(std::is_trivially_copyable_v<AssembleError>);
+    static_assert(sizeof(AssembleError) <= 16);
+
+    constexpr AssembleError assembleError(AssembleErrorCode code) {
+        return AssembleError{.code = code};
+    }
+
+    /// `code` about `part`, a view into `source`.
+    constexpr AssembleError assembleError(AssembleErrorCode code,
+                                          std::string_view  source,
+                                          std::string_view  part) {
+        return assembleError(code).at(source, part);
+    }
+
+    constexpr AssembleError integerTooLarge(u32 integer, size_t maxBits) {
+        AssembleError error = assembleError(AssembleErrorCode::IntegerTooLarge);
+        error.value         = integer;
+        error.limit         = static_cast<u16>(maxBits);
+
+        return error;
+    }
+
+    constexpr AssembleError registerTypeMismatch(RegisterType regType,
+                                                 RegisterType expectedRegType) {
+        AssembleError error =
+            assembleError(AssembleErrorCode::RegisterTypeMismatch);
+        error.value = static_cast<u32>(regType);
+        error.limit = static_cast<u16>(expectedRegType);
+
+        return error;
+    }
+
+    /// An `AssembleError` raised by a line of a block, see `assembleBlock`.
+    /// Its span is relative to the whole block.
+    struct BlockError {
+        size_t        line  = 0;
+        AssembleError error = {};
     };
 
-    typedef std::variant<IntegerConversionFailure, InvalidInstruction,
-                         IntegerTooLarge, RegisterTypeMismatch, OperandMismatch,
-                         EmptyInstruction, InstructionTooLarge, InvalidMnemonic,
-                         InvalidOperand>
-        AssembleError;
-
-    inline std::string assembleErrorToStr(AssembleError error) {
-        if (auto expectError = std::get_if<EmptyInstruction>(&error)) {
-            return "instruction is empty";
-        } else if (auto expectError =
-                       std::get_if<InstructionTooLarge>(&error)) {
-            return "instruction too large";
-        } else if (auto expectError = std::get_if<InvalidMnemonic>(&error)) {
-            return "invalid mnemonic";
-        } else if (auto expectError = std::get_if<InvalidOperand>(&error)) {
-            return "invalid operand";
-        } else if (auto expectError = std::get_if<OperandMismatch>(&error)) {
-            return "operand mismatch";
-        } else if (auto expectError = std::get_if<IntegerTooLarge>(&error)) {
-            return "integer \"" + std::to_string(expectError->integer)
-                   + "\" too large";
-        } else if (auto expectError =
-                       std::get_if<RegisterTypeMismatch>(&error)) {
-            return "register type mismatch";
-        } else if (auto expectError = std::get_if<InvalidInstruction>(&error)) {
-            return "invalid instruction";
-        } else if (auto expectError =
-                       std::get_if<IntegerConversionFailure>(&error)) {
-            return "integer conversion for \"" + expectError->integer
-                   + "\" failed";
-        } else {
-            return "unknown error";
+    constexpr std::string_view registerTypeToStr(RegisterType regType) {
+        switch (regType) {
+        case RegisterType::GPR:
+            return "GPR";
+        case RegisterType::FPR:
+            return "FPR";
+        case RegisterType::CR:
+            return "CR field";
         }
 
-        return "unknown error";
+        return "register";
+    }
+
+    /// Describes `error`. If `source` is the string that was assembled, the
+    /// text the error is about is quoted.
+    inline std::string assembleErrorToStr(const AssembleError& error,
+                                          std::string_view     source = {}) {
+        std::string result = {};
+
+        switch (error.code) {
+        case AssembleErrorCode::InvalidInstruction:
+            result = "invalid instruction";
+            break;
+        case AssembleErrorCode::EmptyInstruction:
+            result = "instruction is empty";
+            break;
+        case AssembleErrorCode::InstructionTooLarge:
+            result = "instruction too large";
+            break;
+        case AssembleErrorCode::InvalidMnemonic:
+            result = "invalid mnemonic";
+            break;
+        case AssembleErrorCode::InvalidOperand:
+            result = "invalid operand";
+            break;
+        case AssembleErrorCode::OperandMismatch:
+            result = "operand mismatch";
+            break;
+        case AssembleErrorCode::IntegerTooLarge:
+            result = "integer " + std::to_string(error.value)
+                     + " does not fit into " + std::to_string(error.limit)
+                     + " bits";
+            break;
+        case AssembleErrorCode::UnalignedInteger:
+            result = "integer " + std::to_string(error.value)
+                     + " is not aligned to " + std::to_string(error.limit);
+            break;
+        case AssembleErrorCode::RegisterTypeMismatch:
+            result = "expected a "
+                     + std::string(registerTypeToStr(
+                         static_cast<RegisterType>(error.limit)))
+                     + ", got a "
+                     + std::string(registerTypeToStr(
+                         static_cast<RegisterType>(error.value)));
+            break;
+        case AssembleErrorCode::IntegerConversionFailure:
+            result = "invalid integer";
+            break;
+        case AssembleErrorCode::UndefinedSymbol:
+            result = "undefined symbol";
+            break;
+        case AssembleErrorCode::DuplicateLabel:
+            result = "duplicate label";
+            break;
+        case AssembleErrorCode::InvalidDirective:
+            result = "invalid directive";
+            break;
+        case AssembleErrorCode::BufferTooSmall:
+            result = "buffer of " + std::to_string(error.value)
+                     + " instructions is too small";
+            break;
+        default:
+            result = "unknown error";
+            break;
+        }
+
+        if (error.operand != NO_OPERAND)
+            result = "operand " + std::to_string(error.operand + 1) + ": "
+                     + result;
+
+        if (error.hasSpan() && !source.empty()) {
+            const std::string_view text = error.span.in(source);
+            if (!text.empty())
+                result += " \"" + std::string(text) + "\"";
+        }
+
+        return result;
+    }
+
+    /// `assembleErrorToStr` for blocks, `source` being the whole block.
+    inline std::string blockErrorToStr(const BlockError& error,
+                                       std::string_view  source = {}) {
+        return "line " + std::to_string(error.line) + ": "
+               + assembleErrorToStr(error.error, source);
     }
 } // namespace LibMacchiato::PPCAssembler
@@ -30,7 +30,32 @@ namespace LibMacchiato::PPCAssembler {
         OperandDef{.pos  = 11,
                    .bits = 5,
                    .type = DirectOperandDefType{.regType = RegisterType::GPR}},
-        OperandDef{.pos = 16, .bits = 16, .type = ImmediateOperandDefType{}}};
+        OperandDef{.pos  = 16,
+                   .bits = 16,
+                   .type = ImmediateOperandDefType{.isSigned = true}},
+        std::nullopt, std::nullopt};
+
+    constexpr OperandDefList D_FORM_UNSIGNED = {
+        OperandDef{.pos  = 6,
+                   .bits = 5,
+                   .type = DirectOperandDefType{.regType = RegisterType::GPR}},
+        OperandDef{.pos  = 11,
+                   .bits = 5,
+                   .type = DirectOperandDefType{.regType = RegisterType::GPR}},
+        OperandDef{.pos = 16, .bits = 16, .type = ImmediateOperandDefType{}},
+        std::nullopt, std::nullopt};
+
+    // `rA, rS, UIMM` of the logical immediates, the destination is encoded
+    // second.
+    constexpr OperandDefList LOGICAL_D_FORM = {
+        OperandDef{.pos  = 11,
+                   .bits = 5,
+                   .type = DirectOperandDefType{.regType = RegisterType::GPR}},
+        OperandDef{.pos  = 6,
+                   .bits = 5,
+                   .type = DirectOperandDefType{.regType = RegisterType::GPR}},
+        OperandDef{.pos = 16, .bits = 16, .type = ImmediateOperandDefType{}},
+        std::nullopt, std::nullopt};
 
     constexpr OperandDefList INDIRECT_D_FORM = {
         OperandDef{.pos  = 6,
@@ -40,19 +65,235 @@ namespace LibMacchiato::PPCAssembler {
             .pos  = 11,
             .bits = 21,
             .type = IndirectOperandDefType{.offsetPos = 16, .offsetBits = 16}},
-        std::nullopt};
+        std::nullopt, std::nullopt, std::nullopt};
 
     constexpr OperandDefList B_FORM = {
-        OperandDef{.pos = 6, .bits = 26, .type = ImmediateOperandDefType{}},
-        std::nullopt, std::nullopt};
+        OperandDef{
+            .pos  = 6,
+            .bits = 24,
+            .type = ImmediateOperandDefType{.shift = 2, .isSigned = true}},
+        std::nullopt, std::nullopt, std::nullopt, std::nullopt};
 
     constexpr OperandDefList S_FORM = {
         OperandDef{.pos  = 6,
                    .bits = 5,
                    .type = DirectOperandDefType{.regType = RegisterType::GPR}},
+        std::nullopt, std::nullopt, std::nullopt, std::nullopt};
+
+    constexpr OperandDefList INDIRECT_D_FORM_FPR = {
+        OperandDef{.pos  = 6,
+                   .bits = 5,
+                   .type = DirectOperandDefType{.regType = RegisterType::FPR}},
+        OperandDef{
+            .pos  = 11,
+            .bits = 21,
+            .type = IndirectOperandDefType{.offsetPos = 16, .offsetBits = 16}},
+        std::nullopt, std::nullopt, std::nullopt};
+
+    // `frD, frA, frC, frB`, the operand order of the assembler syntax.
+    constexpr OperandDefList A_FORM = {
+        OperandDef{.pos  = 6,
+                   .bits = 5,
+                   .type = DirectOperandDefType{.regType = RegisterType::FPR}},
+        OperandDef{.pos  = 11,
+                   .bits = 5,
+                   .type = DirectOperandDefType{.regType = RegisterType::FPR}},
+        OperandDef{.pos  = 21,
+                   .bits = 5,
+                   .type = DirectOperandDefType{.regType = RegisterType::FPR}},
+        OperandDef{.pos  = 16,
+                   .bits = 5,
+                   .type = DirectOperandDefType{.regType = RegisterType::FPR}},
+        std::nullopt};
+
+    // `frD, frA, frB`, also the layout of the paired single merges.
+    constexpr OperandDefList A_FORM_AB = {
+        OperandDef{.pos  = 6,
+                   .bits = 5,
+                   .type = DirectOperandDefType{.regType = RegisterType::FPR}},
+        OperandDef{.pos  = 11,
+                   .bits = 5,
+                   .type = DirectOperandDefType{.regType = RegisterType::FPR}},
+        OperandDef{.pos  = 16,
+                   .bits = 5,
+                   .type = DirectOperandDefType{.regType = RegisterType::FPR}},
+        std::nullopt, std::nullopt};
+
+    // `frD, frA, frC`
+    constexpr OperandDefList A_FORM_AC = {
+        OperandDef{.pos  = 6,
+                   .bits = 5,
+                   .type = DirectOperandDefType{.regType = RegisterType::FPR}},
+        OperandDef{.pos  = 11,
+                   .bits = 5,
+                   .type = DirectOperandDefType{.regType = RegisterType::FPR}},
+        OperandDef{.pos  = 21,
+                   .bits = 5,
+                   .type = DirectOperandDefType{.regType = RegisterType::FPR}},
+        std::nullopt, std::nullopt};
+
+    // `frD, frB`
+    constexpr OperandDefList X_FORM_B = {
+        OperandDef{.pos  = 6,
+                   .bits = 5,
+                   .type = DirectOperandDefType{.regType = RegisterType::FPR}},
+        OperandDef{.pos  = 16,
+                   .bits = 5,
+                   .type = DirectOperandDefType{.regType = RegisterType::FPR}},
+        std::nullopt, std::nullopt, std::nullopt};
+
+    // `frD, d(rA), W, I` of the quantized paired single loads and stores. `W`
+    // only transfers ps0 and `I` picks the GQR that describes the conversion.
+    constexpr OperandDefList PSQ_FORM = {
+        OperandDef{.pos  = 6,
+                   .bits = 5,
+                   .type = DirectOperandDefType{.regType = RegisterType::FPR}},
+        OperandDef{
+            .pos  = 11,
+            .bits = 17,
+            .type = IndirectOperandDefType{.offsetPos = 20, .offsetBits = 12}},
+        OperandDef{.pos = 16, .bits = 1, .type = ImmediateOperandDefType{}},
+        OperandDef{.pos = 17, .bits = 3, .type = ImmediateOperandDefType{}},
+        std::nullopt};
+
+    // `crD, rA, rB`, the forms without `crD` compare into cr0.
+    constexpr OperandDefList CMP_FORM = {
+        OperandDef{.pos  = 6,
+                   .bits = 3,
+                   .type = DirectOperandDefType{.regType = RegisterType::CR}},
+        OperandDef{.pos  = 11,
+                   .bits = 5,
+                   .type = DirectOperandDefType{.regType = RegisterType::GPR}},
+        OperandDef{.pos  = 16,
+                   .bits = 5,
+                   .type = DirectOperandDefType{.regType = RegisterType::GPR}},
+        std::nullopt, std::nullopt};
+
+    constexpr OperandDefList CMP_FORM_CR0 = {
+        OperandDef{.pos  = 11,
+                   .bits = 5,
+                   .type = DirectOperandDefType{.regType = RegisterType::GPR}},
+        OperandDef{.pos  = 16,
+                   .bits = 5,
+                   .type = DirectOperandDefType{.regType = RegisterType::GPR}},
+        std::nullopt, std::nullopt, std::nullopt};
+
+    constexpr OperandDefList CMPI_FORM = {
+        OperandDef{.pos  = 6,
+                   .bits = 3,
+                   .type = DirectOperandDefType{.regType = RegisterType::CR}},
+        OperandDef{.pos  = 11,
+                   .bits = 5,
+                   .type = DirectOperandDefType{.regType = RegisterType::GPR}},
+        OperandDef{.pos  = 16,
+                   .bits = 16,
+                   .type = ImmediateOperandDefType{.isSigned = true}},
+        std::nullopt, std::nullopt};
+
+    constexpr OperandDefList CMPI_FORM_CR0 = {
+        OperandDef{.pos  = 11,
+                   .bits = 5,
+                   .type = DirectOperandDefType{.regType = RegisterType::GPR}},
+        OperandDef{.pos  = 16,
+                   .bits = 16,
+                   .type = ImmediateOperandDefType{.isSigned = true}},
+        std::nullopt, std::nullopt, std::nullopt};
+
+    constexpr OperandDefList CMPLI_FORM = {
+        OperandDef{.pos  = 6,
+                   .bits = 3,
+                   .type = DirectOperandDefType{.regType = RegisterType::CR}},
+        OperandDef{.pos  = 11,
+                   .bits = 5,
+                   .type = DirectOperandDefType{.regType = RegisterType::GPR}},
+        OperandDef{.pos = 16, .bits = 16, .type = ImmediateOperandDefType{}},
+        std::nullopt, std::nullopt};
+
+    constexpr OperandDefList CMPLI_FORM_CR0 = {
+        OperandDef{.pos  = 11,
+                   .bits = 5,
+                   .type = DirectOperandDefType{.regType = RegisterType::GPR}},
+        OperandDef{.pos = 16, .bits = 16, .type = ImmediateOperandDefType{}},
+        std::nullopt, std::nullopt, std::nullopt};
+
+    // `rA, rS, SH, MB, ME`, the destination is encoded second.
+    constexpr OperandDefList M_FORM = {
+        OperandDef{.pos  = 11,
+                   .bits = 5,
+                   .type = DirectOperandDefType{.regType = RegisterType::GPR}},
+        OperandDef{.pos  = 6,
+                   .bits = 5,
+                   .type = DirectOperandDefType{.regType = RegisterType::GPR}},
+        OperandDef{.pos = 16, .bits = 5, .type = ImmediateOperandDefType{}},
+        OperandDef{.pos = 21, .bits = 5, .type = ImmediateOperandDefType{}},
+        OperandDef{.pos = 26, .bits = 5, .type = ImmediateOperandDefType{}}};
+
+    constexpr OperandDefList M_FORM_RB = {
+        OperandDef{.pos  = 11,
+                   .bits = 5,
+                   .type = DirectOperandDefType{.regType = RegisterType::GPR}},
+        OperandDef{.pos  = 6,
+                   .bits = 5,
+                   .type = DirectOperandDefType{.regType = RegisterType::GPR}},
+        OperandDef{.pos  = 16,
+                   .bits = 5,
+                   .type = DirectOperandDefType{.regType = RegisterType::GPR}},
+        OperandDef{.pos = 21, .bits = 5, .type = ImmediateOperandDefType{}},
+        OperandDef{.pos = 26, .bits = 5, .type = ImmediateOperandDefType{}}};
+
+    constexpr OperandDefList MFSPR_FORM = {
+        OperandDef{.pos  = 6,
+                   .bits = 5,
+                   .type = DirectOperandDefType{.regType = RegisterType::GPR}},
+        OperandDef{.pos  = 11,
+                   .bits = 10,
+                   .type = ImmediateOperandDefType{.isSpr = true}},
+        std::nullopt, std::nullopt, std::nullopt};
+
+    constexpr OperandDefList MTSPR_FORM = {
+        OperandDef{.pos  = 11,
+                   .bits = 10,
+                   .type = ImmediateOperandDefType{.isSpr = true}},
+        OperandDef{.pos  = 6,
+                   .bits = 5,
+                   .type = DirectOperandDefType{.regType = RegisterType::GPR}},
+        std::nullopt, std::nullopt, std::nullopt};
+
+    // `BO, BI, target`
+    constexpr OperandDefList BC_FORM = {
+        OperandDef{.pos = 6, .bits = 5, .type = ImmediateOperandDefType{}},
+        OperandDef{.pos = 11, .bits = 5, .type = ImmediateOperandDefType{}},
+        OperandDef{
+            .pos  = 16,
+            .bits = 14,
+            .type = ImmediateOperandDefType{.shift = 2, .isSigned = true}},
         std::nullopt, std::nullopt};
 
-    constexpr std::array<PPCInstructionDef, 20> PPC_INSTRUCTION_TABLE = {
+    // Simplified conditional branches, which test cr0 unless a field is given.
+    constexpr OperandDefList BD_FORM = {
+        OperandDef{
+            .pos  = 16,
+            .bits = 14,
+            .type = ImmediateOperandDefType{.shift = 2, .isSigned = true}},
+        std::nullopt, std::nullopt, std::nullopt, std::nullopt};
+
+    constexpr OperandDefList BD_FORM_CR = {
+        OperandDef{.pos  = 11,
+                   .bits = 3,
+                   .type = DirectOperandDefType{.regType = RegisterType::CR}},
+        OperandDef{
+            .pos  = 16,
+            .bits = 14,
+            .type = ImmediateOperandDefType{.shift = 2, .isSigned = true}},
+        std::nullopt, std::nullopt, std::nullopt};
+
+    constexpr OperandDefList BCLR_FORM_CR = {
+        OperandDef{.pos  = 11,
+                   .bits = 3,
+                   .type = DirectOperandDefType{.regType = RegisterType::CR}},
+        std::nullopt, std::nullopt, std::nullopt, std::nullopt};
+
+    constexpr std::array<PPCInstructionDef, 130> PPC_INSTRUCTION_TABLE = {
         PPCInstructionDef{.mnemonic = PPCMnemonic::ADDIC,
                           .operands = D_FORM,
                           .mask     = 0},
@@ -60,7 +301,7 @@ namespace LibMacchiato::PPCAssembler {
                           .operands = D_FORM,
                           .mask     = 0},
         PPCInstructionDef{.mnemonic = PPCMnemonic::ADDIS,
-                          .operands = D_FORM,
+                          .operands = D_FORM_UNSIGNED,
                           .mask     = 0},
         PPCInstructionDef{
             .mnemonic = PPCMnemonic::LI,
@@ -71,8 +312,10 @@ namespace LibMacchiato::PPCAssembler {
                                             .regType = RegisterType::GPR}},
                          OperandDef{.pos  = 16,
                                     .bits = 16,
-                                    .type = ImmediateOperandDefType{}},
-                         std::nullopt},
+                                    .type =
+                                        ImmediateOperandDefType{
+                                            .isSigned = true}},
+                         std::nullopt, std::nullopt, std::nullopt},
             .mask     = 0},
         PPCInstructionDef{
             .mnemonic = PPCMnemonic::LIS,
@@ -84,10 +327,10 @@ namespace LibMacchiato::PPCAssembler {
                          OperandDef{.pos  = 16,
                                     .bits = 16,
                                     .type = ImmediateOperandDefType{}},
-                         std::nullopt},
+                         std::nullopt, std::nullopt, std::nullopt},
             .mask     = 0},
         PPCInstructionDef{.mnemonic = PPCMnemonic::ORI,
-                          .operands = D_FORM,
+                          .operands = LOGICAL_D_FORM,
                           .mask     = 0},
         PPCInstructionDef{.mnemonic = PPCMnemonic::B,
                           .operands = B_FORM,
@@ -98,69 +341,394 @@ namespace LibMacchiato::PPCAssembler {
         PPCInstructionDef{.mnemonic = PPCMnemonic::BL,
                           .operands = B_FORM,
                           .mask     = BIT_MASK_LK},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::BLA,
+                          .operands = B_FORM,
+                          .mask     = BIT_MASK_AA | BIT_MASK_LK},
         PPCInstructionDef{
             .mnemonic = PPCMnemonic::BLR,
-            .operands = {std::nullopt, std::nullopt, std::nullopt},
+            .operands = {std::nullopt, std::nullopt, std::nullopt,
+                         std::nullopt, std::nullopt},
             .mask     = BIT_MASK_LR},
         PPCInstructionDef{
             .mnemonic = PPCMnemonic::NOP,
-            .operands = {std::nullopt, std::nullopt, std::nullopt},
+            .operands = {std::nullopt, std::nullopt, std::nullopt,
+                         std::nullopt, std::nullopt},
             .mask     = 0},
         PPCInstructionDef{
             .mnemonic = PPCMnemonic::BCTR,
-            .operands = {std::nullopt, std::nullopt, std::nullopt},
-            .mask     = BIT_MASK_BI | BIT_MASK_BO | BIT_MASK_BCTR},
-        PPCInstructionDef{
-            .mnemonic = PPCMnemonic::MTSPR,
-            .operands = {OperandDef{.pos  = 12,
-                                    .bits = 10,
-                                    .type = ImmediateOperandDefType{}},
-                         OperandDef{.pos  = 6,
-                                    .bits = 5,
-                                    .type =
-                                        DirectOperandDefType{
-                                            .regType = RegisterType::GPR}},
-                         std::nullopt},
-            .mask     = BIT_MASK_MTSPR},
-        PPCInstructionDef{
-            .mnemonic = PPCMnemonic::MTCTR,
-            .operands = {OperandDef{.pos  = 6,
-                                    .bits = 5,
-                                    .type =
-                                        DirectOperandDefType{
-                                            .regType = RegisterType::GPR}},
+            .operands = {std::nullopt, std::nullopt, std::nullopt,
                          std::nullopt, std::nullopt},
-            .mask     = BIT_MASK_MTCTR | BIT_MASK_MTSPR},
-        PPCInstructionDef{
-            .mnemonic = PPCMnemonic::STW,
-            .operands = {OperandDef{.pos  = 6,
-                                    .bits = 5,
-                                    .type =
-                                        DirectOperandDefType{
-                                            .regType = RegisterType::GPR}},
-                         std::nullopt, std::nullopt},
-            .mask     = BIT_MASK_MTCTR | BIT_MASK_MTSPR},
+            .mask     = BIT_MASK_BI | BIT_MASK_BO | BIT_MASK_BCTR},
         PPCInstructionDef{
-            .mnemonic = PPCMnemonic::STWU,
-            .operands = {OperandDef{.pos  = 6,
-                                    .bits = 5,
-                                    .type =
-                                        DirectOperandDefType{
-                                            .regType = RegisterType::GPR}},
+            .mnemonic = PPCMnemonic::BCTRL,
+            .operands = {std::nullopt, std::nullopt, std::nullopt,
                          std::nullopt, std::nullopt},
-            .mask     = BIT_MASK_MTCTR | BIT_MASK_MTSPR},
+            .mask = BIT_MASK_BI | BIT_MASK_BO | BIT_MASK_BCTR | BIT_MASK_LK},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::MTSPR,
+                          .operands = MTSPR_FORM,
+                          .mask     = BIT_MASK_MTSPR},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::MTCTR,
+                          .operands = S_FORM,
+                          .mask     = BIT_MASK_MTCTR | BIT_MASK_MTSPR},
         PPCInstructionDef{.mnemonic = PPCMnemonic::LWZ,
                           .operands = INDIRECT_D_FORM,
-                          .mask     = BIT_MASK_MTCTR | BIT_MASK_MTSPR},
+                          .mask     = 0},
         PPCInstructionDef{.mnemonic = PPCMnemonic::LBZ,
                           .operands = INDIRECT_D_FORM,
-                          .mask     = BIT_MASK_MTCTR | BIT_MASK_MTSPR},
+                          .mask     = 0},
         PPCInstructionDef{.mnemonic = PPCMnemonic::STW,
                           .operands = INDIRECT_D_FORM,
-                          .mask     = BIT_MASK_MTCTR | BIT_MASK_MTSPR},
+                          .mask     = 0},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::STWU,
+                          .operands = INDIRECT_D_FORM,
+                          .mask     = 0},
         PPCInstructionDef{.mnemonic = PPCMnemonic::STB,
                           .operands = INDIRECT_D_FORM,
-                          .mask     = BIT_MASK_MTCTR | BIT_MASK_MTSPR}
-
+                          .mask     = 0},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::LFS,
+                          .operands = INDIRECT_D_FORM_FPR,
+                          .mask     = 0},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::LFSU,
+                          .operands = INDIRECT_D_FORM_FPR,
+                          .mask     = 0},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::LFD,
+                          .operands = INDIRECT_D_FORM_FPR,
+                          .mask     = 0},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::LFDU,
+                          .operands = INDIRECT_D_FORM_FPR,
+                          .mask     = 0},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::STFS,
+                          .operands = INDIRECT_D_FORM_FPR,
+                          .mask     = 0},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::STFSU,
+                          .operands = INDIRECT_D_FORM_FPR,
+                          .mask     = 0},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::STFD,
+                          .operands = INDIRECT_D_FORM_FPR,
+                          .mask     = 0},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::STFDU,
+                          .operands = INDIRECT_D_FORM_FPR,
+                          .mask     = 0},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::FADD,
+                          .operands = A_FORM_AB,
+                          .mask     = extendedOpcodeMask(21)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::FADDS,
+                          .operands = A_FORM_AB,
+                          .mask     = extendedOpcodeMask(21)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::FSUB,
+                          .operands = A_FORM_AB,
+                          .mask     = extendedOpcodeMask(20)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::FSUBS,
+                          .operands = A_FORM_AB,
+                          .mask     = extendedOpcodeMask(20)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::FMUL,
+                          .operands = A_FORM_AC,
+                          .mask     = extendedOpcodeMask(25)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::FMULS,
+                          .operands = A_FORM_AC,
+                          .mask     = extendedOpcodeMask(25)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::FDIV,
+                          .operands = A_FORM_AB,
+                          .mask     = extendedOpcodeMask(18)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::FDIVS,
+                          .operands = A_FORM_AB,
+                          .mask     = extendedOpcodeMask(18)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::FMADD,
+                          .operands = A_FORM,
+                          .mask     = extendedOpcodeMask(29)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::FMADDS,
+                          .operands = A_FORM,
+                          .mask     = extendedOpcodeMask(29)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::FMSUB,
+                          .operands = A_FORM,
+                          .mask     = extendedOpcodeMask(28)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::FMSUBS,
+                          .operands = A_FORM,
+                          .mask     = extendedOpcodeMask(28)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::FNMADD,
+                          .operands = A_FORM,
+                          .mask     = extendedOpcodeMask(31)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::FNMADDS,
+                          .operands = A_FORM,
+                          .mask     = extendedOpcodeMask(31)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::FNMSUB,
+                          .operands = A_FORM,
+                          .mask     = extendedOpcodeMask(30)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::FNMSUBS,
+                          .operands = A_FORM,
+                          .mask     = extendedOpcodeMask(30)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::FSEL,
+                          .operands = A_FORM,
+                          .mask     = extendedOpcodeMask(23)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::FRES,
+                          .operands = X_FORM_B,
+                          .mask     = extendedOpcodeMask(24)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::FRSQRTE,
+                          .operands = X_FORM_B,
+                          .mask     = extendedOpcodeMask(26)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::FMR,
+                          .operands = X_FORM_B,
+                          .mask     = extendedOpcodeMask(72)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::FNEG,
+                          .operands = X_FORM_B,
+                          .mask     = extendedOpcodeMask(40)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::FABS,
+                          .operands = X_FORM_B,
+                          .mask     = extendedOpcodeMask(264)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::FNABS,
+                          .operands = X_FORM_B,
+                          .mask     = extendedOpcodeMask(136)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::FRSP,
+                          .operands = X_FORM_B,
+                          .mask     = extendedOpcodeMask(12)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::FCTIW,
+                          .operands = X_FORM_B,
+                          .mask     = extendedOpcodeMask(14)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::FCTIWZ,
+                          .operands = X_FORM_B,
+                          .mask     = extendedOpcodeMask(15)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::PSQ_L,
+                          .operands = PSQ_FORM,
+                          .mask     = 0},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::PSQ_LU,
+                          .operands = PSQ_FORM,
+                          .mask     = 0},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::PSQ_ST,
+                          .operands = PSQ_FORM,
+                          .mask     = 0},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::PSQ_STU,
+                          .operands = PSQ_FORM,
+                          .mask     = 0},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::PS_ADD,
+                          .operands = A_FORM_AB,
+                          .mask     = extendedOpcodeMask(21)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::PS_SUB,
+                          .operands = A_FORM_AB,
+                          .mask     = extendedOpcodeMask(20)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::PS_MUL,
+                          .operands = A_FORM_AC,
+                          .mask     = extendedOpcodeMask(25)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::PS_DIV,
+                          .operands = A_FORM_AB,
+                          .mask     = extendedOpcodeMask(18)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::PS_MADD,
+                          .operands = A_FORM,
+                          .mask     = extendedOpcodeMask(29)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::PS_MSUB,
+                          .operands = A_FORM,
+                          .mask     = extendedOpcodeMask(28)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::PS_NMADD,
+                          .operands = A_FORM,
+                          .mask     = extendedOpcodeMask(31)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::PS_NMSUB,
+                          .operands = A_FORM,
+                          .mask     = extendedOpcodeMask(30)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::PS_MULS0,
+                          .operands = A_FORM_AC,
+                          .mask     = extendedOpcodeMask(12)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::PS_MULS1,
+                          .operands = A_FORM_AC,
+                          .mask     = extendedOpcodeMask(13)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::PS_MADDS0,
+                          .operands = A_FORM,
+                          .mask     = extendedOpcodeMask(14)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::PS_MADDS1,
+                          .operands = A_FORM,
+                          .mask     = extendedOpcodeMask(15)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::PS_SUM0,
+                          .operands = A_FORM,
+                          .mask     = extendedOpcodeMask(10)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::PS_SUM1,
+                          .operands = A_FORM,
+                          .mask     = extendedOpcodeMask(11)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::PS_SEL,
+                          .operands = A_FORM,
+                          .mask     = extendedOpcodeMask(23)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::PS_RES,
+                          .operands = X_FORM_B,
+                          .mask     = extendedOpcodeMask(24)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::PS_RSQRTE,
+                          .operands = X_FORM_B,
+                          .mask     = extendedOpcodeMask(26)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::PS_MR,
+                          .operands = X_FORM_B,
+                          .mask     = extendedOpcodeMask(72)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::PS_NEG,
+                          .operands = X_FORM_B,
+                          .mask     = extendedOpcodeMask(40)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::PS_ABS,
+                          .operands = X_FORM_B,
+                          .mask     = extendedOpcodeMask(264)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::PS_NABS,
+                          .operands = X_FORM_B,
+                          .mask     = extendedOpcodeMask(136)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::PS_MERGE00,
+                          .operands = A_FORM_AB,
+                          .mask     = extendedOpcodeMask(528)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::PS_MERGE01,
+                          .operands = A_FORM_AB,
+                          .mask     = extendedOpcodeMask(560)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::PS_MERGE10,
+                          .operands = A_FORM_AB,
+                          .mask     = extendedOpcodeMask(592)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::PS_MERGE11,
+                          .operands = A_FORM_AB,
+                          .mask     = extendedOpcodeMask(624)},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::CMPW,
+                          .operands = CMP_FORM,
+                          .mask     = 0},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::CMPW,
+                          .operands = CMP_FORM_CR0,
+                          .mask     = 0},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::CMPLW,
+                          .operands = CMP_FORM,
+                          .mask     = BIT_MASK_CMPL},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::CMPLW,
+                          .operands = CMP_FORM_CR0,
+                          .mask     = BIT_MASK_CMPL},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::CMPWI,
+                          .operands = CMPI_FORM,
+                          .mask     = 0},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::CMPWI,
+                          .operands = CMPI_FORM_CR0,
+                          .mask     = 0},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::CMPLWI,
+                          .operands = CMPLI_FORM,
+                          .mask     = 0},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::CMPLWI,
+                          .operands = CMPLI_FORM_CR0,
+                          .mask     = 0},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::RLWINM,
+                          .operands = M_FORM,
+                          .mask     = 0},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::RLWIMI,
+                          .operands = M_FORM,
+                          .mask     = 0},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::RLWNM,
+                          .operands = M_FORM_RB,
+                          .mask     = 0},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::MFSPR,
+                          .operands = MFSPR_FORM,
+                          .mask     = BIT_MASK_MFSPR},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::MFLR,
+                          .operands = S_FORM,
+                          .mask     = BIT_MASK_MTLR | BIT_MASK_MFSPR},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::MTLR,
+                          .operands = S_FORM,
+                          .mask     = BIT_MASK_MTLR | BIT_MASK_MTSPR},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::MFCTR,
+                          .operands = S_FORM,
+                          .mask     = BIT_MASK_MTCTR | BIT_MASK_MFSPR},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::LHZ,
+                          .operands = INDIRECT_D_FORM,
+                          .mask     = 0},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::LHZU,
+                          .operands = INDIRECT_D_FORM,
+                          .mask     = 0},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::LHA,
+                          .operands = INDIRECT_D_FORM,
+                          .mask     = 0},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::STH,
+                          .operands = INDIRECT_D_FORM,
+                          .mask     = 0},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::STHU,
+                          .operands = INDIRECT_D_FORM,
+                          .mask     = 0},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::LWZU,
+                          .operands = INDIRECT_D_FORM,
+                          .mask     = 0},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::BC,
+                          .operands = BC_FORM,
+                          .mask     = 0},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::BEQ,
+                          .operands = BD_FORM,
+                          .mask     = BIT_MASK_BO_TRUE | BIT_MASK_CR_EQ},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::BEQ,
+                          .operands = BD_FORM_CR,
+                          .mask     = BIT_MASK_BO_TRUE | BIT_MASK_CR_EQ},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::BNE,
+                          .operands = BD_FORM,
+                          .mask     = BIT_MASK_BO_FALSE | BIT_MASK_CR_EQ},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::BNE,
+                          .operands = BD_FORM_CR,
+                          .mask     = BIT_MASK_BO_FALSE | BIT_MASK_CR_EQ},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::BLT,
+                          .operands = BD_FORM,
+                          .mask     = BIT_MASK_BO_TRUE | BIT_MASK_CR_LT},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::BLT,
+                          .operands = BD_FORM_CR,
+                          .mask     = BIT_MASK_BO_TRUE | BIT_MASK_CR_LT},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::BGE,
+                          .operands = BD_FORM,
+                          .mask     = BIT_MASK_BO_FALSE | BIT_MASK_CR_LT},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::BGE,
+                          .operands = BD_FORM_CR,
+                          .mask     = BIT_MASK_BO_FALSE | BIT_MASK_CR_LT},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::BGT,
+                          .operands = BD_FORM,
+                          .mask     = BIT_MASK_BO_TRUE | BIT_MASK_CR_GT},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::BGT,
+                          .operands = BD_FORM_CR,
+                          .mask     = BIT_MASK_BO_TRUE | BIT_MASK_CR_GT},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::BLE,
+                          .operands = BD_FORM,
+                          .mask     = BIT_MASK_BO_FALSE | BIT_MASK_CR_GT},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::BLE,
+                          .operands = BD_FORM_CR,
+                          .mask     = BIT_MASK_BO_FALSE | BIT_MASK_CR_GT},
+        PPCInstructionDef{
+            .mnemonic = PPCMnemonic::BEQLR,
+            .operands = {std::nullopt, std::nullopt, std::nullopt,
+                         std::nullopt, std::nullopt},
+            .mask = BIT_MASK_BO_TRUE | BIT_MASK_CR_EQ | BIT_MASK_BCLR},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::BEQLR,
+                          .operands = BCLR_FORM_CR,
+                          .mask = BIT_MASK_BO_TRUE | BIT_MASK_CR_EQ
+                                  | BIT_MASK_BCLR},
+        PPCInstructionDef{
+            .mnemonic = PPCMnemonic::BNELR,
+            .operands = {std::nullopt, std::nullopt, std::nullopt,
+                         std::nullopt, std::nullopt},
+            .mask = BIT_MASK_BO_FALSE | BIT_MASK_CR_EQ | BIT_MASK_BCLR},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::BNELR,
+                          .operands = BCLR_FORM_CR,
+                          .mask = BIT_MASK_BO_FALSE | BIT_MASK_CR_EQ
+                                  | BIT_MASK_BCLR},
+        PPCInstructionDef{
+            .mnemonic = PPCMnemonic::BLTLR,
+            .operands = {std::nullopt, std::nullopt, std::nullopt,
+                         std::nullopt, std::nullopt},
+            .mask = BIT_MASK_BO_TRUE | BIT_MASK_CR_LT | BIT_MASK_BCLR},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::BLTLR,
+                          .operands = BCLR_FORM_CR,
+                          .mask = BIT_MASK_BO_TRUE | BIT_MASK_CR_LT
+                                  | BIT_MASK_BCLR},
+        PPCInstructionDef{
+            .mnemonic = PPCMnemonic::BGELR,
+            .operands = {std::nullopt, std::nullopt, std::nullopt,
+                         std::nullopt, std::nullopt},
+            .mask = BIT_MASK_BO_FALSE | BIT_MASK_CR_LT | BIT_MASK_BCLR},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::BGELR,
+                          .operands = BCLR_FORM_CR,
+                          .mask = BIT_MASK_BO_FALSE | BIT_MASK_CR_LT
+                                  | BIT_MASK_BCLR},
+        PPCInstructionDef{
+            .mnemonic = PPCMnemonic::BGTLR,
+            .operands = {std::nullopt, std::nullopt, std::nullopt,
+                         std::nullopt, std::nullopt},
+            .mask = BIT_MASK_BO_TRUE | BIT_MASK_CR_GT | BIT_MASK_BCLR},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::BGTLR,
+                          .operands = BCLR_FORM_CR,
+                          .mask = BIT_MASK_BO_TRUE | BIT_MASK_CR_GT
+                                  | BIT_MASK_BCLR},
+        PPCInstructionDef{
+            .mnemonic = PPCMnemonic::BLELR,
+            .operands = {std::nullopt, std::nullopt, std::nullopt,
+                         std::nullopt, std::nullopt},
+            .mask = BIT_MASK_BO_FALSE | BIT_MASK_CR_GT | BIT_MASK_BCLR},
+        PPCInstructionDef{.mnemonic = PPCMnemonic::BLELR,
+                          .operands = BCLR_FORM_CR,
+                          .mask = BIT_MASK_BO_FALSE | BIT_MASK_CR_GT
+                                  | BIT_MASK_BCLR}
     };
 } // namespace LibMacchiato::PPCAssembler
@@ -0,0 +1,574 @@
+/*
+ * libmacchiato - Front-end for the Macchiato modding environment
+ * Copyright (C) 2024 splatoon1enjoyer @ SDL Foundation
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "Error.h"
+#include "Instruction.h"
+#include "Mnemonic.h"
+#include "MnemonicTable.h"
+#include "Operand.h"
+#include "PPCData.h"
+#include "Register.h"
+
+#include <sdl-utils/Types.h>
+
+#include <cstddef>
+#include <expected>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace LibMacchiato::PPCAssembler {
+    constexpr size_t MAX_MNEMONIC_SIZE = 16;
+
+    constexpr bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    constexpr char toLower(char c) {
+        return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    constexpr std::string_view trim(std::string_view s) {
+        while (!s.empty() && isSpace(s.front()))
+            s.remove_prefix(1);
+        while (!s.empty() && isSpace(s.back()))
+            s.remove_suffix(1);
+
+        return s;
+    }
+
+    constexpr std::optional<u32> digitValue(char c) {
+        c = toLower(c);
+
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+
+        return std::nullopt;
+    }
+
+    /// Parses a decimal or `0x` prefixed hexadecimal integer with an optional
+    /// leading `-`. Negative values are returned in two's complement.
+    constexpr std::optional<u32> lexInteger(std::string_view s) {
+        bool negative = false;
+        if (s.starts_with('-')) {
+            negative = true;
+            s.remove_prefix(1);
+        }
+
+        u32 base = 10;
+        if (s.size() > 2 && s[0] == '0' && toLower(s[1]) == 'x') {
+            base = 16;
+            s.remove_prefix(2);
+        }
+
+        if (s.empty())
+            return std::nullopt;
+
+        u64 value = 0;
+        for (const char c : s) {
+            std::optional<u32> digit = digitValue(c);
+            if (!digit.has_value() || digit.value() >= base)
+                return std::nullopt;
+
+            value = value * base + digit.value();
+            if (value > 0xFFFFFFFF)
+                return std::nullopt;
+        }
+
+        if (negative) {
+            if (value > 0x80000000)
+                return std::nullopt;
+
+            return static_cast<u32>(-static_cast<s64>(value));
+        }
+
+        return static_cast<u32>(value);
+    }
+
+    /// Parses a register number prefixed by `prefix`, e.g. `r3`, `f1` or
+    /// `cr7`.
+    constexpr std::optional<Register>
+    lexRegister(std::string_view s, std::string_view prefix = "r") {
+        if (s.size() <= prefix.size())
+            return std::nullopt;
+
+        for (size_t i = 0; i < prefix.size(); i++) {
+            if (toLower(s[i]) != prefix[i])
+                return std::nullopt;
+        }
+
+        s.remove_prefix(prefix.size());
+        for (const char c : s) {
+            if (c < '0' || c > '9')
+                return std::nullopt;
+        }
+
+        std::optional<u32> registerNum = lexInteger(s);
+        if (!registerNum.has_value())
+            return std::nullopt;
+
+        return numToReg(registerNum.value());
+    }
+
+    constexpr bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+    constexpr bool isIdentifierChar(char c, bool first) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_'
+               || c == '.' || c == '$' || (!first && isDigit(c));
+    }
+
+    constexpr bool isIdentifier(std::string_view s) {
+        if (s.empty())
+            return false;
+
+        for (size_t i = 0; i < s.size(); i++) {
+            if (!isIdentifierChar(s[i], i == 0))
+                return false;
+        }
+
+        return true;
+    }
+
+    /// Whether `s` is spelled like a register, i.e. `prefix` followed by
+    /// digits, whether or not the number is in range.
+    constexpr bool looksLikeRegister(std::string_view s,
+                                     std::string_view prefix) {
+        if (s.size() <= prefix.size())
+            return false;
+
+        for (size_t i = 0; i < s.size(); i++) {
+            if (i < prefix.size() ? toLower(s[i]) != prefix[i]
+                                  : !isDigit(s[i]))
+                return false;
+        }
+
+        return true;
+    }
+
+    /// Resolver for expressions that may only contain integers.
+    struct NoSymbols {
+        constexpr std::optional<u32> operator()(std::string_view) const {
+            return std::nullopt;
+        }
+    };
+
+    /*
+     * @brief Evaluates the integer expression of an operand, in 32 bit two's
+     * complement like the rest of the assembler.
+     *
+     * sym+0x10       ; `+`, `-`, `*` and `/`, which divides signed
+     * (end-start)/4  ; parentheses
+     * -target        ; unary `-`, `+` and `~`
+     * target@ha      ; high half, plus one if the low half is negative
+     * target@h       ; high half
+     * target@l       ; low half, sign-extended as `addi` and `lwz` take it
+     *
+     * `resolve` maps the name of a symbol to its value, or to `std::nullopt`
+     * if it is undefined.
+     */
+    template <typename Resolve> struct ExpressionParser {
+        std::string_view text;
+        const Resolve&   resolve;
+        size_t           pos = 0;
+
+        constexpr std::expected<u32, AssembleError> malformed() const {
+            return std::unexpected(
+                assembleError(AssembleErrorCode::IntegerConversionFailure,
+                              this->text, this->text));
+        }
+
+        constexpr void skipSpaces() {
+            while (this->pos < this->text.size()
+                   && isSpace(this->text[this->pos]))
+                this->pos++;
+        }
+
+        constexpr bool consume(char c) {
+            this->skipSpaces();
+            if (this->pos >= this->text.size() || this->text[this->pos] != c)
+                return false;
+
+            this->pos++;
+            return true;
+        }
+
+        // Identifiers and integers are both runs of identifier characters.
+        constexpr std::string_view word() {
+            const size_t begin = this->pos;
+            while (this->pos < this->text.size()
+                   && isIdentifierChar(this->text[this->pos], false))
+                this->pos++;
+
+            return this->text.substr(begin, this->pos - begin);
+        }
+
+        constexpr std::expected<u32, AssembleError> primary() {
+            if (this->consume('(')) {
+                std::expected<u32, AssembleError> value = this->additive();
+                if (value.has_value() && !this->consume(')'))
+                    return this->malformed();
+
+                return value;
+            }
+
+            this->skipSpaces();
+            if (this->pos >= this->text.size())
+                return this->malformed();
+
+            const char first = this->text[this->pos];
+
+            if (isDigit(first)) {
+                std::optional<u32> value = lexInteger(this->word());
+                if (!value.has_value())
+                    return this->malformed();
+
+                return value.value();
+            }
+
+            if (!isIdentifierChar(first, true))
+                return this->malformed();
+
+            const std::string_view name  = this->word();
+            std::optional<u32>     value = this->resolve(name);
+            if (!value.has_value())
+                return std::unexpected(assembleError(
+                    AssembleErrorCode::UndefinedSymbol, this->text, name));
+
+            return value.value();
+        }
+
+        constexpr std::expected<u32, AssembleError> relocated() {
+            std::expected<u32, AssembleError> value = this->primary();
+            if (!value.has_value() || !this->consume('@'))
+                return value;
+
+            const std::string_view op = this->word();
+            if (op.size() == 1 && toLower(op[0]) == 'l')
+                return static_cast<u32>(
+                    static_cast<s32>(static_cast<s16>(value.value())));
+            if (op.size() == 1 && toLower(op[0]) == 'h')
+                return value.value() >> 16;
+            if (op.size() == 2 && toLower(op[0]) == 'h'
+                && toLower(op[1]) == 'a')
+                return (value.value() + 0x8000) >> 16;
+
+            return this->malformed();
+        }
+
+        constexpr std::expected<u32, AssembleError> unary() {
+            if (this->consume('+'))
+                return this->unary();
+
+            const bool negate     = this->consume('-');
+            const bool complement = !negate && this->consume('~');
+            if (!negate && !complement)
+                return this->relocated();
+
+            std::expected<u32, AssembleError> value = this->unary();
+            if (!value.has_value())
+                return value;
+
+            return negate ? 0 - value.value() : ~value.value();
+        }
+
+        constexpr std::expected<u32, AssembleError> multiplicative() {
+            std::expected<u32, AssembleError> lhs = this->unary();
+
+            while (lhs.has_value()) {
+                const bool multiply = this->consume('*');
+                if (!multiply && !this->consume('/'))
+                    break;
+
+                std::expected<u32, AssembleError> rhs = this->unary();
+                if (!rhs.has_value())
+                    return rhs;
+
+                if (multiply) {
+                    lhs = lhs.value() * rhs.value();
+                    continue;
+                }
+
+                const s32 dividend = static_cast<s32>(lhs.value());
+                const s32 divisor  = static_cast<s32>(rhs.value());
+                if (divisor == 0)
+                    return this->malformed();
+
+                // The one quotient that does not fit wraps around.
+                lhs = divisor == -1 ? 0 - lhs.value()
+                                    : static_cast<u32>(dividend / divisor);
+            }
+
+            return lhs;
+        }
+
+        constexpr std::expected<u32, AssembleError> additive() {
+            std::expected<u32, AssembleError> lhs = this->multiplicative();
+
+            while (lhs.has_value()) {
+                const bool add = this->consume('+');
+                if (!add && !this->consume('-'))
+                    break;
+
+                std::expected<u32, AssembleError> rhs = this->multiplicative();
+                if (!rhs.has_value())
+                    return rhs;
+
+                lhs = add ? lhs.value() + rhs.value()
+                          : lhs.value() - rhs.value();
+            }
+
+            return lhs;
+        }
+
+        constexpr std::expected<u32, AssembleError> evaluate() {
+            std::expected<u32, AssembleError> value = this->additive();
+            if (!value.has_value())
+                return value;
+
+            this->skipSpaces();
+            if (this->pos != this->text.size())
+                return this->malformed();
+
+            return value;
+        }
+    };
+
+    template <typename Resolve = NoSymbols>
+    constexpr std::expected<u32, AssembleError>
+    evaluateExpression(std::string_view text, const Resolve& resolve = {}) {
+        const std::string_view trimmed = trim(text);
+
+        std::expected<u32, AssembleError> value =
+            ExpressionParser<Resolve>{.text = trimmed, .resolve = resolve}
+                .evaluate();
+        if (!value.has_value())
+            return std::unexpected(
+                value.error().shifted(trimmed.data() - text.data()));
+
+        return value;
+    }
+
+    /// Whether `visit` returns `true` for any symbol `text` refers to.
+    template <typename Visit>
+    constexpr bool anyExpressionSymbol(std::string_view text, Visit visit) {
+        size_t i = 0;
+
+        while (i < text.size()) {
+            // Integers and relocation operators look like identifiers too.
+            const bool skip = isDigit(text[i]) || text[i] == '@';
+            if (!skip && !isIdentifierChar(text[i], true)) {
+                i++;
+                continue;
+            }
+
+            const size_t begin = i++;
+            while (i < text.size() && isIdentifierChar(text[i], false))
+                i++;
+
+            if (!skip && visit(text.substr(begin, i - begin)))
+                return true;
+        }
+
+        return false;
+    }
+
+    /// Whether `text` refers to any symbol, i.e. cannot be evaluated alone.
+    constexpr bool isSymbolicExpression(std::string_view text) {
+        return anyExpressionSymbol(text, [](std::string_view) { return true; });
+    }
+
+    // The parenthesis that opens the one `segment` ends with.
+    constexpr std::optional<size_t>
+    openingParenthesis(std::string_view segment) {
+        if (!segment.ends_with(')'))
+            return std::nullopt;
+
+        size_t depth = 0;
+        for (size_t i = segment.size(); i-- > 0;) {
+            if (segment[i] == ')')
+                depth++;
+            else if (segment[i] == '(' && --depth == 0)
+                return i;
+        }
+
+        return std::nullopt;
+    }
+
+    /// Lexes one operand, whose integers can be expressions over the symbols
+    /// `resolve` knows (see `ExpressionParser`).
+    template <typename Resolve = NoSymbols>
+    constexpr std::expected<Operand, AssembleError>
+    lexOperand(std::string_view segment, const Resolve& resolve = {}) {
+        if (segment.empty())
+            return std::unexpected(assembleError(
+                AssembleErrorCode::InvalidOperand, segment, segment));
+
+        // `offset(rN)`, unlike a parenthesized expression such as `(a-b)/4`.
+        if (const std::optional<size_t> open = openingParenthesis(segment);
+            open.has_value()) {
+            std::string_view baseRegisterStr = trim(segment.substr(
+                open.value() + 1, segment.size() - open.value() - 2));
+
+            if (looksLikeRegister(baseRegisterStr, "r")) {
+                std::string_view offsetStr =
+                    trim(segment.substr(0, open.value()));
+
+                std::expected<u32, AssembleError> offset =
+                    offsetStr.empty() ? 0
+                                      : evaluateExpression(offsetStr, resolve);
+                if (!offset.has_value())
+                    return std::unexpected(offset.error().shifted(
+                        offsetStr.data() - segment.data()));
+
+                std::optional<Register> reg = lexRegister(baseRegisterStr);
+                if (!reg.has_value())
+                    return std::unexpected(
+                        assembleError(AssembleErrorCode::InvalidOperand,
+                                      segment, baseRegisterStr));
+
+                return IndirectOperand{.offset = offset.value(),
+                                       .reg    = reg.value()};
+            }
+        }
+
+        for (const auto& [prefix, regType] :
+             {std::pair{std::string_view("r"), RegisterType::GPR},
+              std::pair{std::string_view("f"), RegisterType::FPR},
+              std::pair{std::string_view("cr"), RegisterType::CR}}) {
+            if (!looksLikeRegister(segment, prefix))
+                continue;
+
+            std::optional<Register> reg = lexRegister(segment, prefix);
+            if (!reg.has_value())
+                return std::unexpected(assembleError(
+                    AssembleErrorCode::InvalidOperand, segment, segment));
+
+            return DirectOperand{.regType = regType, .reg = reg.value()};
+        }
+
+        std::expected<u32, AssembleError> immediate =
+            evaluateExpression(segment, resolve);
+        if (!immediate.has_value())
+            return std::unexpected(immediate.error());
+
+        return ImmediateOperand{.value = immediate.value()};
+    }
+
+    /// Splits a single line of assembly into its mnemonic and operands. The
+    /// input is only ever viewed, never copied, and errors point into it.
+    template <typename Resolve = NoSymbols>
+    constexpr std::expected<PPCInstruction, AssembleError>
+    lexInstruction(std::string_view source, const Resolve& resolve = {}) {
+        const std::string_view instruction = trim(source);
+
+        if (instruction.empty())
+            return std::unexpected(assembleError(
+                AssembleErrorCode::EmptyInstruction, source, instruction));
+
+        size_t mnemonicEnd = 0;
+        while (mnemonicEnd < instruction.size()
+               && !isSpace(instruction[mnemonicEnd]))
+            mnemonicEnd++;
+
+        const std::string_view mnemonicStr = instruction.substr(0, mnemonicEnd);
+        if (mnemonicEnd > MAX_MNEMONIC_SIZE)
+            return std::unexpected(assembleError(
+                AssembleErrorCode::InvalidMnemonic, source, mnemonicStr));
+
+        char mnemonicBuffer[MAX_MNEMONIC_SIZE] = {};
+        for (size_t i = 0; i < mnemonicEnd; i++)
+            mnemonicBuffer[i] = toLower(instruction[i]);
+
+        std::optional<PPCMnemonic> mnemonic =
+            strToMnemonic(std::string_view(mnemonicBuffer, mnemonicEnd));
+        if (!mnemonic.has_value())
+            return std::unexpected(assembleError(
+                AssembleErrorCode::InvalidMnemonic, source, mnemonicStr));
+
+        PPCInstruction result = {.mnemonic = mnemonic.value(),
+                                 .operands = EMPTY_OPERAND_LIST};
+
+        std::string_view rest = trim(instruction.substr(mnemonicEnd));
+        size_t           i    = 0;
+
+        while (!rest.empty()) {
+            if (i >= OPERAND_NUM)
+                return std::unexpected(assembleError(
+                    AssembleErrorCode::InstructionTooLarge, source, rest));
+
+            const size_t     comma   = rest.find(',');
+            std::string_view segment = trim(rest.substr(0, comma));
+
+            std::expected<Operand, AssembleError> operand =
+                lexOperand(segment, resolve);
+            if (!operand.has_value()) {
+                AssembleError error =
+                    operand.error().shifted(segment.data() - source.data());
+                error.operand = static_cast<u8>(i);
+
+                return std::unexpected(error);
+            }
+
+            result.operands[i++] = operand.value();
+
+            if (comma == std::string_view::npos)
+                break;
+
+            rest = trim(rest.substr(comma + 1));
+            if (rest.empty()) {
+                AssembleError error = assembleError(
+                    AssembleErrorCode::InvalidOperand, source, rest);
+                error.operand = static_cast<u8>(i);
+
+                return std::unexpected(error);
+            }
+        }
+
+        return result;
+    }
+
+    /// Text of the operand at `index` of `instruction`, split like
+    /// `lexInstruction` does, for pointing errors of `encode` at it.
+    constexpr std::optional<std::string_view>
+    operandText(std::string_view instruction, size_t index) {
+        instruction = trim(instruction);
+
+        size_t mnemonicEnd = 0;
+        while (mnemonicEnd < instruction.size()
+               && !isSpace(instruction[mnemonicEnd]))
+            mnemonicEnd++;
+
+        std::string_view rest = trim(instruction.substr(mnemonicEnd));
+
+        for (size_t i = 0; !rest.empty(); i++) {
+            const size_t comma = rest.find(',');
+            if (i == index)
+                return trim(rest.substr(0, comma));
+            if (comma == std::string_view::npos)
+                break;
+
+            rest = trim(rest.substr(comma + 1));
+        }
+
+        return std::nullopt;
+    }
+} // namespace LibMacchiato::PPCAssembler
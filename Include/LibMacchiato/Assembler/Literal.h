@@ -0,0 +1,212 @@
+/*
+ * libmacchiato - Front-end for the Macchiato modding environment
+ * Copyright (C) 2024 splatoon1enjoyer @ SDL Foundation
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "Codegen.h"
+#include "Error.h"
+
+#include <sdl-utils/Types.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <expected>
+#include <optional>
+#include <string_view>
+
+namespace LibMacchiato::PPCAssembler {
+    /// String literal wrapper that can be passed as a template argument.
+    template <size_t N> struct FixedString {
+        char data[N] = {};
+
+        consteval FixedString(const char (&str)[N]) {
+            std::copy_n(str, N, this->data);
+        }
+
+        [[nodiscard]] constexpr std::string_view view() const {
+            return std::string_view(this->data, N - 1);
+        }
+    };
+
+    // Deliberately not `constexpr`: reaching it during constant evaluation
+    // turns an invalid literal into a compile error that names this function.
+    inline void invalidAssemblyLiteral() {}
+
+    /*
+     * @brief Assembles an instruction known at build time. Costs no parsing and
+     * no memo entry at runtime, and invalid instructions fail to compile.
+     *
+     * `assembleLiteral<"li r3, 1">()`
+     */
+    template <FixedString instruction> consteval u32 assembleLiteral() {
+        const std::expected<u32, AssembleError> code =
+            assembleView(instruction.view());
+
+        if (!code.has_value())
+            invalidAssemblyLiteral();
+
+        return code.value();
+    }
+
+    namespace Literals {
+        /// `"li r3, 1"_ppc`
+        template <FixedString instruction> consteval u32 operator""_ppc() {
+            return assembleLiteral<instruction>();
+        }
+    } // namespace Literals
+
+    static_assert(assembleLiteral<"nop">() == 0x60000000);
+    static_assert(assembleLiteral<"blr">() == 0x4E800020);
+    static_assert(assembleLiteral<"bctr">() == 0x4E800420);
+    static_assert(assembleLiteral<"bctrl">() == 0x4E800421);
+    static_assert(assembleLiteral<"li r3, 1">() == 0x38600001);
+    static_assert(assembleLiteral<"LI R3,1">() == 0x38600001);
+    static_assert(assembleLiteral<"lis r11, 0x1234">() == 0x3D601234);
+    static_assert(assembleLiteral<"ori r11, r11, 0x5678">() == 0x616B5678);
+    static_assert(assembleLiteral<"addi r1, r1, -16">() == 0x3821FFF0);
+    static_assert(assembleLiteral<"mtctr r11">() == 0x7D6903A6);
+    static_assert(assembleLiteral<"lwz r3, 8(r1)">() == 0x80610008);
+    static_assert(assembleLiteral<"lbz r4, -0x10(r3)">() == 0x8883FFF0);
+    static_assert(assembleLiteral<"stw r0, 4(r1)">() == 0x90010004);
+    static_assert(assembleLiteral<"stwu r1, -16(r1)">() == 0x9421FFF0);
+    static_assert(assembleLiteral<"stb r5, 0(r3)">() == 0x98A30000);
+    static_assert(assembleLiteral<"b -8">() == 0x4BFFFFF8);
+    static_assert(assembleLiteral<"ba 0x100">() == 0x48000102);
+    static_assert(assembleLiteral<"bl 0x100">() == 0x48000101);
+    static_assert(assembleLiteral<"bla 0x100">() == 0x48000103);
+    static_assert(assembleLiteral<"lfs f1, 8(r3)">() == 0xC0230008);
+    static_assert(assembleLiteral<"stfd f31, -8(r1)">() == 0xDBE1FFF8);
+    static_assert(assembleLiteral<"fmadd f1, f2, f3, f4">() == 0xFC2220FA);
+    static_assert(assembleLiteral<"fnmsubs f1, f2, f3, f4">() == 0xEC2220FC);
+    static_assert(assembleLiteral<"fmul f1, f2, f3">() == 0xFC2200F2);
+    static_assert(assembleLiteral<"fdivs f1, f2, f3">() == 0xEC221824);
+    static_assert(assembleLiteral<"fmr f1, f2">() == 0xFC201090);
+    static_assert(assembleLiteral<"fctiwz f0, f1">() == 0xFC00081E);
+    static_assert(assembleLiteral<"fres f1, f2">() == 0xEC201030);
+    static_assert(assembleLiteral<"psq_l f1, 0(r3), 0, 0">() == 0xE0230000);
+    static_assert(assembleLiteral<"psq_st f31, -0x800(r3), 1, 7">()
+                  == 0xF3E3F800);
+    static_assert(assembleLiteral<"ps_madd f1, f2, f3, f4">() == 0x102220FA);
+    static_assert(assembleLiteral<"ps_mr f1, f2">() == 0x10201090);
+    static_assert(assembleLiteral<"ps_merge00 f1, f2, f3">() == 0x10221C20);
+    static_assert(assembleLiteral<"cmpw cr1, r3, r4">() == 0x7C832000);
+    static_assert(assembleLiteral<"cmpw r3, r4">() == 0x7C032000);
+    static_assert(assembleLiteral<"cmplw r3, r4">() == 0x7C032040);
+    static_assert(assembleLiteral<"cmpwi r3, -1">() == 0x2C03FFFF);
+    static_assert(assembleLiteral<"cmplwi cr7, r3, 0xFFFF">() == 0x2B83FFFF);
+    static_assert(assembleLiteral<"rlwinm r3, r4, 2, 0, 29">() == 0x5483103A);
+    static_assert(assembleLiteral<"rlwimi r3, r4, 8, 16, 23">() == 0x5083442E);
+    static_assert(assembleLiteral<"rlwnm r3, r4, r5, 0, 31">() == 0x5C83283E);
+    static_assert(assembleLiteral<"mflr r0">() == 0x7C0802A6);
+    static_assert(assembleLiteral<"mtlr r0">() == 0x7C0803A6);
+    static_assert(assembleLiteral<"mfctr r3">() == 0x7C6902A6);
+    static_assert(assembleLiteral<"mtspr 912, r3">() == 0x7C70E3A6);
+    static_assert(assembleLiteral<"mfspr r3, 912">() == 0x7C70E2A6);
+    static_assert(assembleLiteral<"mtspr 9, r11">() == 0x7D6903A6);
+    static_assert(assembleLiteral<"lhz r3, 2(r4)">() == 0xA0640002);
+    static_assert(assembleLiteral<"lha r3, 2(r4)">() == 0xA8640002);
+    static_assert(assembleLiteral<"sth r3, -2(r1)">() == 0xB061FFFE);
+    static_assert(assembleLiteral<"lwzu r3, 4(r5)">() == 0x84650004);
+    static_assert(assembleLiteral<"lhzu r3, 2(r4)">() == 0xA4640002);
+    static_assert(assembleLiteral<"sthu r3, 2(r4)">() == 0xB4640002);
+    static_assert(assembleLiteral<"bc 12, 2, 0x10">() == 0x41820010);
+    static_assert(assembleLiteral<"beq 0x10">() == 0x41820010);
+    static_assert(assembleLiteral<"beq cr1, 0x10">() == 0x41860010);
+    static_assert(assembleLiteral<"bne 0x10">() == 0x40820010);
+    static_assert(assembleLiteral<"blt -8">() == 0x4180FFF8);
+    static_assert(assembleLiteral<"bge cr7, 8">() == 0x409C0008);
+    static_assert(assembleLiteral<"bgt 8">() == 0x41810008);
+    static_assert(assembleLiteral<"ble 8">() == 0x40810008);
+    static_assert(assembleLiteral<"beqlr">() == 0x4D820020);
+    static_assert(assembleLiteral<"bnelr cr1">() == 0x4C860020);
+    static_assert(assembleLiteral<"bltlr">() == 0x4D800020);
+    static_assert(assembleLiteral<"addi r3, r3, (0x20 - 4) / 4">()
+                  == 0x38630007);
+    static_assert(assembleLiteral<"lis r3, 0x80018000@ha">() == 0x3C608002);
+    static_assert(assembleLiteral<"addi r3, r3, 0x80018000@l">()
+                  == 0x38638000);
+    static_assert(assembleLiteral<"lwz r4, 0x80018000@l(r3)">() == 0x80838000);
+    static_assert(assembleLiteral<"b -(4 * 2)">() == 0x4BFFFFF8);
+    static_assert(assembleLiteral<"li r3, ~0">() == 0x3860FFFF);
+    static_assert([] {
+        const auto resolve = [](std::string_view name) -> std::optional<u32> {
+            if (name == "start")
+                return 0x02000000;
+            if (name == "end")
+                return 0x02000040;
+            return std::nullopt;
+        };
+
+        return evaluateExpression("start+0x10", resolve) == 0x02000010
+               && evaluateExpression("(start - end) / 4", resolve)
+                      == 0xFFFFFFF0
+               && evaluateExpression("(end+4)@h", resolve) == 0x0200
+               && assembleView("lis r3, end@ha", resolve) == 0x3C600200
+               && assembleView("stw r0, end@l(r3)", resolve) == 0x90030040
+               && !evaluateExpression("middle", resolve).has_value();
+    }());
+    static_assert(!assembleView("li r3").has_value());
+    static_assert(!assembleView("li r3, 0x10000").has_value());
+    static_assert(!assembleView("frob r3, 1").has_value());
+    static_assert(!assembleView("stw r3").has_value());
+    static_assert(!assembleView("lwz r3, r1").has_value());
+    static_assert(!assembleView("fadd f1, r2, f3").has_value());
+    static_assert(!assembleView("lfs r1, 8(r3)").has_value());
+    static_assert(!assembleView("psq_l f1, 0x1000(r3), 0, 0").has_value());
+    static_assert(!assembleView("psq_l f1, 0(r3), 0, 8").has_value());
+    static_assert(!assembleView("cmpw cr8, r3, r4").has_value());
+    static_assert(!assembleView("beq cr0, 0x8000").has_value());
+    static_assert(!assembleView("beq 2").has_value());
+    static_assert(!assembleView("li r3, 1 / 0").has_value());
+    static_assert(!assembleView("li r3, (1").has_value());
+
+    // Signed fields take -0x8000 to 0x7FFF, unsigned ones up to 0xFFFF.
+    static_assert(!assembleView("addi r3, r3, 0x8000").has_value());
+    static_assert(!assembleView("li r3, 0x8000").has_value());
+    static_assert(!assembleView("lwz r3, 0x8000(r4)").has_value());
+    static_assert(!assembleView("cmpwi r3, 0xFFFF").has_value());
+    static_assert(assembleLiteral<"addi r3, r3, -0x8000">() == 0x38638000);
+    static_assert(assembleLiteral<"lis r3, 0x8000">() == 0x3C608000);
+    static_assert(assembleLiteral<"addis r3, r3, 0xFFFF">() == 0x3C63FFFF);
+    static_assert(assembleLiteral<"ori r3, r3, 0xFFFF">() == 0x6063FFFF);
+    static_assert(assembleLiteral<"ori r3, r4, 1">() == 0x60830001);
+    static_assert(!assembleView("li r3, 1@x").has_value());
+    static_assert(!assembleView("li r3, sym").has_value());
+    static_assert(!assembleView("lwz r3, 8(r32)").has_value());
+
+    // Errors point at the text at fault.
+    static_assert([] {
+        const auto pointsAt = [](std::string_view  instruction,
+                                 AssembleErrorCode code,
+                                 std::string_view  text) {
+            const AssembleError error = assembleView(instruction).error();
+            return error.code == code && error.span.in(instruction) == text;
+        };
+
+        return pointsAt("  frob r3, 1", AssembleErrorCode::InvalidMnemonic,
+                        "frob")
+               && pointsAt("li r3, 0x10000", AssembleErrorCode::IntegerTooLarge,
+                           "0x10000")
+               && pointsAt("li r3, 4 + sym", AssembleErrorCode::UndefinedSymbol,
+                           "sym")
+               && pointsAt("li r3, 1 / 0",
+                           AssembleErrorCode::IntegerConversionFailure, "1 / 0")
+               && pointsAt("lwz r3, 8(r32)", AssembleErrorCode::IntegerTooLarge,
+                           "8(r32)")
+               && assembleView("li r3, 0x10000").error().operand == 1;
+    }());
+} // namespace LibMacchiato::PPCAssembler
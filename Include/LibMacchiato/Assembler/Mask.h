@@ -33,11 +33,29 @@ namespace LibMacchiato::PPCAssembler {
     constexpr u32 BIT_MASK_SPR1 = 0b00000000000000000000000000000000;
 
     constexpr u32 BIT_MASK_BCTR  = 0b00000000000000000000010000100000;
+    constexpr u32 BIT_MASK_BCLR  = 0b00000000000000000000000000100000;
     constexpr u32 BIT_MASK_MTSPR = 0b00000000000000000000001110100110;
+    constexpr u32 BIT_MASK_MFSPR = 0b00000000000000000000001010100110;
     constexpr u32 BIT_MASK_MTCTR = 0b00000000000010010000000000000000;
+    constexpr u32 BIT_MASK_MTLR  = 0b00000000000010000000000000000000;
+    constexpr u32 BIT_MASK_CMPL  = 0b00000000000000000000000001000000;
+
+    // BO of the conditional branches that test a single CR bit, and the bit
+    // of the CR field that they test.
+    constexpr u32 BIT_MASK_BO_TRUE  = 0b00000001100000000000000000000000;
+    constexpr u32 BIT_MASK_BO_FALSE = 0b00000000100000000000000000000000;
+    constexpr u32 BIT_MASK_CR_LT    = 0b00000000000000000000000000000000;
+    constexpr u32 BIT_MASK_CR_GT    = 0b00000000000000010000000000000000;
+    constexpr u32 BIT_MASK_CR_EQ    = 0b00000000000000100000000000000000;
 
     constexpr u32 BIT_MASK_OPCODE = (1 << OPCODE_SIZE) - 1;
 
+    /// Places the extended opcode of an A-form or X-form instruction, which
+    /// ends right before the Rc bit.
+    constexpr u32 extendedOpcodeMask(u32 extendedOpcode) {
+        return extendedOpcode << 1;
+    }
+
 
     constexpr u32 BIT_MASK_SHORT_JUMP = 0x01FFFFFC;
 } // namespace LibMacchiato::PPCAssembler
@@ -19,8 +19,9 @@
 
 #include <sdl-utils/Types.h>
 
-#include <optional>
-#include <string>
+#include <array>
+#include <cstddef>
+#include <string_view>
 
 namespace LibMacchiato::PPCAssembler {
     enum class PPCMnemonic {
@@ -30,6 +31,7 @@ namespace LibMacchiato::PPCAssembler {
         B,
         BA,
         BL,
+        BLA,
         BLR,
         LI,
         LIS,
@@ -38,14 +40,246 @@ namespace LibMacchiato::PPCAssembler {
         MTSPR,
         MTCTR,
         BCTR,
+        BCTRL,
         STW,
         STWU,
         STB,
         LWZ,
         LWZU,
         LBZ,
+        LFS,
+        LFSU,
+        LFD,
+        LFDU,
+        STFS,
+        STFSU,
+        STFD,
+        STFDU,
+        FADD,
+        FADDS,
+        FSUB,
+        FSUBS,
+        FMUL,
+        FMULS,
+        FDIV,
+        FDIVS,
+        FMADD,
+        FMADDS,
+        FMSUB,
+        FMSUBS,
+        FNMADD,
+        FNMADDS,
+        FNMSUB,
+        FNMSUBS,
+        FSEL,
+        FRES,
+        FRSQRTE,
+        FMR,
+        FNEG,
+        FABS,
+        FNABS,
+        FRSP,
+        FCTIW,
+        FCTIWZ,
+        PSQ_L,
+        PSQ_LU,
+        PSQ_ST,
+        PSQ_STU,
+        PS_ADD,
+        PS_SUB,
+        PS_MUL,
+        PS_DIV,
+        PS_MADD,
+        PS_MSUB,
+        PS_NMADD,
+        PS_NMSUB,
+        PS_MULS0,
+        PS_MULS1,
+        PS_MADDS0,
+        PS_MADDS1,
+        PS_SUM0,
+        PS_SUM1,
+        PS_SEL,
+        PS_RES,
+        PS_RSQRTE,
+        PS_MR,
+        PS_NEG,
+        PS_ABS,
+        PS_NABS,
+        PS_MERGE00,
+        PS_MERGE01,
+        PS_MERGE10,
+        PS_MERGE11,
+        CMPW,
+        CMPLW,
+        CMPWI,
+        CMPLWI,
+        RLWINM,
+        RLWIMI,
+        RLWNM,
+        MFSPR,
+        MFLR,
+        MTLR,
+        MFCTR,
+        LHZ,
+        LHZU,
+        LHA,
+        STH,
+        STHU,
+        BC,
+        BEQ,
+        BNE,
+        BLT,
+        BGE,
+        BGT,
+        BLE,
+        BEQLR,
+        BNELR,
+        BLTLR,
+        BGELR,
+        BGTLR,
+        BLELR,
     };
 
-    u32                        mnemonicToOpcode(PPCMnemonic mnemonic);
-    std::optional<PPCMnemonic> strToMnemonic(std::string& s);
+    struct MnemonicSpec {
+        std::string_view name     = {};
+        PPCMnemonic      mnemonic = {};
+        u32              opcode   = 0;
+    };
+
+    // The single source of truth for mnemonics. Entries are ordered like
+    // `PPCMnemonic` so that the table can be indexed by the enum directly.
+    constexpr auto MNEMONIC_SPECS = std::to_array<MnemonicSpec>({
+        {"addic", PPCMnemonic::ADDIC, 12},
+        {"addi", PPCMnemonic::ADDI, 14},
+        {"addis", PPCMnemonic::ADDIS, 15},
+        {"b", PPCMnemonic::B, 18},
+        {"ba", PPCMnemonic::BA, 18},
+        {"bl", PPCMnemonic::BL, 18},
+        {"bla", PPCMnemonic::BLA, 18},
+        {"blr", PPCMnemonic::BLR, 19},
+        {"li", PPCMnemonic::LI, 14},
+        {"lis", PPCMnemonic::LIS, 15},
+        {"ori", PPCMnemonic::ORI, 24},
+        {"nop", PPCMnemonic::NOP, 24},
+        {"mtspr", PPCMnemonic::MTSPR, 31},
+        {"mtctr", PPCMnemonic::MTCTR, 31},
+        {"bctr", PPCMnemonic::BCTR, 19},
+        {"bctrl", PPCMnemonic::BCTRL, 19},
+        {"stw", PPCMnemonic::STW, 36},
+        {"stwu", PPCMnemonic::STWU, 37},
+        {"stb", PPCMnemonic::STB, 38},
+        {"lwz", PPCMnemonic::LWZ, 32},
+        {"lwzu", PPCMnemonic::LWZU, 33},
+        {"lbz", PPCMnemonic::LBZ, 34},
+        {"lfs", PPCMnemonic::LFS, 48},
+        {"lfsu", PPCMnemonic::LFSU, 49},
+        {"lfd", PPCMnemonic::LFD, 50},
+        {"lfdu", PPCMnemonic::LFDU, 51},
+        {"stfs", PPCMnemonic::STFS, 52},
+        {"stfsu", PPCMnemonic::STFSU, 53},
+        {"stfd", PPCMnemonic::STFD, 54},
+        {"stfdu", PPCMnemonic::STFDU, 55},
+        {"fadd", PPCMnemonic::FADD, 63},
+        {"fadds", PPCMnemonic::FADDS, 59},
+        {"fsub", PPCMnemonic::FSUB, 63},
+        {"fsubs", PPCMnemonic::FSUBS, 59},
+        {"fmul", PPCMnemonic::FMUL, 63},
+        {"fmuls", PPCMnemonic::FMULS, 59},
+        {"fdiv", PPCMnemonic::FDIV, 63},
+        {"fdivs", PPCMnemonic::FDIVS, 59},
+        {"fmadd", PPCMnemonic::FMADD, 63},
+        {"fmadds", PPCMnemonic::FMADDS, 59},
+        {"fmsub", PPCMnemonic::FMSUB, 63},
+        {"fmsubs", PPCMnemonic::FMSUBS, 59},
+        {"fnmadd", PPCMnemonic::FNMADD, 63},
+        {"fnmadds", PPCMnemonic::FNMADDS, 59},
+        {"fnmsub", PPCMnemonic::FNMSUB, 63},
+        {"fnmsubs", PPCMnemonic::FNMSUBS, 59},
+        {"fsel", PPCMnemonic::FSEL, 63},
+        {"fres", PPCMnemonic::FRES, 59},
+        {"frsqrte", PPCMnemonic::FRSQRTE, 63},
+        {"fmr", PPCMnemonic::FMR, 63},
+        {"fneg", PPCMnemonic::FNEG, 63},
+        {"fabs", PPCMnemonic::FABS, 63},
+        {"fnabs", PPCMnemonic::FNABS, 63},
+        {"frsp", PPCMnemonic::FRSP, 63},
+        {"fctiw", PPCMnemonic::FCTIW, 63},
+        {"fctiwz", PPCMnemonic::FCTIWZ, 63},
+        {"psq_l", PPCMnemonic::PSQ_L, 56},
+        {"psq_lu", PPCMnemonic::PSQ_LU, 57},
+        {"psq_st", PPCMnemonic::PSQ_ST, 60},
+        {"psq_stu", PPCMnemonic::PSQ_STU, 61},
+        {"ps_add", PPCMnemonic::PS_ADD, 4},
+        {"ps_sub", PPCMnemonic::PS_SUB, 4},
+        {"ps_mul", PPCMnemonic::PS_MUL, 4},
+        {"ps_div", PPCMnemonic::PS_DIV, 4},
+        {"ps_madd", PPCMnemonic::PS_MADD, 4},
+        {"ps_msub", PPCMnemonic::PS_MSUB, 4},
+        {"ps_nmadd", PPCMnemonic::PS_NMADD, 4},
+        {"ps_nmsub", PPCMnemonic::PS_NMSUB, 4},
+        {"ps_muls0", PPCMnemonic::PS_MULS0, 4},
+        {"ps_muls1", PPCMnemonic::PS_MULS1, 4},
+        {"ps_madds0", PPCMnemonic::PS_MADDS0, 4},
+        {"ps_madds1", PPCMnemonic::PS_MADDS1, 4},
+        {"ps_sum0", PPCMnemonic::PS_SUM0, 4},
+        {"ps_sum1", PPCMnemonic::PS_SUM1, 4},
+        {"ps_sel", PPCMnemonic::PS_SEL, 4},
+        {"ps_res", PPCMnemonic::PS_RES, 4},
+        {"ps_rsqrte", PPCMnemonic::PS_RSQRTE, 4},
+        {"ps_mr", PPCMnemonic::PS_MR, 4},
+        {"ps_neg", PPCMnemonic::PS_NEG, 4},
+        {"ps_abs", PPCMnemonic::PS_ABS, 4},
+        {"ps_nabs", PPCMnemonic::PS_NABS, 4},
+        {"ps_merge00", PPCMnemonic::PS_MERGE00, 4},
+        {"ps_merge01", PPCMnemonic::PS_MERGE01, 4},
+        {"ps_merge10", PPCMnemonic::PS_MERGE10, 4},
+        {"ps_merge11", PPCMnemonic::PS_MERGE11, 4},
+        {"cmpw", PPCMnemonic::CMPW, 31},
+        {"cmplw", PPCMnemonic::CMPLW, 31},
+        {"cmpwi", PPCMnemonic::CMPWI, 11},
+        {"cmplwi", PPCMnemonic::CMPLWI, 10},
+        {"rlwinm", PPCMnemonic::RLWINM, 21},
+        {"rlwimi", PPCMnemonic::RLWIMI, 20},
+        {"rlwnm", PPCMnemonic::RLWNM, 23},
+        {"mfspr", PPCMnemonic::MFSPR, 31},
+        {"mflr", PPCMnemonic::MFLR, 31},
+        {"mtlr", PPCMnemonic::MTLR, 31},
+        {"mfctr", PPCMnemonic::MFCTR, 31},
+        {"lhz", PPCMnemonic::LHZ, 40},
+        {"lhzu", PPCMnemonic::LHZU, 41},
+        {"lha", PPCMnemonic::LHA, 42},
+        {"sth", PPCMnemonic::STH, 44},
+        {"sthu", PPCMnemonic::STHU, 45},
+        {"bc", PPCMnemonic::BC, 16},
+        {"beq", PPCMnemonic::BEQ, 16},
+        {"bne", PPCMnemonic::BNE, 16},
+        {"blt", PPCMnemonic::BLT, 16},
+        {"bge", PPCMnemonic::BGE, 16},
+        {"bgt", PPCMnemonic::BGT, 16},
+        {"ble", PPCMnemonic::BLE, 16},
+        {"beqlr", PPCMnemonic::BEQLR, 19},
+        {"bnelr", PPCMnemonic::BNELR, 19},
+        {"bltlr", PPCMnemonic::BLTLR, 19},
+        {"bgelr", PPCMnemonic::BGELR, 19},
+        {"bgtlr", PPCMnemonic::BGTLR, 19},
+        {"blelr", PPCMnemonic::BLELR, 19},
+    });
+
+    static_assert([] {
+        for (size_t i = 0; i < MNEMONIC_SPECS.size(); i++) {
+            if (static_cast<size_t>(MNEMONIC_SPECS[i].mnemonic) != i)
+                return false;
+        }
+
+        return true;
+    }());
+
+    constexpr u32 mnemonicToOpcode(PPCMnemonic mnemonic) {
+        return MNEMONIC_SPECS[static_cast<size_t>(mnemonic)].opcode;
+    }
+
+    constexpr std::string_view mnemonicToStr(PPCMnemonic mnemonic) {
+        return MNEMONIC_SPECS[static_cast<size_t>(mnemonic)].name;
+    }
 } // namespace LibMacchiato::PPCAssembler
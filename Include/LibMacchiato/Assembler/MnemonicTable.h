@@ -0,0 +1,148 @@
+/*
+ * libmacchiato - Front-end for the Macchiato modding environment
+ * Copyright (C) 2024 splatoon1enjoyer @ SDL Foundation
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "InstructionDefTable.h"
+#include "Mnemonic.h"
+#include "Operand.h"
+#include "PerfectHash.h"
+
+#include <sdl-utils/Types.h>
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+namespace LibMacchiato::PPCAssembler {
+    // A variant of a mnemonic, identified by the shape of its operands.
+    struct DefinitionEntry {
+        OperandSignature signature  = 0;
+        size_t           definition = 0;
+    };
+
+    // `PPC_INSTRUCTION_TABLE` indices grouped by mnemonic, so that every
+    // overload of a mnemonic is a contiguous range.
+    constexpr std::array<DefinitionEntry, PPC_INSTRUCTION_TABLE.size()>
+        MNEMONIC_DEFINITIONS = [] {
+            std::array<DefinitionEntry, PPC_INSTRUCTION_TABLE.size()> entries =
+                {};
+            size_t next = 0;
+
+            for (const auto& spec : MNEMONIC_SPECS) {
+                for (size_t i = 0; i < PPC_INSTRUCTION_TABLE.size(); i++) {
+                    if (PPC_INSTRUCTION_TABLE[i].mnemonic == spec.mnemonic)
+                        entries[next++] = DefinitionEntry{
+                            .signature = operandDefSignature(
+                                PPC_INSTRUCTION_TABLE[i].operands),
+                            .definition = i};
+                }
+            }
+
+            return entries;
+        }();
+
+    struct MnemonicInfo {
+        PPCMnemonic mnemonic = {};
+        u32         opcode   = 0;
+
+        // Range of this mnemonic's variants in `MNEMONIC_DEFINITIONS`.
+        size_t definitionBegin = 0;
+        size_t definitionCount = 0;
+    };
+
+    constexpr std::array<MnemonicInfo, MNEMONIC_SPECS.size()> MNEMONIC_INFO =
+        [] {
+            std::array<MnemonicInfo, MNEMONIC_SPECS.size()> infos = {};
+            size_t next = 0;
+
+            for (size_t i = 0; i < MNEMONIC_SPECS.size(); i++) {
+                infos[i] = MnemonicInfo{.mnemonic = MNEMONIC_SPECS[i].mnemonic,
+                                        .opcode   = MNEMONIC_SPECS[i].opcode,
+                                        .definitionBegin = next,
+                                        .definitionCount = 0};
+
+                while (next < MNEMONIC_DEFINITIONS.size()
+                       && PPC_INSTRUCTION_TABLE[MNEMONIC_DEFINITIONS[next]
+                                                    .definition]
+                                  .mnemonic
+                              == MNEMONIC_SPECS[i].mnemonic) {
+                    infos[i].definitionCount++;
+                    next++;
+                }
+            }
+
+            return infos;
+        }();
+
+    // Two variants of a mnemonic with the same operand shape could never be
+    // told apart.
+    static_assert([] {
+        for (const auto& info : MNEMONIC_INFO) {
+            const size_t end = info.definitionBegin + info.definitionCount;
+
+            for (size_t i = info.definitionBegin; i < end; i++) {
+                for (size_t j = i + 1; j < end; j++) {
+                    if (MNEMONIC_DEFINITIONS[i].signature
+                        == MNEMONIC_DEFINITIONS[j].signature)
+                        return false;
+                }
+            }
+        }
+
+        return true;
+    }());
+
+    constexpr PerfectHash<MNEMONIC_SPECS.size()> MNEMONIC_HASH =
+        buildPerfectHash([] {
+            std::array<std::string_view, MNEMONIC_SPECS.size()> names = {};
+
+            for (size_t i = 0; i < MNEMONIC_SPECS.size(); i++)
+                names[i] = MNEMONIC_SPECS[i].name;
+
+            return names;
+        }());
+
+    /// Constant time lookup of a lowercase mnemonic.
+    constexpr const MnemonicInfo* lookupMnemonic(std::string_view name) {
+        std::optional<size_t> index = MNEMONIC_HASH.find(name);
+        if (!index.has_value())
+            return nullptr;
+
+        return &MNEMONIC_INFO[index.value()];
+    }
+
+    constexpr std::optional<PPCMnemonic> strToMnemonic(std::string_view s) {
+        const MnemonicInfo* info = lookupMnemonic(s);
+        if (!info)
+            return std::nullopt;
+
+        return info->mnemonic;
+    }
+
+    static_assert([] {
+        for (const auto& spec : MNEMONIC_SPECS) {
+            if (strToMnemonic(spec.name) != spec.mnemonic)
+                return false;
+        }
+
+        return !strToMnemonic("").has_value()
+               && !strToMnemonic("bx").has_value()
+               && !strToMnemonic("addicc").has_value();
+    }());
+} // namespace LibMacchiato::PPCAssembler
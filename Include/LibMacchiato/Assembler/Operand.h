@@ -23,6 +23,7 @@
 #include <sdl-utils/Types.h>
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
 #include <optional>
 #include <variant>
@@ -47,8 +48,85 @@ namespace LibMacchiato::PPCAssembler {
     typedef std::array<std::optional<Operand>, OPERAND_NUM> OperandList;
 
     constexpr OperandList EMPTY_OPERAND_LIST = {std::nullopt, std::nullopt,
+                                                std::nullopt, std::nullopt,
                                                 std::nullopt};
 
+    // Every operand slot is described by `OPERAND_KIND_BITS` bits, so the
+    // operand shape of a whole instruction fits into one integer that can be
+    // compared against the shapes of the instruction definitions.
+    enum class OperandKind : u32 {
+        None,
+        Immediate,
+        GPR,
+        FPR,
+        Indirect,
+        CR,
+    };
+
+    constexpr size_t OPERAND_KIND_BITS = 3;
+
+    typedef u32 OperandSignature;
+
+    static_assert(OPERAND_NUM * OPERAND_KIND_BITS
+                  <= sizeof(OperandSignature) * 8);
+
+    constexpr OperandKind regTypeToOperandKind(RegisterType regType) {
+        switch (regType) {
+        case RegisterType::GPR:
+            return OperandKind::GPR;
+        case RegisterType::FPR:
+            return OperandKind::FPR;
+        case RegisterType::CR:
+            return OperandKind::CR;
+        }
+
+        return OperandKind::None;
+    }
+
+    constexpr OperandKind operandKind(const Operand& operand) {
+        if (auto direct = std::get_if<DirectOperand>(&operand))
+            return regTypeToOperandKind(direct->regType);
+        if (std::holds_alternative<IndirectOperand>(operand))
+            return OperandKind::Indirect;
+
+        return OperandKind::Immediate;
+    }
+
+    constexpr OperandKind operandDefKind(const OperandDef& operandDef) {
+        if (auto direct = std::get_if<DirectOperandDefType>(&operandDef.type))
+            return regTypeToOperandKind(direct->regType);
+        if (std::holds_alternative<IndirectOperandDefType>(operandDef.type))
+            return OperandKind::Indirect;
+
+        return OperandKind::Immediate;
+    }
+
+    constexpr OperandSignature operandSignature(const OperandList& operands) {
+        OperandSignature signature = 0;
+
+        for (size_t i = 0; i < OPERAND_NUM; i++) {
+            if (operands[i].has_value())
+                signature |= static_cast<u32>(operandKind(operands[i].value()))
+                             << (i * OPERAND_KIND_BITS);
+        }
+
+        return signature;
+    }
+
+    constexpr OperandSignature
+    operandDefSignature(const OperandDefList& operandDefs) {
+        OperandSignature signature = 0;
+
+        for (size_t i = 0; i < OPERAND_NUM; i++) {
+            if (operandDefs[i].has_value())
+                signature |=
+                    static_cast<u32>(operandDefKind(operandDefs[i].value()))
+                    << (i * OPERAND_KIND_BITS);
+        }
+
+        return signature;
+    }
+
     constexpr bool operandIsEqWithDef(const Operand&    operand,
                                       const OperandDef& operandDef) {
         if (std::holds_alternative<ImmediateOperand>(operand)
@@ -34,7 +34,18 @@ namespace LibMacchiato::PPCAssembler {
         size_t offsetBits = 0;
     };
 
-    struct ImmediateOperandDefType {};
+    struct ImmediateOperandDefType {
+        // Low bits that are implicitly zero and not encoded, e.g. the two
+        // bits of word aligned branch displacements.
+        size_t shift = 0;
+
+        // Whether the field is sign-extended when it gets decoded.
+        bool isSigned = false;
+
+        // Special purpose register numbers are encoded with their two 5 bit
+        // halves swapped.
+        bool isSpr = false;
+    };
 
     typedef std::variant<DirectOperandDefType, IndirectOperandDefType,
                          ImmediateOperandDefType>
@@ -20,6 +20,6 @@
 #include <cstddef>
 
 namespace LibMacchiato::PPCAssembler {
-    constexpr size_t OPERAND_NUM = 3;
+    constexpr size_t OPERAND_NUM = 5;
     const size_t     OPCODE_SIZE = 6;
 } // namespace LibMacchiato::PPCAssembler
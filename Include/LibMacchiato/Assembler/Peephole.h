@@ -0,0 +1,445 @@
+/*
+ * libmacchiato - Front-end for the Macchiato modding environment
+ * Copyright (C) 2024 splatoon1enjoyer @ SDL Foundation
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "Codegen.h"
+#include "Disassembler.h"
+#include "Emitter.h"
+#include "Instruction.h"
+#include "Mnemonic.h"
+#include "Operand.h"
+#include "Range.h"
+#include "Register.h"
+
+#include <sdl-utils/Types.h>
+
+#include <cstddef>
+#include <expected>
+#include <optional>
+#include <variant>
+#include <vector>
+
+// Cleans up the words of hooks and trampolines once they are concatenated
+// and their address is known. Instructions are recognized with
+// `disassemble`, so the pass only ever sees what the encoder can produce.
+namespace LibMacchiato::PPCAssembler {
+    struct PeepholeStats {
+        // `lis/ori` pairs whose value fits into `li` or `lis`.
+        size_t foldedLoads = 0;
+        // `mtctr` of the value the count register already holds.
+        size_t removedCtrLoads = 0;
+        // Jumps and calls through the count register that got shorter.
+        size_t shortenedJumps = 0;
+        size_t wordsSaved     = 0;
+    };
+
+    enum class PeepholeItemType {
+        Word,
+        // A relative branch, re-encoded from its absolute target.
+        Branch,
+        // A `lis/ori` pair replaced by `li32`.
+        Load,
+        // `li32 r11` followed by `mtctr r11` and `bctr` or `bctrl`.
+        Jump,
+        Removed,
+    };
+
+    struct PeepholeItem {
+        PeepholeItemType type        = PeepholeItemType::Word;
+        PPCInstruction   instruction = {};
+
+        // Target of branches and jumps, value of loads.
+        u32      value = 0;
+        Register reg   = Register::R0;
+        bool     link  = false;
+
+        // First word and number of words in the input, then in the output.
+        size_t index = 0;
+        size_t words = 0;
+        size_t size  = 0;
+    };
+
+    constexpr bool isRelativeBranch(PPCMnemonic mnemonic) {
+        switch (mnemonic) {
+        case PPCMnemonic::B:
+        case PPCMnemonic::BL:
+        case PPCMnemonic::BC:
+        case PPCMnemonic::BEQ:
+        case PPCMnemonic::BNE:
+        case PPCMnemonic::BLT:
+        case PPCMnemonic::BGE:
+        case PPCMnemonic::BGT:
+        case PPCMnemonic::BLE:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    /// Whether `mnemonic` may leave the sequence or use the count register.
+    constexpr bool isBranch(PPCMnemonic mnemonic) {
+        switch (mnemonic) {
+        case PPCMnemonic::BA:
+        case PPCMnemonic::BLA:
+        case PPCMnemonic::BLR:
+        case PPCMnemonic::BCTR:
+        case PPCMnemonic::BCTRL:
+        case PPCMnemonic::BEQLR:
+        case PPCMnemonic::BNELR:
+        case PPCMnemonic::BLTLR:
+        case PPCMnemonic::BGELR:
+        case PPCMnemonic::BGTLR:
+        case PPCMnemonic::BLELR:
+            return true;
+        default:
+            return isRelativeBranch(mnemonic);
+        }
+    }
+
+    /// Index of the displacement of a relative branch, its last operand.
+    constexpr size_t displacementIndex(const PPCInstruction& instruction) {
+        size_t index = 0;
+
+        for (size_t i = 0; i < OPERAND_NUM; i++) {
+            if (instruction.operands[i].has_value())
+                index = i;
+        }
+
+        return index;
+    }
+
+    constexpr u32 immediateAt(const PPCInstruction& instruction,
+                              size_t                index) {
+        return std::get<ImmediateOperand>(
+                   instruction.operands[index].value())
+            .value;
+    }
+
+    constexpr std::optional<Register>
+    gprAt(const PPCInstruction& instruction, size_t index) {
+        if (!instruction.operands[index].has_value())
+            return std::nullopt;
+
+        auto direct =
+            std::get_if<DirectOperand>(&instruction.operands[index].value());
+        if (!direct || direct->regType != RegisterType::GPR)
+            return std::nullopt;
+
+        return direct->reg;
+    }
+
+    /// Whether any operand of `instruction` reads or writes the GPR `reg`.
+    constexpr bool mentionsGpr(const PPCInstruction& instruction,
+                               Register              reg) {
+        for (const auto& operand : instruction.operands) {
+            if (!operand.has_value())
+                continue;
+
+            if (auto direct = std::get_if<DirectOperand>(&operand.value())) {
+                if (direct->regType == RegisterType::GPR && direct->reg == reg)
+                    return true;
+            } else if (auto indirect =
+                           std::get_if<IndirectOperand>(&operand.value())) {
+                if (indirect->reg == reg)
+                    return true;
+            }
+        }
+
+        return false;
+    }
+
+    /*
+     * @brief Rewrites `code`, which is going to be placed at `address`, into
+     * an equivalent shorter sequence:
+     *
+     * lis r3, 0                 ->  li r3, 0x10
+     * ori r3, r3, 0x10
+     *
+     * mtctr r12                 ->  mtctr r12
+     * stw r0, 4(r1)                 stw r0, 4(r1)
+     * mtctr r12                     bctrl
+     * bctrl
+     *
+     * lis r11, 0x0200           ->  b 0x1000       ; or `ba`, `lis/mtctr/bctr`
+     * ori r11, r11, 0x1000
+     * mtctr r11
+     * bctr
+     *
+     * Relative branches are re-encoded so that they keep their absolute
+     * target, which is moved along when it lies within the sequence. Words
+     * that are the target of such a branch are never merged away.
+     *
+     * The sequence must only be entered at its first word, must not compute
+     * addresses within itself other than through relative branches, and
+     * `r11` and the count register are expected to be dead after a jump, as
+     * they are for every jump the `Emitter` produces. If any relative branch
+     * cannot be decoded or no longer reaches its target, `code` is left as it
+     * is and nothing is reported.
+     */
+    constexpr PeepholeStats optimizeSequence(std::vector<u32>& code,
+                                             u32               address) {
+        const size_t count = code.size();
+        const u32    end   = address + static_cast<u32>(count * sizeof(u32));
+
+        std::vector<std::optional<PPCInstruction>> decoded(count);
+        std::vector<bool>                          isTarget(count, false);
+
+        const auto isInside = [&](u32 target) {
+            return target >= address && target < end;
+        };
+
+        for (size_t i = 0; i < count; i++) {
+            decoded[i] = disassemble(code[i]);
+
+            // Primary opcodes of `bc` and `b`. A form the table does not know,
+            // e.g. `bcl`, could not be moved along with its target.
+            const u32 opcode = code[i] >> 26;
+            if (!decoded[i].has_value()) {
+                if (opcode == 16 || opcode == 18)
+                    return {};
+                continue;
+            }
+
+            if (!isRelativeBranch(decoded[i]->mnemonic))
+                continue;
+
+            const u32 target =
+                address + static_cast<u32>(i * sizeof(u32))
+                + immediateAt(decoded[i].value(),
+                              displacementIndex(decoded[i].value()));
+            if (isInside(target))
+                isTarget[(target - address) / sizeof(u32)] = true;
+        }
+
+        const auto mnemonicAt = [&](size_t i) -> std::optional<PPCMnemonic> {
+            if (i >= count || !decoded[i].has_value())
+                return std::nullopt;
+
+            return decoded[i]->mnemonic;
+        };
+
+        // Value and size of the `li`, `lis` or `lis/ori` at `i` into `reg`.
+        struct MatchedLoad {
+            u32    value = 0;
+            size_t words = 0;
+        };
+        const auto matchLoad = [&](size_t i, Register reg)
+            -> std::optional<MatchedLoad> {
+            const PPCMnemonic mnemonic = decoded[i]->mnemonic;
+            if ((mnemonic != PPCMnemonic::LI && mnemonic != PPCMnemonic::LIS)
+                || gprAt(decoded[i].value(), 0) != reg)
+                return std::nullopt;
+
+            const u32 immediate = immediateAt(decoded[i].value(), 1);
+            if (mnemonic == PPCMnemonic::LI)
+                return MatchedLoad{.value = immediate, .words = 1};
+
+            const u32 high = (immediate & 0xFFFF) << 16;
+            if (mnemonicAt(i + 1) != PPCMnemonic::ORI || isTarget[i + 1]
+                || gprAt(decoded[i + 1].value(), 0) != reg
+                || gprAt(decoded[i + 1].value(), 1) != reg)
+                return MatchedLoad{.value = high, .words = 1};
+
+            return MatchedLoad{
+                .value = high
+                         | (immediateAt(decoded[i + 1].value(), 2) & 0xFFFF),
+                .words = 2};
+        };
+
+        PeepholeStats             stats = {};
+        std::vector<PeepholeItem> items = {};
+
+        for (size_t i = 0; i < count;) {
+            PeepholeItem item = {.index = i, .words = 1, .size = 1};
+
+            const std::optional<PPCMnemonic> mnemonic = mnemonicAt(i);
+            if (!mnemonic.has_value()) {
+                items.push_back(item);
+                i++;
+                continue;
+            }
+
+            const std::optional<Register> dst = gprAt(decoded[i].value(), 0);
+            const std::optional<MatchedLoad> load =
+                dst.has_value() ? matchLoad(i, dst.value()) : std::nullopt;
+
+            if (load.has_value() && dst == Register::R11) {
+                const size_t mtctr  = i + load->words;
+                const auto   branch = mnemonicAt(mtctr + 1);
+
+                if (mnemonicAt(mtctr) == PPCMnemonic::MTCTR
+                    && gprAt(decoded[mtctr].value(), 0) == Register::R11
+                    && (branch == PPCMnemonic::BCTR
+                        || branch == PPCMnemonic::BCTRL)
+                    && !isTarget[mtctr] && !isTarget[mtctr + 1]) {
+                    // Its address would be stale once the sequence shrinks.
+                    if (isInside(load->value))
+                        return {};
+
+                    item.type  = PeepholeItemType::Jump;
+                    item.value = load->value;
+                    item.link  = branch == PPCMnemonic::BCTRL;
+                    item.words = load->words + 2;
+                    item.size  = item.words;
+                    items.push_back(item);
+                    i += item.words;
+                    continue;
+                }
+            }
+
+            if (load.has_value() && load->words == 2
+                && loadImmediateSize(load->value) == 1) {
+                item.type  = PeepholeItemType::Load;
+                item.value = load->value;
+                item.reg   = dst.value();
+                item.words = 2;
+                items.push_back(item);
+                stats.foldedLoads++;
+                i += 2;
+                continue;
+            }
+
+            if (isRelativeBranch(mnemonic.value())) {
+                item.type        = PeepholeItemType::Branch;
+                item.instruction = decoded[i].value();
+                item.value       = address + static_cast<u32>(i * sizeof(u32))
+                             + immediateAt(item.instruction,
+                                           displacementIndex(item.instruction));
+            }
+
+            items.push_back(item);
+            i++;
+        }
+
+        // A `mtctr` of the same register is redundant as long as nothing in
+        // between can branch, touch that register or be branched to.
+        for (size_t i = 0; i < items.size(); i++) {
+            if (items[i].type != PeepholeItemType::Word
+                || mnemonicAt(items[i].index) != PPCMnemonic::MTCTR)
+                continue;
+
+            const Register src =
+                gprAt(decoded[items[i].index].value(), 0).value();
+
+            for (size_t j = i + 1; j < items.size(); j++) {
+                PeepholeItem& item = items[j];
+                if (isTarget[item.index])
+                    break;
+
+                if (item.type == PeepholeItemType::Load) {
+                    if (item.reg == src)
+                        break;
+                    continue;
+                }
+
+                const std::optional<PPCMnemonic> mnemonic =
+                    mnemonicAt(item.index);
+                if (item.type != PeepholeItemType::Word
+                    || !mnemonic.has_value())
+                    break;
+
+                if (mnemonic == PPCMnemonic::MTCTR
+                    && gprAt(decoded[item.index].value(), 0) == src) {
+                    item.type = PeepholeItemType::Removed;
+                    item.size = 0;
+                    stats.removedCtrLoads++;
+                    continue;
+                }
+
+                if (isBranch(mnemonic.value()) || mnemonic == PPCMnemonic::MTCTR
+                    || mnemonic == PPCMnemonic::MTSPR
+                    || mentionsGpr(decoded[item.index].value(), src))
+                    break;
+            }
+        }
+
+        // Jumps only ever shrink, so this settles like block relaxation.
+        std::vector<u32> addresses(count + 1, end);
+        for (bool changed = true; changed;) {
+            changed = false;
+
+            u32 pc = address;
+            for (auto& item : items) {
+                addresses[item.index] = pc;
+
+                if (item.type == PeepholeItemType::Jump) {
+                    const size_t size =
+                        relativeBranchFits(pc, item.value)
+                                || absoluteBranchFits(item.value)
+                            ? 1
+                            : indirectBranchSize(item.value);
+
+                    if (size < item.size) {
+                        item.size = size;
+                        changed   = true;
+                    }
+                }
+
+                pc += static_cast<u32>(item.size * sizeof(u32));
+            }
+            addresses[count] = pc;
+        }
+
+        std::vector<u32> result((addresses[count] - address) / sizeof(u32));
+        Emitter          emitter(result, address);
+
+        for (auto& item : items) {
+            switch (item.type) {
+            case PeepholeItemType::Word:
+                emitter.word(code[item.index]);
+                break;
+            case PeepholeItemType::Branch: {
+                const u32 target =
+                    isInside(item.value)
+                        ? addresses[(item.value - address) / sizeof(u32)]
+                        : item.value;
+
+                item.instruction.operands[displacementIndex(item.instruction)] =
+                    ImmediateOperand{.value = target - emitter.pc()};
+                emitter.instruction(item.instruction);
+                break;
+            }
+            case PeepholeItemType::Load:
+                emitter.li32(item.reg, item.value);
+                break;
+            case PeepholeItemType::Jump:
+                if (item.link)
+                    emitter.call(item.value);
+                else
+                    emitter.jmp(item.value);
+
+                if (item.size < item.words)
+                    stats.shortenedJumps++;
+                break;
+            case PeepholeItemType::Removed:
+                break;
+            }
+
+            if (emitter.pc() != addresses[item.index + item.words])
+                return {};
+        }
+
+        if (!emitter.finish().has_value())
+            return {};
+
+        stats.wordsSaved = count - result.size();
+        code             = std::move(result);
+
+        return stats;
+    }
+} // namespace LibMacchiato::PPCAssembler
@@ -0,0 +1,167 @@
+/*
+ * libmacchiato - Front-end for the Macchiato modding environment
+ * Copyright (C) 2024 splatoon1enjoyer @ SDL Foundation
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <sdl-utils/Types.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+namespace LibMacchiato::PPCAssembler {
+    constexpr u64 hashString(std::string_view s) {
+        u64 hash = 0xCBF29CE484222325;
+        for (const char c : s) {
+            hash ^= static_cast<u8>(c);
+            hash *= 0x100000001B3;
+        }
+
+        // FNV-1a mixes the last characters poorly, which matters for short
+        // mnemonics such as `b`/`ba`/`bl`.
+        hash ^= hash >> 33;
+        hash *= 0xFF51AFD7ED558CCD;
+        hash ^= hash >> 33;
+
+        return hash;
+    }
+
+    /*
+     * @brief Hash-and-displace perfect hash over `N` strings, built at compile
+     * time. Every key is first hashed into a bucket, and each bucket stores
+     * the displacement that moves all of its keys into distinct free slots.
+     * A lookup is one hash, two table reads and a single string compare,
+     * independent of `N`.
+     */
+    template <size_t N> struct PerfectHash {
+        static_assert(N > 0 && N < 0xFFFF);
+
+        static constexpr size_t SLOT_NUM   = std::bit_ceil(N * 2);
+        static constexpr size_t BUCKET_NUM = std::bit_ceil((N + 1) / 2);
+
+        std::array<std::string_view, N> keys          = {};
+        std::array<u16, BUCKET_NUM>     displacements = {};
+
+        // Key index + 1, 0 marks a free slot.
+        std::array<u16, SLOT_NUM> slots = {};
+
+        static constexpr size_t bucketOf(u64 hash) {
+            return static_cast<size_t>(hash >> 40) & (BUCKET_NUM - 1);
+        }
+
+        static constexpr size_t slotOf(u64 hash, u16 displacement) {
+            const u32 h1 = static_cast<u32>(hash);
+            const u32 h2 = static_cast<u32>(hash >> 20) | 1;
+
+            return (h1 + displacement * h2) & (SLOT_NUM - 1);
+        }
+
+        [[nodiscard]] constexpr std::optional<size_t>
+        find(std::string_view key) const {
+            const u64    hash = hashString(key);
+            const size_t slot =
+                slotOf(hash, this->displacements[bucketOf(hash)]);
+            const u16 entry = this->slots[slot];
+
+            if (entry == 0 || this->keys[entry - 1] != key)
+                return std::nullopt;
+
+            return entry - 1;
+        }
+    };
+
+    // Deliberately not `constexpr`, see `invalidAssemblyLiteral`.
+    inline void perfectHashConstructionFailed() {}
+
+    template <size_t N>
+    consteval PerfectHash<N>
+    buildPerfectHash(const std::array<std::string_view, N>& keys) {
+        using Table = PerfectHash<N>;
+
+        Table table = {};
+        table.keys  = keys;
+
+        std::array<u64, N> hashes = {};
+        for (size_t i = 0; i < N; i++)
+            hashes[i] = hashString(keys[i]);
+
+        std::array<size_t, Table::BUCKET_NUM> bucketSizes = {};
+        for (size_t i = 0; i < N; i++)
+            bucketSizes[Table::bucketOf(hashes[i])]++;
+
+        // Group the keys by bucket and place the largest buckets first while
+        // the table is still sparse.
+        std::array<size_t, N> order = {};
+        for (size_t i = 0; i < N; i++)
+            order[i] = i;
+        std::sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+            const size_t lhsBucket = Table::bucketOf(hashes[lhs]);
+            const size_t rhsBucket = Table::bucketOf(hashes[rhs]);
+
+            if (bucketSizes[lhsBucket] != bucketSizes[rhsBucket])
+                return bucketSizes[lhsBucket] > bucketSizes[rhsBucket];
+
+            return lhsBucket < rhsBucket;
+        });
+
+        for (size_t begin = 0; begin < N;) {
+            const size_t bucket = Table::bucketOf(hashes[order[begin]]);
+            const size_t end    = begin + bucketSizes[bucket];
+
+            std::array<size_t, N> taken  = {};
+            bool                  placed = false;
+
+            for (u32 displacement = 0; displacement < 0xFFFF && !placed;
+                 displacement++) {
+                bool fits = true;
+
+                for (size_t i = begin; i < end && fits; i++) {
+                    const size_t slot = Table::slotOf(
+                        hashes[order[i]], static_cast<u16>(displacement));
+
+                    fits = table.slots[slot] == 0
+                           && std::find(taken.begin(),
+                                        taken.begin() + (i - begin), slot)
+                                  == taken.begin() + (i - begin);
+
+                    taken[i - begin] = slot;
+                }
+
+                if (!fits)
+                    continue;
+
+                table.displacements[bucket] = static_cast<u16>(displacement);
+                for (size_t i = begin; i < end; i++)
+                    table.slots[taken[i - begin]] =
+                        static_cast<u16>(order[i] + 1);
+
+                placed = true;
+            }
+
+            // Only reachable with duplicate keys or full hash collisions.
+            if (!placed)
+                perfectHashConstructionFailed();
+
+            begin = end;
+        }
+
+        return table;
+    }
+} // namespace LibMacchiato::PPCAssembler
@@ -0,0 +1,85 @@
+/*
+ * libmacchiato - Front-end for the Macchiato modding environment
+ * Copyright (C) 2024 splatoon1enjoyer @ SDL Foundation
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "Codegen.h"
+
+#include <sdl-utils/Types.h>
+
+#include <cstddef>
+
+// Reach of the branch forms and sizes of the sequences that replace them,
+// shared by the emitter, blocks and the hooks so that they always agree on
+// which form is picked.
+namespace LibMacchiato::PPCAssembler {
+    constexpr size_t BRANCH_DISPLACEMENT_BITS             = 26;
+    constexpr size_t CONDITIONAL_BRANCH_DISPLACEMENT_BITS = 16;
+
+    /// Whether `b` or `bl` placed at `pc` reaches `target`.
+    constexpr bool relativeBranchFits(u32 pc, u32 target) {
+        return (target & 0b11) == 0 && (pc & 0b11) == 0
+               && fitsInSignedBits(target - pc, BRANCH_DISPLACEMENT_BITS);
+    }
+
+    /// Whether `ba` or `bla` reaches `target` from anywhere.
+    constexpr bool absoluteBranchFits(u32 target) {
+        return (target & 0b11) == 0
+               && fitsInSignedBits(target, BRANCH_DISPLACEMENT_BITS);
+    }
+
+    /// Whether a conditional branch placed at `pc` reaches `target`.
+    constexpr bool conditionalBranchFits(u32 pc, u32 target) {
+        return (target & 0b11) == 0 && (pc & 0b11) == 0
+               && fitsInSignedBits(target - pc,
+                                   CONDITIONAL_BRANCH_DISPLACEMENT_BITS);
+    }
+
+    /// Words of the shortest `li`, `lis` or `lis/ori` that loads `value`.
+    constexpr size_t loadImmediateSize(u32 value) {
+        return fitsInSignedBits(value, 16) || (value & 0xFFFF) == 0 ? 1 : 2;
+    }
+
+    /// Words of a jump or call through the count register, which loads
+    /// `target` into r11 first.
+    constexpr size_t indirectBranchSize(u32 target) {
+        return loadImmediateSize(target) + 2;
+    }
+
+    /// Words of the shortest jump or call from `pc` to `target`, as emitted
+    /// by `Emitter::jmp` and `Emitter::call`.
+    constexpr size_t jumpSize(u32 pc, u32 target) {
+        return relativeBranchFits(pc, target) || absoluteBranchFits(target)
+                   ? 1
+                   : indirectBranchSize(target);
+    }
+
+    static_assert(relativeBranchFits(0x02000000, 0x03FFFFFC));
+    static_assert(!relativeBranchFits(0x02000000, 0x04000000));
+    static_assert(relativeBranchFits(0x02000000, 0x00000000));
+    static_assert(absoluteBranchFits(0x01FFFFFC));
+    static_assert(absoluteBranchFits(0xFE000000));
+    static_assert(!absoluteBranchFits(0x02000000));
+    static_assert(conditionalBranchFits(0x1000, 0x8FFC));
+    static_assert(!conditionalBranchFits(0x1000, 0x9000));
+    static_assert(loadImmediateSize(0xFFFF8000) == 1);
+    static_assert(loadImmediateSize(0x12340000) == 1);
+    static_assert(loadImmediateSize(0x00008000) == 2);
+    static_assert(indirectBranchSize(0x12345678) == 4);
+    static_assert(jumpSize(0x02000000, 0x03FFFFFC) == 1);
+    static_assert(jumpSize(0x10000000, 0x02000000) == 3);
+} // namespace LibMacchiato::PPCAssembler
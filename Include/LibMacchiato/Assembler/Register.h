@@ -26,6 +26,8 @@ namespace LibMacchiato::PPCAssembler {
     enum class RegisterType {
         GPR,
         FPR,
+        // Condition register fields, `cr0` to `cr7`.
+        CR,
     };
 
     enum class Register {
@@ -64,7 +66,7 @@ namespace LibMacchiato::PPCAssembler {
         R32,
     };
 
-    inline std::optional<Register> numToReg(u32 reg) {
+    constexpr std::optional<Register> numToReg(u32 reg) {
         switch (reg) {
         case 0:
             return Register::R0;
@@ -137,7 +139,7 @@ namespace LibMacchiato::PPCAssembler {
         }
     }
 
-    inline u32 regToNum(Register reg) {
+    constexpr u32 regToNum(Register reg) {
         switch (reg) {
         case Register::R0:
             return 0;
@@ -0,0 +1,237 @@
+/*
+ * libmacchiato - Front-end for the Macchiato modding environment
+ * Copyright (C) 2024 splatoon1enjoyer @ SDL Foundation
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "Disassembler.h"
+#include "Emitter.h"
+#include "Error.h"
+#include "Range.h"
+
+#include <sdl-utils/Types.h>
+
+#include <cstddef>
+#include <expected>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+// Moves the instructions a hook overwrites into a trampoline. Branches are
+// decoded from their encoding rather than with `disassemble`, so that every
+// form, e.g. `bcl` or `bdnz`, is retargeted.
+namespace LibMacchiato::PPCAssembler {
+    // Primary opcodes of the I-form `b` and the B-form `bc`.
+    constexpr u32 BRANCH_OPCODE             = 18;
+    constexpr u32 CONDITIONAL_BRANCH_OPCODE = 16;
+
+    constexpr u32 BRANCH_ABSOLUTE_BIT = 0b10;
+    constexpr u32 BRANCH_LINK_BIT     = 0b01;
+
+    /// Words of the longest relocation of one instruction, a conditional
+    /// branch around a long jump.
+    constexpr size_t MAX_RELOCATED_SIZE = 2 + indirectBranchSize(0x12345678);
+
+    /// Instructions moved away from `address`.
+    struct DisplacedCode {
+        u32                  address = 0;
+        std::span<const u32> code    = {};
+
+        [[nodiscard]] constexpr u32 end() const {
+            return this->address
+                   + static_cast<u32>(this->code.size() * sizeof(u32));
+        }
+
+        [[nodiscard]] constexpr bool contains(u32 target) const {
+            return target >= this->address && target < this->end();
+        }
+    };
+
+    /// A branch that jumps between the instructions of a `DisplacedCode`,
+    /// which would end up in the middle of the hook.
+    struct RelocationError {
+        u32 branch = 0;
+        u32 target = 0;
+    };
+
+    [[nodiscard]] inline std::string
+    relocationErrorToStr(const RelocationError& error) {
+        return "branch at 0x" + unsignedToStr(error.branch, 16)
+               + " jumps into the hooked instructions at 0x"
+               + unsignedToStr(error.target, 16);
+    }
+
+    /// Destination of any `b` or `bc` form located at `address`, absolute
+    /// and linking ones included.
+    constexpr std::optional<u32> anyBranchTarget(u32 code, u32 address) {
+        const u32 opcode = code >> 26;
+
+        u32 displacement = 0;
+        if (opcode == BRANCH_OPCODE)
+            displacement =
+                signExtend(code & 0x03FFFFFC, BRANCH_DISPLACEMENT_BITS);
+        else if (opcode == CONDITIONAL_BRANCH_OPCODE)
+            displacement =
+                signExtend(code & 0xFFFC, CONDITIONAL_BRANCH_DISPLACEMENT_BITS);
+        else
+            return std::nullopt;
+
+        return (code & BRANCH_ABSOLUTE_BIT) != 0 ? displacement
+                                                 : address + displacement;
+    }
+
+    /// Words `code`, moved from `from` to `pc`, takes once relocated. A
+    /// target between the displaced instructions stays close and always
+    /// takes one.
+    constexpr size_t relocatedSize(u32 code, u32 from, u32 pc,
+                                   const DisplacedCode& displaced) {
+        const std::optional<u32> target = anyBranchTarget(code, from);
+        if (!target.has_value() || displaced.contains(target.value()))
+            return 1;
+
+        if ((code & BRANCH_ABSOLUTE_BIT) != 0)
+            return 1;
+
+        if (code >> 26 == BRANCH_OPCODE)
+            return jumpSize(pc, target.value());
+
+        return conditionalBranchFits(pc, target.value())
+                   ? 1
+                   : 2 + jumpSize(pc + 2 * sizeof(u32), target.value());
+    }
+
+    /*
+     * @brief Emits the instructions of `displaced` so that they behave the
+     * same at the emitter's address. Relative branches are retargeted, to
+     * their copy if they jump between the displaced instructions. `b` and
+     * `bl` that no longer reach take a long jump or call. A conditional
+     * branch that no longer reaches becomes
+     *
+     * bc BO, BI, taken   ; Same condition, decrements CTR as before
+     * b fallthrough
+     * taken:
+     * jmp target         ; Or a call, which returns to fallthrough
+     * fallthrough:
+     *
+     * Like every long jump, that clobbers r11 and the count register.
+     */
+    constexpr std::expected<size_t, AssembleError>
+    relocate(Emitter& emitter, const DisplacedCode& displaced) {
+        const size_t start = emitter.getSize();
+        const u32    base  = emitter.pc();
+
+        // Where each instruction lands, for branches between them.
+        std::vector<u32> placed(displaced.code.size());
+
+        u32 pc = base;
+        for (size_t i = 0; i < displaced.code.size(); i++) {
+            placed[i] = pc;
+            pc += static_cast<u32>(
+                relocatedSize(displaced.code[i],
+                              displaced.address
+                                  + static_cast<u32>(i * sizeof(u32)),
+                              pc, displaced)
+                * sizeof(u32));
+        }
+
+        for (size_t i = 0; i < displaced.code.size(); i++) {
+            const u32 code = displaced.code[i];
+            const u32 from =
+                displaced.address + static_cast<u32>(i * sizeof(u32));
+
+            std::optional<u32> target = anyBranchTarget(code, from);
+            if (!target.has_value()) {
+                emitter.word(code);
+                continue;
+            }
+
+            const bool inside = displaced.contains(target.value());
+            if (inside)
+                target = placed[(target.value() - displaced.address)
+                                / sizeof(u32)];
+            else if ((code & BRANCH_ABSOLUTE_BIT) != 0) {
+                emitter.word(code);
+                continue;
+            }
+
+            const bool link = (code & BRANCH_LINK_BIT) != 0;
+            const u32  here = emitter.pc();
+
+            if (code >> 26 == BRANCH_OPCODE) {
+                if (link)
+                    emitter.call(target.value());
+                else
+                    emitter.jmp(target.value());
+                continue;
+            }
+
+            // Everything but the displacement and the AA bit stays as it is.
+            const u32 condition = code & 0xFFFF0000;
+
+            if (conditionalBranchFits(here, target.value())) {
+                emitter.word(condition | ((target.value() - here) & 0xFFFC)
+                             | (code & BRANCH_LINK_BIT));
+                continue;
+            }
+
+            const size_t taken =
+                jumpSize(here + 2 * sizeof(u32), target.value());
+
+            emitter.word(condition | 2 * sizeof(u32));
+            emitter.b(here + static_cast<u32>((2 + taken) * sizeof(u32)));
+
+            if (link)
+                emitter.call(target.value());
+            else
+                emitter.jmp(target.value());
+        }
+
+        if (const auto size = emitter.finish(); !size.has_value())
+            return std::unexpected(size.error());
+
+        return emitter.getSize() - start;
+    }
+
+    /*
+     * @brief Finds a branch in `code`, located at `address`, that jumps
+     * between the instructions of `displaced`. Jumping to its first one
+     * runs the hook again, which is fine, but any other lands in the middle
+     * of it. Branches within `displaced` are relocated and are not checked.
+     */
+    constexpr std::optional<RelocationError>
+    findBranchInto(const DisplacedCode& displaced, u32 address,
+                   std::span<const u32> code) {
+        for (size_t i = 0; i < code.size(); i++) {
+            const u32 from = address + static_cast<u32>(i * sizeof(u32));
+            if (displaced.contains(from))
+                continue;
+
+            const std::optional<u32> target = anyBranchTarget(code[i], from);
+            if (target.has_value() && target.value() != displaced.address
+                && displaced.contains(target.value()))
+                return RelocationError{.branch = from,
+                                       .target = target.value()};
+        }
+
+        return std::nullopt;
+    }
+
+    static_assert(anyBranchTarget(0x4BFFFFF8, 0x1000) == 0xFF8);
+    static_assert(anyBranchTarget(0x41820008, 0x1000) == 0x1008);
+    static_assert(anyBranchTarget(0x4200FFF9, 0x1000) == 0xFF8);
+    static_assert(!anyBranchTarget(0x4E800020, 0x1000).has_value());
+} // namespace LibMacchiato::PPCAssembler
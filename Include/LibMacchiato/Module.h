@@ -213,21 +213,14 @@ namespace LibMacchiato {
 
         [[nodiscard]] inline Dependency&&
         withPatch(Patch nextPatch) && noexcept {
-            this->patch.getComponents().insert(
-                this->patch.getComponents().end(),
-                nextPatch.getComponents().begin(),
-                nextPatch.getComponents().end());
+            this->patch.append(nextPatch);
 
             return std::move(*this);
         }
 
         [[nodiscard]] inline Dependency&&
         withPatch(std::function<Patch()> nextPatch) && noexcept {
-            Patch finalPatch = nextPatch();
-            this->patch.getComponents().insert(
-                this->patch.getComponents().end(),
-                finalPatch.getComponents().begin(),
-                finalPatch.getComponents().end());
+            this->patch.append(nextPatch());
             return std::move(*this);
         }
 
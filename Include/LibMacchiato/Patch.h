@@ -20,20 +20,29 @@
 #include "Assembler.h"
 
 #include "Patch/AssemblyHook.h"
+#include "Patch/Batch.h"
 #include "Patch/Data.h"
 #include "Patch/Detour.h"
 #include "Patch/Error.h"
 #include "Patch/Hook.h"
+#include "Patch/HookSite.h"
+#include "Patch/Index.h"
 #include "Patch/Line.h"
+#include "Patch/Snapshot.h"
 #include "Patch/Trampoline.h"
+#include "Patch/Transaction.h"
 
+#include <concepts>
 #include <cstdint>
 #include <expected>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <ranges>
 #include <string>
+#include <string_view>
 #include <typeindex>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -41,18 +50,102 @@ namespace LibMacchiato {
     typedef std::variant<DataPatch<u32>, DataPatch<u16>, DataPatch<u8>,
                          DataPatch<s32>, DataPatch<s16>, DataPatch<s8>,
                          DataPatch<f32>, LinePatch, TrampolinePatch,
-                         DetourPatch, Hook, AssemblyHook>
+                         DetourPatch, Hook, AssemblyHook, SharedHook>
         PatchComponent;
 
+    struct PatchHookStats {
+        // Hooks that are a single `b` or `ba`.
+        size_t shortHooks = 0;
+        // Hooks that take the long jump, overwriting four instructions.
+        size_t longHooks = 0;
+    };
+
     struct Patch {
       private:
+        /*
+         * @brief Whether the patch is enabled, and the words it claimed in
+         * the `PatchIndex` by `tryEnable`, released by `disable`. Only the
+         * patch that claimed them may release them, or the index would
+         * count the owners of the words wrong: a copy of a patch starts
+         * disabled and without claims, and a move takes them along.
+         */
+        struct EnabledState {
+            bool             enabled = false;
+            std::vector<u32> claims  = {};
+
+            EnabledState() = default;
+
+            EnabledState(const EnabledState&) noexcept {}
+
+            EnabledState(EnabledState&& other) noexcept
+                : enabled(std::exchange(other.enabled, false))
+                , claims(std::exchange(other.claims, {})) {}
+
+            EnabledState& operator=(const EnabledState& other) noexcept {
+                if (this != &other)
+                    *this = EnabledState();
+
+                return *this;
+            }
+
+            EnabledState& operator=(EnabledState&& other) noexcept {
+                if (this != &other) {
+                    this->enabled = std::exchange(other.enabled, false);
+                    this->claims  = std::exchange(other.claims, {});
+                }
+
+                return *this;
+            }
+        };
+
         Patch(bool enabled, std::vector<PatchComponent> components)
-            : enabled(enabled)
-            , components(components) {}
+            : components(components) {
+            this->state.enabled = enabled;
+        }
 
-        bool                        enabled;
+        EnabledState                state;
         std::vector<PatchComponent> components;
 
+        // Components that failed to build, a patch with any of them is never
+        // written by `tryEnable`.
+        std::vector<PatchError> errors = {};
+
+        // Arenas of the stubs of the components, the first one is the own
+        // arena of the patch and the others come from merged patches. They
+        // are shared by the copies of the patch and released with the last
+        // of them.
+        std::vector<std::shared_ptr<CodeArena>> arenas = {};
+
+        // Reads the original bytes under every component that does not
+        // know them yet with one copy per contiguous range, instead of one
+        // per word when the components are first enabled. `tryEnable` hands
+        // the snapshot on to the index and the transaction, so that neither
+        // reads those ranges again.
+        OriginalSnapshot captureOriginals() {
+            OriginalSnapshot snapshot = {};
+
+            auto cover = [&](const auto& component) {
+                if constexpr (requires { component.cover(snapshot); })
+                    component.cover(snapshot);
+            };
+            for (const auto& component : this->components)
+                std::visit(cover, component);
+
+            snapshot.capture(Utils::Memory::KernelMemory{});
+
+            [[maybe_unused]] const size_t reads = snapshot.size();
+            MDBGINFO("Patch originals read in {} copies", reads);
+
+            auto take = [&](auto& component) {
+                if constexpr (requires { component.takeOriginal(snapshot); })
+                    component.takeOriginal(snapshot);
+            };
+            for (auto& component : this->components)
+                std::visit(take, component);
+
+            return snapshot;
+        }
+
       public:
         static Patch create() noexcept { return Patch(false, {}); }
 
@@ -60,6 +153,31 @@ namespace LibMacchiato {
             return this->components;
         }
 
+        /*
+         * @brief The arena for the stubs of the components of this patch,
+         * e.g. `TrampolinePatch::create(..., patch.getCodeArena())`. Its
+         * stubs share the slabs of every other patch in `sharedCodePool`,
+         * and are given back at once when the last copy of the patch is
+         * destroyed, e.g. when its module unloads, so the patch has to be
+         * disabled by then. The builders that place stubs use it already.
+         */
+        [[nodiscard]] CodeArena& getCodeArena() {
+            if (this->arenas.empty())
+                this->arenas.push_back(makeOwnedCodeArena());
+
+            return *this->arenas.front();
+        }
+
+        /// Adds the components of `other`, keeping the arenas of their stubs
+        /// alive as long as this patch.
+        void append(const Patch& other) {
+            this->components.insert(this->components.end(),
+                                    other.components.begin(),
+                                    other.components.end());
+            this->arenas.insert(this->arenas.end(), other.arenas.begin(),
+                                other.arenas.end());
+        }
+
         [[nodiscard]] inline Patch&&
         withLine(const uintptr_t   address,
                  const std::string instruction) && noexcept {
@@ -68,7 +186,8 @@ namespace LibMacchiato {
 
             if (!maybeLine.has_value()) {
                 MERROR("Line \"{}\" error: {}", instruction,
-                       patchErrorToStr(maybeLine.error()));
+                       patchErrorToStr(maybeLine.error(), instruction));
+                this->errors.push_back(maybeLine.error());
                 return std::move(*this);
             }
 
@@ -76,6 +195,13 @@ namespace LibMacchiato {
             return std::move(*this);
         }
 
+        template <PPCAssembler::FixedString instruction>
+        [[nodiscard]] inline Patch&&
+        withLine(const uintptr_t address) && noexcept {
+            this->components.push_back(LinePatch::line<instruction>(address));
+            return std::move(*this);
+        }
+
         template <typename T>
         [[nodiscard]] inline Patch&& withData(uintptr_t address,
                                               T         data) && noexcept {
@@ -94,6 +220,7 @@ namespace LibMacchiato {
             if (!maybeLine.has_value()) {
                 MERROR("Failed to apply line: \"",
                        patchErrorToStr(maybeLine.error()), "\"");
+                this->errors.push_back(maybeLine.error());
                 return std::move(*this);
             }
 
@@ -107,6 +234,26 @@ namespace LibMacchiato {
             return std::move(*this);
         }
 
+        /// Creates the trampoline with its stubs in the arena of the patch,
+        /// see `TrampolinePatch::tryCreate`.
+        template <typename Return, typename... Args>
+        [[nodiscard]] inline Patch&&
+        withTrampoline(uintptr_t   address, Return (*&origFunction)(Args...),
+                       const void* replFunction) && noexcept {
+            std::expected<TrampolinePatch, PatchError> trampoline =
+                TrampolinePatch::tryCreate(address, origFunction,
+                                           replFunction, this->getCodeArena());
+            if (!trampoline.has_value()) {
+                MERROR("Failed to create trampoline of {:#x}: {}", address,
+                       patchErrorToStr(trampoline.error()));
+                this->errors.push_back(trampoline.error());
+                return std::move(*this);
+            }
+
+            this->components.push_back(std::move(trampoline.value()));
+            return std::move(*this);
+        }
+
         [[nodiscard]] inline Patch&&
         withTrampolines(std::vector<TrampolinePatch> trampolines) && noexcept {
             for (const auto& trampoline : trampolines) {
@@ -116,6 +263,12 @@ namespace LibMacchiato {
             return std::move(*this);
         }
 
+        [[nodiscard]] inline Patch&&
+        withSharedHook(const SharedHook hook) && noexcept {
+            this->components.push_back(hook);
+            return std::move(*this);
+        }
+
         [[nodiscard]] inline Patch&&
         withDetour(const DetourPatch detour) && noexcept {
             this->components.push_back(detour);
@@ -124,7 +277,8 @@ namespace LibMacchiato {
 
         [[nodiscard]] inline Patch&&
         withHook(uintptr_t address, const void* function) && noexcept {
-            this->components.push_back(Hook::create(address, function));
+            this->components.push_back(
+                Hook::create(address, function, this->getCodeArena()));
             return std::move(*this);
         }
 
@@ -139,12 +293,49 @@ namespace LibMacchiato {
             return std::move(*this);
         }
 
+        [[nodiscard]] inline Patch&&
+        withAssemblyHook(const std::expected<AssemblyHook, PatchError>
+                             maybeHook) && noexcept {
+            if (!maybeHook.has_value()) {
+                MERROR("Failed to apply assembly hook: \"{}\"",
+                       patchErrorToStr(maybeHook.error()));
+                this->errors.push_back(maybeHook.error());
+                return std::move(*this);
+            }
+
+            this->components.push_back(maybeHook.value());
+            return std::move(*this);
+        }
+
+        [[nodiscard]] inline Patch&&
+        withAssemblyBlock(uintptr_t address, std::string_view source,
+                          bool keepOriginalBytes,
+                          const PPCAssembler::SymbolTable& symbols =
+                              {}) && noexcept {
+            return std::move(*this).withAssemblyHook(
+                AssemblyHook::assembleBlock(address, source, keepOriginalBytes,
+                                            symbols, this->getCodeArena()));
+        }
+
         [[nodiscard]] inline Patch&&
         withAssemblyHook(uintptr_t                address,
                          std::vector<std::string> instructions,
                          bool keepOriginalBytes) && noexcept {
-            this->components.push_back(AssemblyHook::assemble(
-                address, instructions, keepOriginalBytes));
+            std::expected<AssemblyHook, PatchError> hook =
+                AssemblyHook::assemble(address, instructions,
+                                       keepOriginalBytes, this->getCodeArena());
+            if (!hook.has_value()) {
+                std::string source = {};
+                for (const auto& instruction : instructions)
+                    source += instruction + "\n";
+
+                MERROR("Failed to assemble assembly hook: {}",
+                       patchErrorToStr(hook.error(), source));
+                this->errors.push_back(hook.error());
+                return std::move(*this);
+            }
+
+            this->components.push_back(hook.value());
             return std::move(*this);
         }
 
@@ -154,26 +345,174 @@ namespace LibMacchiato {
             return std::move(*this);
         }
 
-        inline void enable() {
-            if (this->enabled) [[unlikely]]
+        /// Adds the writes of every component to `batch`, for committing
+        /// several patches at once. Unlike `tryEnable`, nothing is checked
+        /// or indexed.
+        inline void enable(PatchBatch& batch) {
+            if (this->state.enabled) [[unlikely]]
                 return;
 
-            auto visitor = [](auto&& component) { component.enable(); };
+            this->captureOriginals();
+
+            auto visitor = [&](auto&& component) { component.enable(batch); };
             for (auto& component : this->components)
                 std::visit(visitor, component);
 
-            this->enabled = true;
+            this->state.enabled = true;
         }
 
-        inline void disable() {
-            if (!this->enabled) [[unlikely]]
+        inline void disable(PatchBatch& batch) {
+            if (!this->state.enabled) [[unlikely]]
                 return;
 
-            auto visitor = [](auto&& component) { component.disable(); };
+            if (this->state.claims.empty()) {
+                auto visitor = [&](auto&& component) {
+                    component.disable(batch);
+                };
+                for (auto& component : this->components)
+                    std::visit(visitor, component);
+
+                this->state.enabled = false;
+                return;
+            }
+
+            // The claims are the record of what the patch wrote: the index
+            // gives back the original bytes of the words no other patch
+            // writes, and the commit coalesces them into runs. Only shared
+            // hooks are visited, for their subscription.
+            PatchBatch undone  = {};
+            auto       visitor = [&]<typename T>(T& component) {
+                if constexpr (std::same_as<T, SharedHook>)
+                    component.disable(undone);
+            };
             for (auto& component : this->components)
                 std::visit(visitor, component);
 
-            this->enabled = false;
+            for (const PatchWrite& write :
+                 patchIndex().release(this->state.claims))
+                batch.writes.push_back(write);
+
+            this->state.claims.clear();
+            this->state.enabled = false;
+        }
+
+        /*
+         * @brief Enables every component in one transaction, see
+         * `commitTransaction`. Nothing is written if a component failed to
+         * build, e.g. a line that did not assemble, or if any write is
+         * invalid, so the game never runs with half of a patch.
+         *
+         * The words are claimed in the `PatchIndex`: ones that an enabled
+         * patch already wrote the same way are not written again, and ones
+         * it wrote differently fail the patch with a conflict.
+         */
+        [[nodiscard]] inline std::expected<void, PatchError> tryEnable() {
+            if (this->state.enabled) [[unlikely]]
+                return {};
+
+            if (!this->errors.empty())
+                return std::unexpected(this->errors.front());
+
+            OriginalSnapshot originals = this->captureOriginals();
+
+            // Shared hooks add the hook of their site, which is claimed and
+            // committed with the rest.
+            PatchBatch batch   = {};
+            auto       visitor = [&](auto&& component) {
+                component.enable(batch);
+            };
+            for (auto& component : this->components)
+                std::visit(visitor, component);
+
+            // Only for the state of the components, e.g. shared hooks
+            // unsubscribing, the writes were never made.
+            auto undo = [&] {
+                PatchBatch undone   = {};
+                this->state.enabled = true;
+                this->disable(undone);
+            };
+
+            std::expected<PatchClaim, PatchWriteError> claim =
+                patchIndex().claim(batch.writes, originals,
+                                   Utils::Memory::KernelMemory{});
+            if (!claim.has_value()) {
+                undo();
+                return std::unexpected(claim.error());
+            }
+
+            [[maybe_unused]] const size_t shared =
+                claim->addresses.size() - claim->writes.size();
+
+            batch.writes = std::move(claim->writes);
+
+            std::expected<PatchJournal, PatchWriteError> journal =
+                commitTransaction(batch, originals,
+                                  Utils::Memory::KernelMemory{});
+            if (!journal.has_value()) {
+                // The transaction already restored what it wrote.
+                [[maybe_unused]] const std::vector<PatchWrite> restores =
+                    patchIndex().release(claim->addresses);
+                undo();
+
+                return std::unexpected(journal.error());
+            }
+
+            [[maybe_unused]] const PatchHookStats hookStats =
+                this->getHookStats();
+            MDBGINFO("Patch enabled in {} runs, {} shared words, {} short and "
+                     "{} long hooks",
+                     journal->runs.size(), shared, hookStats.shortHooks,
+                     hookStats.longHooks);
+
+            this->state.claims  = std::move(claim->addresses);
+            this->state.enabled = true;
+
+            return {};
+        }
+
+        inline void enable() {
+            if (std::expected<void, PatchError> result = this->tryEnable();
+                !result.has_value())
+                MERROR("Patch not enabled, nothing was written: {}",
+                       patchErrorToStr(result.error()));
+        }
+
+        // A patch enabled by `tryEnable` restores the original bytes of the
+        // words no other enabled patch writes.
+        inline void disable() {
+            if (!this->state.enabled) [[unlikely]]
+                return;
+
+            PatchBatch batch = {};
+            this->disable(batch);
+            batch.commit(Utils::Memory::KernelMemory{});
+        }
+
+        [[nodiscard]] const std::vector<PatchError>& getErrors() const {
+            return this->errors;
+        }
+
+        /// How many hooks of the patch got a code cave close enough for a
+        /// single branch, see `CodeArena::allocateNear`.
+        [[nodiscard]] PatchHookStats getHookStats() const {
+            PatchHookStats stats = {};
+
+            auto count = [&](const Hook& hook) {
+                if (hook.isShort())
+                    stats.shortHooks++;
+                else
+                    stats.longHooks++;
+            };
+            auto visitor = [&]<typename T>(const T& component) {
+                if constexpr (std::same_as<T, Hook>)
+                    count(component);
+                else if constexpr (requires { component.getHook(); })
+                    count(component.getHook());
+            };
+            for (const auto& component : this->components)
+                std::visit(visitor, component);
+
+            return stats;
         }
 
         Patch operator+(Patch other) {
@@ -184,20 +523,21 @@ namespace LibMacchiato {
                 result = std::move(result).withComponent(c1).withComponent(c2);
             }
 
+            result.errors = this->errors;
+            result.errors.insert(result.errors.end(), other.errors.begin(),
+                                 other.errors.end());
+
+            result.arenas = this->arenas;
+            result.arenas.insert(result.arenas.end(), other.arenas.begin(),
+                                 other.arenas.end());
+
             return result;
         }
     };
 
     inline Patch operator+(std::function<Patch()> lhs,
                            std::function<Patch()> rhs) {
-        Patch result = Patch::create();
-
-        for (const auto& [c1, c2] :
-             std::views::zip(lhs().getComponents(), rhs().getComponents())) {
-            result = std::move(result).withComponent(c1).withComponent(c2);
-        }
-
-        return result;
+        return lhs() + rhs();
     }
 
 #define PATCH(name) [[nodiscard]] inline ::LibMacchiato::Patch name()
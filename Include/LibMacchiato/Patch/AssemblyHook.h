@@ -17,9 +17,14 @@
 
 #pragma once
 
+#include "../Assembler/Block.h"
 #include "../Assembler/Mask.h"
+#include "../Assembler/Peephole.h"
+#include "../Assembler/Relocation.h"
 #include "../Utils/Assembly.h"
 #include "../Utils/Memory.h"
+#include "CodeArena.h"
+#include "Error.h"
 #include "Hook.h"
 #include "Line.h"
 
@@ -30,6 +35,10 @@
 
 #include <algorithm>
 #include <expected>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 namespace LibMacchiato {
@@ -42,59 +51,185 @@ namespace LibMacchiato {
         Hook  hook;
         void* hookFunction;
 
-      public:
-        inline void enable() { this->hook.enable(); }
-        inline void disable() { this->hook.disable(); }
-
-        [[nodiscard]] static AssemblyHook create(uintptr_t        address,
-                                                 std::vector<u32> assemblies,
-                                                 bool keepOriginalBytes) {
-            std::vector<u32> bytes = assemblies;
+        // Words after the code of a stub: the relocated instructions the
+        // hook overwrites and the jump back.
+        static constexpr size_t TAIL_CAPACITY =
+            Utils::Assembly::MAX_JUMP_SIZE * PPCAssembler::MAX_RELOCATED_SIZE
+            + Utils::Assembly::MAX_JUMP_SIZE;
+
+        // Close to the hook if possible, so that it is a single `b`.
+        [[nodiscard]] static std::optional<u32>
+        allocate(CodeArena& arena, uintptr_t address, u32 size) {
+            return arena.allocateNear(address, size).or_else([&] {
+                return arena.allocate(size);
+            });
+        }
 
-            void* mem = reinterpret_cast<void*>(new u32[bytes.size() + 32]);
+        // Places `bytes` at `mem`, followed by the original instructions (if
+        // requested) and the jump back to the code after the hook, and gives
+        // the rest of the stub back to `arena`. The original instructions
+        // are relocated like those of a trampoline, as relative branches
+        // among them would miss their target from the stub.
+        //
+        // Only that generated tail is optimized: the code of the caller may
+        // hand r11 or CTR to its target or be entered past its first word,
+        // which `optimizeSequence` assumes never happens.
+        [[nodiscard]] static std::expected<AssemblyHook, PatchError>
+        install(uintptr_t address, void* mem, std::vector<u32> bytes,
+                bool keepOriginalBytes, CodeArena& arena) {
+            Hook hook = Hook::create(address, mem, arena);
+            hook.captureOriginal();
+
+            std::vector<u32> displacedBytes = {};
+            for (const auto& patch : hook.getBranchData())
+                displacedBytes.push_back(patch.getDisableAssembly());
+
+            // Whether the overwritten words move to the stub or are dropped,
+            // a branch into their middle would land inside the hook.
+            if (const std::optional<PPCAssembler::RelocationError> error =
+                    Hook::findBranchInto(PPCAssembler::DisplacedCode{
+                        .address = static_cast<u32>(address),
+                        .code    = displacedBytes})) {
+                arena.shrink(reinterpret_cast<u32>(mem), 0);
+                hook.release(arena);
+                return std::unexpected(error.value());
+            }
 
-            if (!mem)
-                MFATAL("Failed to allocate memory for trampoline patch.");
+            if (!keepOriginalBytes)
+                displacedBytes.clear();
+
+            const u32 tailAddress =
+                reinterpret_cast<u32>(mem) + bytes.size() * sizeof(u32);
+
+            std::vector<u32>      tail(TAIL_CAPACITY);
+            PPCAssembler::Emitter emitter(tail, tailAddress);
+
+            if (const std::expected<size_t, PPCAssembler::AssembleError>
+                    relocated = PPCAssembler::relocate(
+                        emitter,
+                        PPCAssembler::DisplacedCode{
+                            .address = static_cast<u32>(address),
+                            .code    = displacedBytes});
+                !relocated.has_value()) {
+                arena.shrink(reinterpret_cast<u32>(mem), 0);
+                hook.release(arena);
+                return std::unexpected(relocated.error());
+            }
 
-            Hook hook = Hook::create(address, mem);
+            Utils::Assembly::jump(
+                emitter, address + hook.getBranchData().size() * sizeof(u32));
 
-            size_t i = 0;
+            tail.resize(emitter.finish().value());
 
-            if (keepOriginalBytes) {
-                for (const auto& patch : hook.getBranchData()) {
-                    u32 assembly = patch.getDisableAssembly();
-                    bytes.push_back(assembly);
-                }
-            }
+            [[maybe_unused]] const PPCAssembler::PeepholeStats stats =
+                PPCAssembler::optimizeSequence(tail, tailAddress);
+            MDBGINFO("Assembly hook at {:#x} saved {} words", address,
+                     stats.wordsSaved);
 
-            std::vector<u32> jumpToOrigBytes = Utils::Assembly::jump(
-                address + hook.getBranchData().size() * sizeof(u32));
+            bytes.insert(bytes.end(), tail.begin(), tail.end());
 
-            bytes.insert(bytes.end(), jumpToOrigBytes.begin(),
-                         jumpToOrigBytes.end());
+            const size_t bytesSize = bytes.size() * sizeof(u32);
+            arena.shrink(reinterpret_cast<u32>(mem), bytesSize);
 
             Utils::Kernel::copyData(
                 OSEffectiveToPhysical(reinterpret_cast<u32>(mem)),
                 OSEffectiveToPhysical(reinterpret_cast<u32>(bytes.data())),
-                bytes.size());
+                bytesSize);
 
             Utils::Memory::invalidateICache(reinterpret_cast<u32>(mem),
-                                            bytes.size());
+                                            bytesSize);
 
             return AssemblyHook(hook, mem);
         }
 
+      public:
+        inline void enable() { this->hook.enable(); }
+        inline void disable() { this->hook.disable(); }
+
+        inline void enable(PatchBatch& batch) { this->hook.enable(batch); }
+        inline void disable(PatchBatch& batch) { this->hook.disable(batch); }
+
+        [[nodiscard]] inline const Hook& getHook() const noexcept {
+            return this->hook;
+        }
+
         [[nodiscard]] static AssemblyHook
+        create(uintptr_t address, std::vector<u32> assemblies,
+               bool keepOriginalBytes, CodeArena& arena = defaultCodeArena()) {
+            const std::optional<u32> mem = AssemblyHook::allocate(
+                arena, address,
+                (assemblies.size() + TAIL_CAPACITY) * sizeof(u32));
+
+            if (!mem.has_value())
+                MFATAL("Failed to allocate memory for trampoline patch.");
+
+            std::expected<AssemblyHook, PatchError> hook =
+                AssemblyHook::install(address,
+                                      reinterpret_cast<void*>(mem.value()),
+                                      std::move(assemblies),
+                                      keepOriginalBytes, arena);
+            if (!hook.has_value())
+                MFATAL("Failed to relocate the code under the assembly hook "
+                       "at {:#x}: {}",
+                       address, patchErrorToStr(hook.error()));
+
+            return std::move(hook.value());
+        }
+
+        /// Assembles `source` with `PPCAssembler::assembleBlock` directly
+        /// at the memory the hook jumps to.
+        [[nodiscard]] static std::expected<AssemblyHook, PatchError>
+        assembleBlock(uintptr_t address, std::string_view source,
+                      bool                             keepOriginalBytes,
+                      const PPCAssembler::SymbolTable& symbols = {},
+                      CodeArena& arena = defaultCodeArena()) {
+            std::expected<size_t, PPCAssembler::BlockError> size =
+                PPCAssembler::measureBlock(source, symbols);
+            if (!size.has_value())
+                return std::unexpected<PatchError>(size.error());
+
+            const std::optional<u32> mem = AssemblyHook::allocate(
+                arena, address, size.value() + TAIL_CAPACITY * sizeof(u32));
+
+            if (!mem.has_value())
+                MFATAL("Failed to allocate memory for trampoline patch.");
+
+            std::expected<std::vector<u32>, PPCAssembler::BlockError> code =
+                PPCAssembler::assembleBlock(source, mem.value(), symbols);
+            if (!code.has_value()) {
+                arena.shrink(mem.value(), 0);
+                return std::unexpected<PatchError>(code.error());
+            }
+
+            return AssemblyHook::install(
+                address, reinterpret_cast<void*>(mem.value()),
+                std::move(code.value()), keepOriginalBytes, arena);
+        }
+
+        /// Assembles every instruction first, a line that does not assemble
+        /// fails the hook with its line, counted from 1, and a span into the
+        /// instructions joined by newlines.
+        [[nodiscard]] static std::expected<AssemblyHook, PatchError>
         assemble(uintptr_t address, std::vector<std::string> instructions,
-                 bool keepOriginalBytes) {
+                 bool       keepOriginalBytes,
+                 CodeArena& arena = defaultCodeArena()) {
             std::vector<u32> assemblies = {};
-
-            for (const auto& instruction : instructions) {
-                assemblies.push_back(
-                    PPCAssembler::assemble(instruction).value());
+            size_t           offset     = 0;
+
+            for (size_t i = 0; i < instructions.size(); i++) {
+                std::expected<u32, PPCAssembler::AssembleError> code =
+                    PPCAssembler::assemble(instructions[i]);
+                if (!code.has_value())
+                    return std::unexpected<PatchError>(PPCAssembler::BlockError{
+                        .line  = i + 1,
+                        .error = code.error().shifted(offset)});
+
+                assemblies.push_back(code.value());
+                offset += instructions[i].size() + 1;
             }
 
-            return AssemblyHook::create(address, assemblies, keepOriginalBytes);
+            return AssemblyHook::create(address, assemblies, keepOriginalBytes,
+                                        arena);
         }
     };
 } // namespace LibMacchiato
@@ -0,0 +1,220 @@
+/*
+ * libmacchiato - Front-end for the Macchiato modding environment
+ * Copyright (C) 2024 splatoon1enjoyer @ SDL Foundation
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <sdl-utils/Types.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace LibMacchiato {
+    // Cache line of the Espresso, flushes are rounded out to it.
+    constexpr u32 PATCH_CACHE_LINE_SIZE = 32;
+
+    // Runs never continue into the next page, the kernel copies between
+    // physical addresses which are only known to be contiguous within one.
+    constexpr u32 PATCH_PAGE_SIZE = 0x1000;
+
+    enum class PatchTarget : u8 {
+        // Instructions, the instruction cache is invalidated after writing.
+        Code,
+        // Data, the data cache is invalidated after writing.
+        Data,
+    };
+
+    struct PatchWrite {
+        u32               address = 0;
+        std::array<u8, 4> bytes   = {};
+        u8                size    = 0;
+        PatchTarget       target  = PatchTarget::Code;
+
+        [[nodiscard]] constexpr u32 end() const {
+            return this->address + this->size;
+        }
+    };
+
+    /// Contiguous bytes of the same target, written with one copy and one
+    /// cache invalidation.
+    struct PatchRun {
+        u32             address = 0;
+        PatchTarget     target  = PatchTarget::Code;
+        std::vector<u8> bytes   = {};
+
+        [[nodiscard]] constexpr u32 end() const {
+            return this->address + static_cast<u32>(this->bytes.size());
+        }
+
+        /// Start of the cache lines the run touches.
+        [[nodiscard]] constexpr u32 flushAddress() const {
+            return this->address & ~(PATCH_CACHE_LINE_SIZE - 1);
+        }
+
+        /// Size of the cache lines the run touches.
+        [[nodiscard]] constexpr u32 flushSize() const {
+            const u32 end = (this->end() + PATCH_CACHE_LINE_SIZE - 1)
+                            & ~(PATCH_CACHE_LINE_SIZE - 1);
+
+            return end - this->flushAddress();
+        }
+    };
+
+    /*
+     * @brief Sorts `writes` by address and merges the ones that touch or
+     * overlap into runs. Where writes overlap, the one issued last wins, as
+     * if they had been written one after another.
+     */
+    constexpr std::vector<PatchRun>
+    coalesceWrites(std::span<const PatchWrite> writes) {
+        std::vector<PatchWrite> sorted(writes.begin(), writes.end());
+        std::ranges::sort(sorted, {}, &PatchWrite::address);
+
+        std::vector<PatchRun> runs = {};
+
+        for (const auto& write : sorted) {
+            if (!runs.empty()) {
+                PatchRun& run = runs.back();
+
+                const bool overlaps = write.address < run.end();
+                const bool extends  = write.address == run.end()
+                                      && write.target == run.target
+                                      && write.address % PATCH_PAGE_SIZE != 0;
+
+                if (overlaps || extends) {
+                    if (write.end() > run.end())
+                        run.bytes.resize(write.end() - run.address);
+                    // Code and data written over each other, the code needs
+                    // the stronger invalidation.
+                    if (write.target == PatchTarget::Code)
+                        run.target = PatchTarget::Code;
+                    continue;
+                }
+            }
+
+            runs.push_back(PatchRun{.address = write.address,
+                                    .target  = write.target,
+                                    .bytes   = std::vector<u8>(write.size)});
+        }
+
+        // Filled in issue order, so that later writes overwrite earlier ones.
+        for (const auto& write : writes) {
+            PatchRun& run = *std::prev(std::ranges::upper_bound(
+                runs, write.address, {}, &PatchRun::address));
+
+            std::ranges::copy_n(write.bytes.begin(), write.size,
+                                run.bytes.begin()
+                                    + (write.address - run.address));
+        }
+
+        return runs;
+    }
+
+    /*
+     * @brief Where a `PatchBatch` is committed to. `copy` writes bytes to an
+     * address, `invalidateCode` and `invalidateData` invalidate the
+     * instruction or data cache lines of a range. See
+     * `Utils::Memory::KernelMemory` for the one that patches the game.
+     */
+    template <typename T>
+    concept PatchMemory = requires(T& memory, u32 address, u32 size,
+                                   std::span<const u8> bytes) {
+        memory.copy(address, bytes);
+        memory.invalidateCode(address, size);
+        memory.invalidateData(address, size);
+    };
+
+    /// A `PatchMemory` that can also be read and tell which addresses are
+    /// mapped, as transactions need to.
+    template <typename T>
+    concept JournaledPatchMemory =
+        PatchMemory<T>
+        && requires(T& memory, u32 address, u32 size, std::span<u8> bytes) {
+               { memory.isMapped(address, size) } -> std::convertible_to<bool>;
+               memory.read(address, bytes);
+           };
+
+    /// Copies `run` to `memory` and invalidates the cache lines it touches.
+    template <PatchMemory Memory>
+    constexpr void writeRun(Memory& memory, const PatchRun& run) {
+        memory.copy(run.address, run.bytes);
+
+        if (run.target == PatchTarget::Code)
+            memory.invalidateCode(run.flushAddress(), run.flushSize());
+        else
+            memory.invalidateData(run.flushAddress(), run.flushSize());
+    }
+
+    struct PatchCommitStats {
+        size_t writes = 0;
+        size_t runs   = 0;
+    };
+
+    /*
+     * @brief Collects the writes of any number of patch components, so that
+     * they are committed with one copy and one cache invalidation per run of
+     * contiguous bytes instead of one of each per word.
+     */
+    struct PatchBatch {
+        std::vector<PatchWrite> writes = {};
+
+        constexpr void writeWord(u32 address, u32 word) {
+            this->writes.push_back(
+                PatchWrite{.address = address,
+                           .bytes   = std::bit_cast<std::array<u8, 4>>(word),
+                           .size    = sizeof(u32),
+                           .target  = PatchTarget::Code});
+        }
+
+        template <typename T>
+            requires(std::is_trivially_copyable_v<T> && sizeof(T) <= 4)
+        constexpr void writeData(u32 address, T data) {
+            const auto bytes = std::bit_cast<std::array<u8, sizeof(T)>>(data);
+
+            PatchWrite write = {.address = address,
+                                .size    = sizeof(T),
+                                .target  = PatchTarget::Data};
+            std::ranges::copy(bytes, write.bytes.begin());
+
+            this->writes.push_back(write);
+        }
+
+        [[nodiscard]] constexpr bool empty() const {
+            return this->writes.empty();
+        }
+
+        /// Writes everything to `memory` and empties the batch.
+        template <PatchMemory Memory>
+        constexpr PatchCommitStats commit(Memory&& memory) {
+            const std::vector<PatchRun> runs = coalesceWrites(this->writes);
+
+            for (const auto& run : runs)
+                writeRun(memory, run);
+
+            const PatchCommitStats stats = {.writes = this->writes.size(),
+                                            .runs   = runs.size()};
+            this->writes.clear();
+
+            return stats;
+        }
+    };
+} // namespace LibMacchiato
@@ -0,0 +1,408 @@
+/*
+ * libmacchiato - Front-end for the Macchiato modding environment
+ * Copyright (C) 2024 splatoon1enjoyer @ SDL Foundation
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "../Assembler/Range.h"
+#include "../Utils/CodeRegion.h"
+#include "Batch.h"
+
+#include <sdl-utils/Types.h>
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace LibMacchiato {
+    // Size of the slabs a pool reserves, enough for a few hundred
+    // trampolines. Larger stubs get a slab of their own.
+    constexpr u32 CODE_ARENA_SLAB_SIZE = 0x4000;
+
+    /*
+     * @brief Where a `CodePool` gets its slabs from. `reserve` returns the
+     * address of `size` bytes aligned to `alignment`, or nothing if it is out
+     * of memory, and `release` gives a slab back. See
+     * `Utils::Memory::HeapCodeRegion` for the one used on the console.
+     */
+    template <typename T>
+    concept CodeRegion = requires(T& region, u32 address, u32 size) {
+        {
+            region.reserve(size, size)
+        } -> std::convertible_to<std::optional<u32>>;
+        region.release(address, size);
+    };
+
+    struct CodePoolStats {
+        // Slabs reserved from the region.
+        size_t slabs = 0;
+        // Bytes of all slabs.
+        u32 reservedBytes = 0;
+        // Bytes of all caves.
+        u32 caveBytes = 0;
+        // Bytes handed out, rounded up to cache lines.
+        u32 usedBytes = 0;
+    };
+
+    /*
+     * @brief Allocator for the code of trampolines and assembly hooks, shared
+     * by every `CodeArena`. Stubs start on a cache line, so that flushing one
+     * never touches the code of another, and are packed into a few slabs
+     * instead of being spread over the heap. Freed bytes are reused by later
+     * stubs, and a slab is given back to the region once nothing is left in
+     * it.
+     *
+     * Caves are executable memory that is known to be unused, e.g. next to
+     * the text of an RPL. They are only handed out by `allocateNear`, for
+     * stubs that a single `b` has to reach.
+     */
+    template <CodeRegion Region> struct BasicCodePool {
+      private:
+        struct Span {
+            u32 address = 0;
+            u32 size    = 0;
+
+            [[nodiscard]] constexpr u32 end() const {
+                return this->address + this->size;
+            }
+        };
+
+        struct Slab {
+            u32  address = 0;
+            u32  size    = 0;
+            bool cave    = false;
+
+            // Free bytes by address, neighbours are always merged.
+            std::vector<Span> free = {};
+
+            [[nodiscard]] constexpr u32 used() const {
+                u32 free = 0;
+                for (const auto& span : this->free)
+                    free += span.size;
+
+                return this->size - free;
+            }
+
+            [[nodiscard]] constexpr bool contains(u32 address) const {
+                return address >= this->address
+                       && address - this->address < this->size;
+            }
+        };
+
+        Region            region;
+        std::vector<Slab> slabs = {};
+
+        // Takes `size` bytes at `address` out of the free span `span`, which
+        // they start or end.
+        static constexpr u32 take(Slab& slab, size_t span, u32 address,
+                                  u32 size) {
+            Span& free = slab.free[span];
+
+            if (address == free.address)
+                free.address += size;
+            free.size -= size;
+
+            if (free.size == 0)
+                slab.free.erase(slab.free.begin() + span);
+
+            return address;
+        }
+
+      public:
+        [[nodiscard]] static constexpr u32 alignSize(u32 size) {
+            return (size + PATCH_CACHE_LINE_SIZE - 1)
+                   & ~(PATCH_CACHE_LINE_SIZE - 1);
+        }
+
+        constexpr explicit BasicCodePool(Region region = {})
+            : region(std::move(region)) {}
+
+        BasicCodePool(const BasicCodePool&)            = delete;
+        BasicCodePool& operator=(const BasicCodePool&) = delete;
+
+        /// Returns the address of `size` bytes starting on a cache line.
+        [[nodiscard]] constexpr std::optional<u32> allocate(u32 size) {
+            size = alignSize(std::max<u32>(size, 1));
+
+            // Stubs that can go anywhere never take the space of a cave.
+            for (auto& slab : this->slabs) {
+                if (slab.cave)
+                    continue;
+
+                for (size_t i = 0; i < slab.free.size(); i++) {
+                    if (slab.free[i].size >= size)
+                        return take(slab, i, slab.free[i].address, size);
+                }
+            }
+
+            const u32 slabSize = std::max(CODE_ARENA_SLAB_SIZE, size);
+
+            const std::optional<u32> address =
+                this->region.reserve(slabSize, PATCH_CACHE_LINE_SIZE);
+            if (!address.has_value())
+                return std::nullopt;
+
+            Slab& slab = this->slabs.emplace_back(Slab{
+                .address = address.value(),
+                .size    = slabSize,
+                .free    = {Span{.address = address.value(),
+                                 .size    = slabSize}}});
+
+            return take(slab, 0, slab.address, size);
+        }
+
+        /*
+         * @brief Returns the address of `size` bytes that a `b` at `near`
+         * reaches and that reach back to it, from a cave or a slab that
+         * happens to be close. Nothing if no such memory is left, a long
+         * jump to `allocate`d memory is needed then.
+         */
+        [[nodiscard]] constexpr std::optional<u32> allocateNear(u32 near,
+                                                                u32 size) {
+            size = alignSize(std::max<u32>(size, 1));
+
+            auto reaches = [&](u32 start) {
+                return PPCAssembler::relativeBranchFits(near, start)
+                       && PPCAssembler::relativeBranchFits(
+                           start + size - sizeof(u32), near);
+            };
+
+            for (auto& slab : this->slabs) {
+                for (size_t i = 0; i < slab.free.size(); i++) {
+                    const Span& free = slab.free[i];
+                    if (free.size < size)
+                        continue;
+
+                    // A large cave may only be in reach with its far end.
+                    if (reaches(free.address))
+                        return take(slab, i, free.address, size);
+                    if (reaches(free.end() - size))
+                        return take(slab, i, free.end() - size, size);
+                }
+            }
+
+            return std::nullopt;
+        }
+
+        /// Gives back `size` bytes at `address`, as handed out by
+        /// `allocate` or `allocateNear`. A slab left empty goes back to the
+        /// region, caves stay.
+        constexpr void free(u32 address, u32 size) {
+            size = alignSize(size);
+            if (size == 0)
+                return;
+
+            const auto slab =
+                std::ranges::find_if(this->slabs, [&](const Slab& slab) {
+                    return slab.contains(address);
+                });
+            if (slab == this->slabs.end())
+                return;
+
+            const auto next = std::ranges::find_if(
+                slab->free,
+                [&](const Span& span) { return span.address > address; });
+            auto span = slab->free.insert(
+                next, Span{.address = address, .size = size});
+
+            if (std::next(span) != slab->free.end()
+                && span->end() == std::next(span)->address) {
+                span->size += std::next(span)->size;
+                slab->free.erase(std::next(span));
+            }
+            if (span != slab->free.begin()
+                && std::prev(span)->end() == span->address) {
+                std::prev(span)->size += span->size;
+                slab->free.erase(span);
+            }
+
+            if (!slab->cave && slab->used() == 0) {
+                this->region.release(slab->address, slab->size);
+                this->slabs.erase(slab);
+            }
+        }
+
+        /// Adds `size` bytes of executable memory at `address` that nothing
+        /// else uses. Caves are never given back to the region.
+        constexpr void addCave(u32 address, u32 size) {
+            const u32 start = alignSize(address);
+            if (size <= start - address)
+                return;
+
+            const u32 caveSize =
+                (size - (start - address)) & ~(PATCH_CACHE_LINE_SIZE - 1);
+            if (caveSize == 0)
+                return;
+
+            this->slabs.push_back(
+                Slab{.address = start,
+                     .size    = caveSize,
+                     .cave    = true,
+                     .free    = {Span{.address = start, .size = caveSize}}});
+        }
+
+        [[nodiscard]] constexpr CodePoolStats stats() const {
+            CodePoolStats stats = {};
+
+            for (const auto& slab : this->slabs) {
+                if (slab.cave) {
+                    stats.caveBytes += slab.size;
+                } else {
+                    stats.slabs++;
+                    stats.reservedBytes += slab.size;
+                }
+
+                stats.usedBytes += slab.used();
+            }
+
+            return stats;
+        }
+
+        [[nodiscard]] constexpr const Region& getRegion() const {
+            return this->region;
+        }
+    };
+
+    /*
+     * @brief The stubs of one owner, e.g. a `Patch`, placed in a shared
+     * `CodePool`. Only the records of its stubs are kept here, so that any
+     * number of owners fill the same slabs and caves. Stubs are never freed
+     * one by one, as the game may still be running them; `release` gives
+     * them all back at once, once the patches using them have been
+     * disabled.
+     */
+    template <CodeRegion Region> struct BasicCodeArena {
+      private:
+        struct Allocation {
+            u32 address = 0;
+            u32 size    = 0;
+        };
+
+        BasicCodePool<Region>*  pool;
+        std::vector<Allocation> allocations = {};
+
+        constexpr std::optional<u32> record(std::optional<u32> address,
+                                            u32                size) {
+            if (address.has_value())
+                this->allocations.push_back(Allocation{
+                    .address = address.value(),
+                    .size    = BasicCodePool<Region>::alignSize(
+                        std::max<u32>(size, 1))});
+
+            return address;
+        }
+
+      public:
+        constexpr explicit BasicCodeArena(BasicCodePool<Region>& pool)
+            : pool(&pool) {}
+
+        BasicCodeArena(const BasicCodeArena&)            = delete;
+        BasicCodeArena& operator=(const BasicCodeArena&) = delete;
+
+        constexpr BasicCodeArena(BasicCodeArena&&)            = default;
+        constexpr BasicCodeArena& operator=(BasicCodeArena&&) = default;
+
+        /// See `BasicCodePool::allocate`.
+        [[nodiscard]] constexpr std::optional<u32> allocate(u32 size) {
+            return this->record(this->pool->allocate(size), size);
+        }
+
+        /// See `BasicCodePool::allocateNear`.
+        [[nodiscard]] constexpr std::optional<u32> allocateNear(u32 near,
+                                                                u32 size) {
+            return this->record(this->pool->allocateNear(near, size), size);
+        }
+
+        /*
+         * @brief Shrinks the stub at `address` to `size` bytes, as stubs are
+         * allocated for their longest encoding before they are optimized.
+         * The rest goes back to the pool, shrinking a stub to nothing frees
+         * it.
+         */
+        constexpr void shrink(u32 address, u32 size) {
+            const auto allocation = std::ranges::find(
+                this->allocations, address, &Allocation::address);
+            if (allocation == this->allocations.end())
+                return;
+
+            const u32 kept = BasicCodePool<Region>::alignSize(size);
+            if (kept >= allocation->size)
+                return;
+
+            this->pool->free(address + kept, allocation->size - kept);
+
+            if (kept == 0)
+                this->allocations.erase(allocation);
+            else
+                allocation->size = kept;
+        }
+
+        [[nodiscard]] constexpr bool contains(u32 address) const {
+            return std::ranges::any_of(
+                this->allocations, [&](const Allocation& allocation) {
+                    return address >= allocation.address
+                           && address - allocation.address < allocation.size;
+                });
+        }
+
+        /// Stubs currently placed by this arena.
+        [[nodiscard]] constexpr size_t size() const {
+            return this->allocations.size();
+        }
+
+        /// Gives every stub back to the pool, e.g. when the module that
+        /// placed them unloads.
+        constexpr void release() {
+            for (const auto& allocation : this->allocations)
+                this->pool->free(allocation.address, allocation.size);
+
+            this->allocations.clear();
+        }
+    };
+
+    using CodePool  = BasicCodePool<Utils::Memory::HeapCodeRegion>;
+    using CodeArena = BasicCodeArena<Utils::Memory::HeapCodeRegion>;
+
+    /*
+     * @brief The pool of every arena. Its cave is reserved once, in the text
+     * of the module (see Source/CodeCave.s), which the loader places within
+     * reach of a `b` from the code of the title. Stubs near a hook take its
+     * bytes, so that the hook is a single `b`, and the rest go to the heap.
+     * The codegen area of a title is its JIT's, so it is never used.
+     */
+    CodePool& sharedCodePool();
+
+    /// The arena of patches that are not given one, it is never released.
+    inline CodeArena& defaultCodeArena() {
+        static CodeArena arena(sharedCodePool());
+        return arena;
+    }
+
+    /// An arena of its own for the stubs of one owner, e.g. a `Patch`, that
+    /// gives them back once the last of its owners is destroyed. The
+    /// patches using it have to be disabled by then.
+    inline std::shared_ptr<CodeArena> makeOwnedCodeArena() {
+        return std::shared_ptr<CodeArena>(new CodeArena(sharedCodePool()),
+                                          [](CodeArena* arena) {
+                                              arena->release();
+                                              delete arena;
+                                          });
+    }
+} // namespace LibMacchiato
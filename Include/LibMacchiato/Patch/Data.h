@@ -2,7 +2,11 @@
 
 #include "../Utils/Kernel.h"
 #include "../Utils/Memory.h"
+#include "Batch.h"
+#include "Snapshot.h"
 
+#include <array>
+#include <bit>
 #include <optional>
 
 namespace LibMacchiato {
@@ -19,7 +23,7 @@ namespace LibMacchiato {
             , disableData(disableData) {}
 
 
-        inline void apply(bool enable) {
+        inline void apply(PatchBatch& batch, bool enable) {
             u32 address = reinterpret_cast<u32>(this->address);
 
             if (!this->disableData.has_value()) [[unlikely]] {
@@ -39,16 +43,34 @@ namespace LibMacchiato {
 
             enable ? data = this->enableData : data = this->disableData.value();
 
-            Utils::Kernel::copyData(OSEffectiveToPhysical(address),
-                                    OSEffectiveToPhysical((u32)(&data)),
-                                    sizeof(T));
-            Utils::Memory::invalidateDCache(address, sizeof(T));
+            batch.writeData(address, data);
+        }
+
+        inline void apply(bool enable) {
+            PatchBatch batch = {};
+            this->apply(batch, enable);
+            batch.commit(Utils::Memory::KernelMemory{});
         }
 
       public:
         inline void enable() { this->apply(true); }
         inline void disable() { this->apply(false); }
 
+        inline void enable(PatchBatch& batch) { this->apply(batch, true); }
+        inline void disable(PatchBatch& batch) { this->apply(batch, false); }
+
+        void cover(OriginalSnapshot& snapshot) const {
+            if (!this->disableData.has_value())
+                snapshot.cover(static_cast<u32>(this->address), sizeof(T));
+        }
+
+        void takeOriginal(const OriginalSnapshot& snapshot) {
+            std::array<u8, sizeof(T)> bytes = {};
+            if (!this->disableData.has_value()
+                && snapshot.read(static_cast<u32>(this->address), bytes))
+                this->disableData = std::bit_cast<T>(bytes);
+        }
+
         static DataPatch<T> create(uintptr_t address, T data) {
             return DataPatch(address, data, std::nullopt);
         }
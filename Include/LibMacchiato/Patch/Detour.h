@@ -22,6 +22,7 @@
 
 #include "Hook.h"
 #include "Line.h"
+#include "Snapshot.h"
 
 #include <concepts>
 #include <cstdlib>
@@ -51,6 +52,21 @@ namespace LibMacchiato {
         void enable() { this->hook.enable(); }
         void disable() { this->hook.disable(); }
 
+        void enable(PatchBatch& batch) { this->hook.enable(batch); }
+        void disable(PatchBatch& batch) { this->hook.disable(batch); }
+
+        void cover(OriginalSnapshot& snapshot) const {
+            this->hook.cover(snapshot);
+        }
+
+        void takeOriginal(const OriginalSnapshot& snapshot) {
+            this->hook.takeOriginal(snapshot);
+        }
+
+        [[nodiscard]] inline const Hook& getHook() const noexcept {
+            return this->hook;
+        }
+
         /*
          *
          * @warning The constructor assumes that the function passed is at least
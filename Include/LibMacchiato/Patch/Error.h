@@ -1,13 +1,70 @@
 #pragma once
 
+#include "../Assembler/Disassembler.h"
 #include "../Assembler/Error.h"
+#include "../Assembler/Relocation.h"
+
+#include <sdl-utils/Types.h>
+
+#include <string>
+#include <string_view>
+#include <variant>
 
 namespace LibMacchiato {
-    typedef std::variant<PPCAssembler::AssembleError> PatchError;
+    enum class PatchWriteErrorCode : u8 {
+        // The address is not mapped, e.g. a hook on a function of a module
+        // that is not loaded.
+        UnmappedAddress,
+        // Instructions have to be word aligned.
+        UnalignedCode,
+        // The memory did not hold the written bytes afterwards.
+        WriteFailed,
+        // Another enabled patch writes different bytes there.
+        Conflict,
+    };
+
+    /// Why a transaction wrote nothing, see `commitTransaction`.
+    struct PatchWriteError {
+        PatchWriteErrorCode code    = PatchWriteErrorCode::UnmappedAddress;
+        u32                 address = 0;
+    };
+
+    typedef std::variant<PPCAssembler::AssembleError, PPCAssembler::BlockError,
+                         PatchWriteError, PPCAssembler::RelocationError>
+        PatchError;
+
+    [[nodiscard]] inline std::string
+    patchWriteErrorToStr(const PatchWriteError& error) {
+        const std::string address =
+            "0x" + PPCAssembler::unsignedToStr(error.address, 16);
+
+        switch (error.code) {
+        case PatchWriteErrorCode::UnmappedAddress:
+            return address + " is not mapped";
+        case PatchWriteErrorCode::UnalignedCode:
+            return "code at " + address + " is not word aligned";
+        case PatchWriteErrorCode::WriteFailed:
+            return "write to " + address + " did not stick";
+        case PatchWriteErrorCode::Conflict:
+            return address + " is already patched differently";
+        }
+
+        return "write to " + address + " failed";
+    }
 
-    [[nodiscard]] inline std::string patchErrorToStr(PatchError patchError) {
+    /// `source` is the assembly the error came from, if it is at hand, so
+    /// the message can quote the part at fault.
+    [[nodiscard]] inline std::string
+    patchErrorToStr(PatchError patchError, std::string_view source = {}) {
         if (auto error = std::get_if<PPCAssembler::AssembleError>(&patchError))
-            return PPCAssembler::assembleErrorToStr(*error);
+            return PPCAssembler::assembleErrorToStr(*error, source);
+        if (auto error = std::get_if<PPCAssembler::BlockError>(&patchError))
+            return PPCAssembler::blockErrorToStr(*error, source);
+        if (auto error = std::get_if<PatchWriteError>(&patchError))
+            return patchWriteErrorToStr(*error);
+        if (auto error =
+                std::get_if<PPCAssembler::RelocationError>(&patchError))
+            return PPCAssembler::relocationErrorToStr(*error);
 
         return "Invalid patch error.";
     }
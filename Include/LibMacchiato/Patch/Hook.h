@@ -18,9 +18,13 @@
 #pragma once
 
 #include "../Assembler/Mask.h"
+#include "../Assembler/Relocation.h"
 #include "../Utils/Assembly.h"
 #include "../Utils/Memory.h"
+#include "Batch.h"
+#include "CodeArena.h"
 #include "Line.h"
+#include "Snapshot.h"
 
 #include <sdl-utils/Types.h>
 
@@ -28,39 +32,172 @@
 #include <expected>
 #include <format>
 #include <functional>
+#include <optional>
 #include <vector>
 
 namespace LibMacchiato {
     struct Hook {
       private:
-        Hook(std::vector<LinePatch> branch)
-            : branch(branch) {}
+        Hook(std::vector<LinePatch> branch, std::optional<u32> thunk)
+            : branch(branch)
+            , thunk(thunk) {}
 
         std::vector<LinePatch> branch;
 
+        // The stub the branch reaches the function through, if it was out
+        // of range, see `placeThunk`.
+        std::optional<u32> thunk;
+
+        // Words on each side of a hook that are checked for branches into
+        // the instructions it overwrites.
+        static constexpr size_t HOOK_SCAN_SIZE = 256;
+
+        // Places the long jump to `function` in a thunk that a `b` at
+        // `address` reaches, so that the hook overwrites a single word and
+        // only the thunk clobbers r11 and the count register.
+        [[nodiscard]] static std::optional<u32>
+        placeThunk(u32 address, u32 function, CodeArena& arena) {
+            const std::optional<u32> thunk = arena.allocateNear(
+                address, Utils::Assembly::MAX_JUMP_SIZE * sizeof(u32));
+            if (!thunk.has_value())
+                return std::nullopt;
+
+            std::array<u32, Utils::Assembly::MAX_JUMP_SIZE> thunkBytes = {};
+            PPCAssembler::Emitter emitter(thunkBytes, thunk.value());
+            Utils::Assembly::jump(emitter, function);
+
+            const size_t thunkBytesSize =
+                emitter.finish().value() * sizeof(u32);
+            arena.shrink(thunk.value(), thunkBytesSize);
+
+            Utils::Kernel::copyData(
+                OSEffectiveToPhysical(thunk.value()),
+                OSEffectiveToPhysical(reinterpret_cast<u32>(thunkBytes.data())),
+                thunkBytesSize);
+
+            Utils::Memory::invalidateICache(thunk.value(), thunkBytesSize);
+
+            return thunk;
+        }
+
       public:
-        inline void enable() {
+        inline void enable(PatchBatch& batch) {
             for (auto& patch : this->branch) {
-                patch.enable();
+                patch.enable(batch);
             }
         }
 
-        inline void disable() {
+        inline void disable(PatchBatch& batch) {
             for (auto& patch : this->branch) {
-                patch.disable();
+                patch.disable(batch);
             }
         }
 
-        [[nodiscard]] static Hook create(uintptr_t   address,
-                                         const void* function) {
+        // The words of the branch are contiguous, so they get written with a
+        // single copy.
+        inline void enable() {
+            PatchBatch batch = {};
+            this->enable(batch);
+            batch.commit(Utils::Memory::KernelMemory{});
+        }
+
+        inline void disable() {
+            PatchBatch batch = {};
+            this->disable(batch);
+            batch.commit(Utils::Memory::KernelMemory{});
+        }
+
+        inline void cover(OriginalSnapshot& snapshot) const {
+            for (const auto& patch : this->branch)
+                patch.cover(snapshot);
+        }
+
+        inline void takeOriginal(const OriginalSnapshot& snapshot) {
+            for (auto& patch : this->branch)
+                patch.takeOriginal(snapshot);
+        }
+
+        /// Reads the instructions the hook overwrites with a single copy,
+        /// e.g. to relocate them.
+        inline void captureOriginal() {
+            OriginalSnapshot snapshot = {};
+            this->cover(snapshot);
+            snapshot.capture(Utils::Memory::KernelMemory{});
+            this->takeOriginal(snapshot);
+        }
+
+        /*
+         * @brief Finds a branch of the code around `displaced` that jumps
+         * into the middle of it, which breaks once its instructions are
+         * moved elsewhere. Loops branch back into it from the code after
+         * the hook and skips from the code before, so both sides are read,
+         * with a single copy.
+         */
+        [[nodiscard]] static std::optional<PPCAssembler::RelocationError>
+        findBranchInto(const PPCAssembler::DisplacedCode& displaced) {
+            // A single instruction has no middle to jump into.
+            if (displaced.code.size() <= 1)
+                return std::nullopt;
+
+            constexpr u32 SIDE_SIZE = HOOK_SCAN_SIZE * sizeof(u32);
+
+            Utils::Memory::KernelMemory memory = {};
+
+            const u32 before =
+                displaced.address >= SIDE_SIZE
+                        && memory.isMapped(displaced.address - SIDE_SIZE,
+                                           SIDE_SIZE)
+                    ? SIDE_SIZE
+                    : 0;
+            const u32 after =
+                memory.isMapped(displaced.end(), SIDE_SIZE) ? SIDE_SIZE : 0;
+
+            const u32        start = displaced.address - before;
+            std::vector<u32> window(
+                (before + after) / sizeof(u32) + displaced.code.size());
+            memory.read(start,
+                        std::span(reinterpret_cast<u8*>(window.data()),
+                                  window.size() * sizeof(u32)));
+
+            return PPCAssembler::findBranchInto(displaced, start, window);
+        }
+
+        [[nodiscard]] static Hook
+        create(uintptr_t address, const void* function,
+               CodeArena& arena = defaultCodeArena()) {
             // Utils::Assembly::adjustAddressIfFirstInstructionIsBranch(address);
 
             auto customFunctionAddress = reinterpret_cast<uintptr_t>(function);
 
+            std::optional<u32> thunk = std::nullopt;
+            if (!PPCAssembler::relativeBranchFits(address,
+                                                  customFunctionAddress)
+                && !Utils::Assembly::shortJumpIsPossible(
+                    customFunctionAddress)) {
+                thunk = placeThunk(address, customFunctionAddress, arena);
+                if (thunk.has_value())
+                    customFunctionAddress = thunk.value();
+            }
+
             std::vector<LinePatch> branch =
                 Utils::Assembly::jump(address, customFunctionAddress);
 
-            return Hook(std::move(branch));
+            return Hook(std::move(branch), thunk);
+        }
+
+        /// Gives the thunk of the hook back to `arena`, for a hook that is
+        /// dropped before it was ever enabled.
+        inline void release(CodeArena& arena) {
+            if (this->thunk.has_value())
+                arena.shrink(this->thunk.value(), 0);
+
+            this->thunk = std::nullopt;
+        }
+
+        /// Whether the hook is a single `b` or `ba`, the other instructions
+        /// of the hooked code are left alone then.
+        [[nodiscard]] inline bool isShort() const noexcept {
+            return this->branch.size() == 1;
         }
 
         [[nodiscard]] inline const std::vector<LinePatch>&
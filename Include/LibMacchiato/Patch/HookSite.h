@@ -0,0 +1,465 @@
+/*
+ * libmacchiato - Front-end for the Macchiato modding environment
+ * Copyright (C) 2024 splatoon1enjoyer @ SDL Foundation
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "../Assembler/Emitter.h"
+#include "../Log.h"
+#include "../Utils/Kernel.h"
+#include "../Utils/Memory.h"
+
+#include "Batch.h"
+#include "CodeArena.h"
+#include "Error.h"
+#include "Hook.h"
+#include "Index.h"
+#include "Snapshot.h"
+#include "Trampoline.h"
+#include "Transaction.h"
+
+#include <sdl-utils/Types.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <expected>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <vector>
+
+#include <coreinit/memorymap.h>
+
+namespace LibMacchiato {
+    // Subscribers one hook site dispatches to at most.
+    constexpr size_t HOOK_SITE_CAPACITY = 16;
+
+    struct HookSubscriber {
+        u32  function = 0;
+        s32  priority = 0;
+        bool enabled  = false;
+    };
+
+    /*
+     * @brief Fills the dispatch array of a hook site. `links[0]` is where the
+     * hooked function goes, `links[i + 1]` where the original function of
+     * subscriber `i` goes. Enabled subscribers run by ascending priority,
+     * then in the order they subscribed, and the last one goes to
+     * `original`. Links of disabled subscribers skip to the next enabled
+     * one, in case the game is still running them.
+     */
+    constexpr void linkSubscribers(std::span<const HookSubscriber> subscribers,
+                                   u32 original, std::span<u32> links) {
+        std::vector<size_t> order(subscribers.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::ranges::sort(order, [&](size_t lhs, size_t rhs) {
+            if (subscribers[lhs].priority != subscribers[rhs].priority)
+                return subscribers[lhs].priority < subscribers[rhs].priority;
+            return lhs < rhs;
+        });
+
+        // Walked backwards, so each subscriber knows the one after it.
+        u32 next = original;
+
+        for (const size_t i : order | std::views::reverse) {
+            links[i + 1] = next;
+
+            if (subscribers[i].enabled)
+                next = subscribers[i].function;
+        }
+
+        links[0] = next;
+    }
+
+    static_assert([] {
+        const std::array<HookSubscriber, 3> subscribers = {
+            HookSubscriber{.function = 0x100, .priority = 5, .enabled = true},
+            HookSubscriber{.function = 0x200, .priority = 1, .enabled = true},
+            HookSubscriber{.function = 0x300, .priority = 3, .enabled = false},
+        };
+
+        std::array<u32, 4> links = {};
+        linkSubscribers(subscribers, 0x900, links);
+
+        return links[0] == 0x200 && links[2] == 0x100 && links[1] == 0x900
+               && links[3] == 0x100;
+    }());
+
+    /*
+     * @brief The one hook of an address that any number of `SharedHook`s
+     * subscribe to. The hooked function jumps through the dispatch array to
+     * the first enabled subscriber, each one's original function jumps
+     * through it to the next one and the last one reaches the single
+     * trampoline of the site. Subscribing, enabling and disabling only
+     * rewrite the array; the game code is patched when the first subscriber
+     * is enabled and restored when the last one is disabled.
+     */
+    struct HookSite {
+      private:
+        HookSite() = default;
+
+        u32                            address     = 0;
+        u32                            original    = 0;
+        std::vector<HookSubscriber>    subscribers = {};
+        std::optional<TrampolinePatch> trampoline  = std::nullopt;
+        bool                           installed   = false;
+
+        // Words of the hook claimed in the `PatchIndex` while installed.
+        std::vector<u32> claims = {};
+
+        // Read by the code of the site, so it never moves.
+        std::array<u32, HOOK_SITE_CAPACITY + 1> links = {};
+
+        [[nodiscard]] u32 linkAddress(size_t index) const {
+            return reinterpret_cast<u32>(&this->links[index]);
+        }
+
+        // Places a jump through `links[index]`.
+        [[nodiscard]] static std::optional<u32>
+        placeDispatch(u32 slot, std::optional<u32> memory) {
+            if (!memory.has_value())
+                return std::nullopt;
+
+            std::array<u32, 4> dispatchBytes = {};
+            const size_t       dispatchSize =
+                PPCAssembler::Emitter(dispatchBytes, memory.value())
+                    .jmpThrough(slot)
+                    .finish()
+                    .value()
+                * sizeof(u32);
+
+            Utils::Kernel::copyData(
+                OSEffectiveToPhysical(memory.value()),
+                OSEffectiveToPhysical(
+                    reinterpret_cast<u32>(dispatchBytes.data())),
+                dispatchSize);
+
+            Utils::Memory::invalidateICache(memory.value(), dispatchSize);
+
+            return memory;
+        }
+
+        // Writes the hook like `Patch::tryEnable`, claiming its words in the
+        // `PatchIndex` so that patches writing over them conflict.
+        [[nodiscard]] std::expected<void, PatchError> install() {
+            PatchBatch batch = {};
+            this->trampoline->enable(batch);
+
+            // Only for the state of the hook, the writes were never made.
+            auto undo = [&] {
+                PatchBatch undone = {};
+                this->trampoline->disable(undone);
+            };
+
+            // The originals the index reads are journaled from there.
+            OriginalSnapshot originals = {};
+
+            std::expected<PatchClaim, PatchWriteError> claim =
+                patchIndex().claim(batch.writes, originals,
+                                   Utils::Memory::KernelMemory{});
+            if (!claim.has_value()) {
+                undo();
+                return std::unexpected(claim.error());
+            }
+
+            batch.writes = std::move(claim->writes);
+
+            std::expected<PatchJournal, PatchWriteError> journal =
+                commitTransaction(batch, originals,
+                                  Utils::Memory::KernelMemory{});
+            if (!journal.has_value()) {
+                [[maybe_unused]] const std::vector<PatchWrite> restores =
+                    patchIndex().release(claim->addresses);
+                undo();
+
+                return std::unexpected(journal.error());
+            }
+
+            this->claims = std::move(claim->addresses);
+
+            return {};
+        }
+
+        // Restores the words of the hook that no patch writes anymore.
+        void uninstall() {
+            PatchBatch undone = {};
+            this->trampoline->disable(undone);
+
+            PatchBatch batch = {};
+            batch.writes = patchIndex().release(this->claims);
+            batch.commit(Utils::Memory::KernelMemory{});
+
+            this->claims.clear();
+        }
+
+        [[nodiscard]] bool anyEnabledBut(size_t index) const {
+            return std::ranges::any_of(
+                std::views::iota(size_t{0}, this->subscribers.size()),
+                [&](size_t i) {
+                    return i != index && this->subscribers[i].enabled;
+                });
+        }
+
+        // Later links first, so that a subscriber the game reaches through
+        // an updated link already has its own updated.
+        void relink() {
+            std::array<u32, HOOK_SITE_CAPACITY + 1> links = {};
+            linkSubscribers(this->subscribers, this->original, links);
+
+            for (size_t i = this->subscribers.size() + 1; i-- > 0;)
+                this->links[i] = links[i];
+        }
+
+      public:
+        HookSite(const HookSite&)            = delete;
+        HookSite& operator=(const HookSite&) = delete;
+
+        /// The site of `address`, created on first use with its trampoline
+        /// and the jump into the dispatch array.
+        [[nodiscard]] static std::expected<HookSite*, PatchError>
+        at(u32 address, CodeArena& arena) {
+            static std::map<u32, std::unique_ptr<HookSite>> sites = {};
+
+            if (auto it = sites.find(address); it != sites.end())
+                return it->second.get();
+
+            std::unique_ptr<HookSite> site(new HookSite());
+            site->address = address;
+
+            const std::optional<u32> entry = HookSite::placeDispatch(
+                site->linkAddress(0),
+                arena.allocateNear(address, 4 * sizeof(u32)).or_else([&] {
+                    return arena.allocate(4 * sizeof(u32));
+                }));
+            if (!entry.has_value())
+                MFATAL("Failed to allocate memory for hook site.");
+
+            void (*original)() = nullptr;
+            std::expected<TrampolinePatch, PatchError> trampoline =
+                TrampolinePatch::tryCreate(
+                    address, original,
+                    reinterpret_cast<const void*>(entry.value()), arena);
+            if (!trampoline.has_value()) {
+                arena.shrink(entry.value(), 0);
+                return std::unexpected(trampoline.error());
+            }
+
+            // A hook over words that an enabled patch writes differently
+            // fails here instead of when it is first enabled, before the
+            // site is added, and none of its stubs are kept.
+            PatchBatch hookWrites = {};
+            trampoline->enable(hookWrites);
+            if (const std::optional<PatchWriteError> conflict =
+                    patchIndex().findConflict(hookWrites.writes)) {
+                trampoline->release(arena);
+                arena.shrink(entry.value(), 0);
+                return std::unexpected(conflict.value());
+            }
+
+            site->original   = reinterpret_cast<u32>(original);
+            site->trampoline = std::move(trampoline.value());
+            site->relink();
+
+            return sites.emplace(address, std::move(site)).first->second.get();
+        }
+
+        /// Adds a disabled subscriber, returns its index and sets
+        /// `original` to where it continues.
+        [[nodiscard]] std::optional<size_t>
+        subscribe(u32 function, s32 priority, u32& original,
+                  CodeArena& arena) {
+            if (this->subscribers.size() == HOOK_SITE_CAPACITY)
+                return std::nullopt;
+
+            const size_t index = this->subscribers.size();
+
+            const std::optional<u32> dispatch = HookSite::placeDispatch(
+                this->linkAddress(index + 1),
+                arena.allocate(4 * sizeof(u32)));
+            if (!dispatch.has_value())
+                return std::nullopt;
+
+            this->subscribers.push_back(
+                HookSubscriber{.function = function, .priority = priority});
+            this->relink();
+
+            original = dispatch.value();
+
+            return index;
+        }
+
+        /// Enables or disables subscriber `index`. Fails, leaving it
+        /// disabled, if the hook of the site has to be written but a patch
+        /// already writes other bytes over it.
+        [[nodiscard]] std::expected<void, PatchError>
+        setEnabled(size_t index, bool enabled) {
+            const bool anyEnabled = enabled || this->anyEnabledBut(index);
+
+            if (anyEnabled && !this->installed) {
+                if (std::expected<void, PatchError> installed =
+                        this->install();
+                    !installed.has_value())
+                    return installed;
+            }
+
+            this->subscribers[index].enabled = enabled;
+            this->relink();
+
+            if (!anyEnabled && this->installed)
+                this->uninstall();
+
+            this->installed = anyEnabled;
+
+            return {};
+        }
+
+        /*
+         * @brief Enables subscriber `index` and adds the hook of the site to
+         * `batch`, so that a patch claims and commits it with the rest of
+         * its words, all or nothing. The hook is added by every patch that
+         * enables a subscriber; the `PatchIndex` writes it once and restores
+         * it when the last of them is disabled.
+         */
+        void enable(size_t index, PatchBatch& batch) {
+            this->trampoline->enable(batch);
+
+            this->subscribers[index].enabled = true;
+            this->relink();
+        }
+
+        /// Disables subscriber `index`. The writes that restore the hook
+        /// are added to `batch` once no subscriber is left, for patches that
+        /// are not indexed; indexed ones restore it from their claims.
+        void disable(size_t index, PatchBatch& batch) {
+            this->subscribers[index].enabled = false;
+            this->relink();
+
+            if (this->anyEnabledBut(index))
+                return;
+
+            if (this->installed) {
+                this->uninstall();
+                this->installed = false;
+                return;
+            }
+
+            this->trampoline->disable(batch);
+        }
+
+        [[nodiscard]] const Hook& getHook() const {
+            return this->trampoline->getHook();
+        }
+
+        [[nodiscard]] u32 getAddress() const { return this->address; }
+
+        [[nodiscard]] std::span<const HookSubscriber> getSubscribers() const {
+            return this->subscribers;
+        }
+    };
+
+    /*
+     * @brief A trampoline hook that shares its address with the other
+     * `SharedHook`s of it, e.g. from other modules, instead of overwriting
+     * their hook, see `HookSite`. In a patch, the hook of the site is one of
+     * the writes of the patch; `tryEnable` writes it on its own. Either way
+     * its words are claimed in the `PatchIndex`.
+     */
+    struct SharedHook {
+      private:
+        SharedHook(HookSite* site, size_t index)
+            : site(site)
+            , index(index) {}
+
+        HookSite* site;
+        size_t    index;
+
+      public:
+        [[nodiscard]] inline std::expected<void, PatchError> tryEnable() {
+            return this->site->setEnabled(this->index, true);
+        }
+
+        inline void enable() {
+            if (std::expected<void, PatchError> enabled = this->tryEnable();
+                !enabled.has_value())
+                MERROR("Shared hook of {:#x} not enabled: {}",
+                       this->site->getAddress(),
+                       patchErrorToStr(enabled.error()));
+        }
+
+        inline void disable() {
+            // Disabling never writes over another patch.
+            [[maybe_unused]] const std::expected<void, PatchError> disabled =
+                this->site->setEnabled(this->index, false);
+        }
+
+        inline void enable(PatchBatch& batch) {
+            this->site->enable(this->index, batch);
+        }
+
+        inline void disable(PatchBatch& batch) {
+            this->site->disable(this->index, batch);
+        }
+
+        [[nodiscard]] inline const Hook& getHook() const noexcept {
+            return this->site->getHook();
+        }
+
+        /// Subscribers with a lower `priority` run first, the original
+        /// function of the last one is the hooked one.
+        template <typename Return, typename... Args>
+        [[nodiscard]] static std::expected<SharedHook, PatchError>
+        tryCreate(uintptr_t address, Return (*&origFunction)(Args...),
+                  const void* replFunction, s32 priority = 0,
+                  CodeArena& arena = defaultCodeArena()) {
+            std::expected<HookSite*, PatchError> site =
+                HookSite::at(static_cast<u32>(address), arena);
+            if (!site.has_value())
+                return std::unexpected(site.error());
+
+            u32                         original = 0;
+            const std::optional<size_t> index    = site.value()->subscribe(
+                reinterpret_cast<u32>(replFunction), priority, original, arena);
+            if (!index.has_value())
+                MFATAL("Hook site {:#x} is full.", address);
+
+            origFunction = reinterpret_cast<Return (*)(Args...)>(original);
+
+            return SharedHook(site.value(), index.value());
+        }
+
+        template <typename Return, typename... Args>
+        [[nodiscard]] static SharedHook
+        create(uintptr_t address, Return (*&origFunction)(Args...),
+               const void* replFunction, s32 priority = 0,
+               CodeArena& arena = defaultCodeArena()) {
+            std::expected<SharedHook, PatchError> hook = SharedHook::tryCreate(
+                address, origFunction, replFunction, priority, arena);
+            if (!hook.has_value())
+                MFATAL("Failed to create shared hook of {:#x}: {}", address,
+                       patchErrorToStr(hook.error()));
+
+            return hook.value();
+        }
+    };
+
+#define INSTALL_SHARED_TRAMPOLINE(address, name, priority)                     \
+    ::LibMacchiato::SharedHook::create(                                        \
+        address, orig_##name, reinterpret_cast<void*>(repl_##name), priority)
+} // namespace LibMacchiato
@@ -0,0 +1,245 @@
+/*
+ * libmacchiato - Front-end for the Macchiato modding environment
+ * Copyright (C) 2024 splatoon1enjoyer @ SDL Foundation
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "Batch.h"
+#include "Error.h"
+#include "Snapshot.h"
+
+#include <sdl-utils/Types.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <expected>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace LibMacchiato {
+    /// Splits `runs` at word boundaries, so that the same bytes written by
+    /// two patches end up as the same writes whatever else they write.
+    constexpr std::vector<PatchWrite>
+    splitIntoWords(std::span<const PatchRun> runs) {
+        std::vector<PatchWrite> words = {};
+
+        for (const auto& run : runs) {
+            u32 address = run.address;
+
+            while (address < run.end()) {
+                const u32 end =
+                    std::min(run.end(), (address & ~3U) + 4U);
+
+                PatchWrite word = {.address = address,
+                                   .size    = static_cast<u8>(end - address),
+                                   .target  = run.target};
+                std::ranges::copy_n(run.bytes.begin()
+                                        + (address - run.address),
+                                    word.size, word.bytes.begin());
+
+                words.push_back(word);
+                address = end;
+            }
+        }
+
+        return words;
+    }
+
+    /// What `PatchIndex::claim` gave a patch: the words it owns, and the
+    /// writes of the ones no other patch had written yet.
+    struct PatchClaim {
+        std::vector<u32>        addresses = {};
+        std::vector<PatchWrite> writes    = {};
+    };
+
+    /*
+     * @brief The words of the game that enabled patches write, with the
+     * bytes they held before. Words never overlap, so they are kept sorted
+     * and any overlap is found with a binary search.
+     *
+     * A patch that writes the same bytes as one that is already enabled
+     * shares the word instead of writing it again. The original bytes are
+     * only restored once the last patch that owns it is disabled, whatever
+     * the order. Different bytes over an owned word are a conflict.
+     */
+    struct PatchIndex {
+      private:
+        struct Entry {
+            PatchWrite        write    = {};
+            std::array<u8, 4> original = {};
+            size_t            owners   = 0;
+        };
+
+        std::vector<Entry> entries = {};
+
+        // First entry that ends after `address`, the only one that can
+        // overlap a word starting there.
+        [[nodiscard]] constexpr auto after(u32 address) {
+            return std::ranges::partition_point(
+                this->entries, [&](const Entry& entry) {
+                    return entry.write.end() <= address;
+                });
+        }
+
+        [[nodiscard]] constexpr auto after(u32 address) const {
+            return std::ranges::partition_point(
+                this->entries, [&](const Entry& entry) {
+                    return entry.write.end() <= address;
+                });
+        }
+
+        [[nodiscard]] static constexpr bool same(const PatchWrite& lhs,
+                                                 const PatchWrite& rhs) {
+            return lhs.address == rhs.address && lhs.size == rhs.size
+                   && std::ranges::equal(
+                       std::span(lhs.bytes).first(lhs.size),
+                       std::span(rhs.bytes).first(rhs.size));
+        }
+
+        // An owned word that `word` overlaps with other bytes.
+        [[nodiscard]] constexpr std::optional<PatchWriteError>
+        conflict(const PatchWrite& word) const {
+            const auto entry = this->after(word.address);
+            if (entry == this->entries.end()
+                || entry->write.address >= word.end()
+                || PatchIndex::same(entry->write, word))
+                return std::nullopt;
+
+            return PatchWriteError{
+                .code    = PatchWriteErrorCode::Conflict,
+                .address = std::max(entry->write.address, word.address)};
+        }
+
+      public:
+        /*
+         * @brief Claims the words of `writes` for a patch. The original bytes
+         * of new ones are taken from `originals`, and the ones it lacks are
+         * captured into it first with one copy per contiguous range, so that
+         * the transaction that writes them reads nothing again. Nothing is
+         * claimed if any of them conflicts or is not mapped.
+         */
+        template <JournaledPatchMemory Memory>
+        constexpr std::expected<PatchClaim, PatchWriteError>
+        claim(std::span<const PatchWrite> writes, OriginalSnapshot& originals,
+              Memory&& memory) {
+            const std::vector<PatchWrite> words =
+                splitIntoWords(coalesceWrites(writes));
+
+            for (const auto& word : words) {
+                if (!memory.isMapped(word.address, word.size))
+                    return std::unexpected(PatchWriteError{
+                        .code    = PatchWriteErrorCode::UnmappedAddress,
+                        .address = word.address});
+
+                if (const std::optional<PatchWriteError> error =
+                        this->conflict(word))
+                    return std::unexpected(error.value());
+            }
+
+            PatchClaim         claim = {};
+            std::vector<Entry> added = {};
+
+            for (const auto& word : words) {
+                claim.addresses.push_back(word.address);
+
+                const auto entry = this->after(word.address);
+                if (entry != this->entries.end()
+                    && entry->write.address == word.address) {
+                    entry->owners++;
+                    continue;
+                }
+
+                added.push_back(Entry{.write = word, .owners = 1});
+                claim.writes.push_back(word);
+            }
+
+            for (const auto& entry : added) {
+                if (!originals.contains(entry.write.address, entry.write.size))
+                    originals.cover(entry.write.address, entry.write.size);
+            }
+
+            originals.capture(memory);
+
+            for (auto& entry : added) {
+                [[maybe_unused]] const bool captured = originals.read(
+                    entry.write.address,
+                    std::span(entry.original).first(entry.write.size));
+
+                this->entries.insert(this->after(entry.write.address), entry);
+            }
+
+            return claim;
+        }
+
+        /// `claim` that reads every original byte itself.
+        template <JournaledPatchMemory Memory>
+        constexpr std::expected<PatchClaim, PatchWriteError>
+        claim(std::span<const PatchWrite> writes, Memory&& memory) {
+            OriginalSnapshot originals = {};
+            return this->claim(writes, originals, memory);
+        }
+
+        /// The first word of `writes` that an enabled patch writes with
+        /// other bytes, e.g. to check a hook before placing its stubs.
+        [[nodiscard]] constexpr std::optional<PatchWriteError>
+        findConflict(std::span<const PatchWrite> writes) const {
+            for (const auto& word : splitIntoWords(coalesceWrites(writes))) {
+                if (const std::optional<PatchWriteError> error =
+                        this->conflict(word))
+                    return error;
+            }
+
+            return std::nullopt;
+        }
+
+        /// Gives up the words at `addresses`, returns the writes that
+        /// restore the ones no patch owns anymore.
+        constexpr std::vector<PatchWrite>
+        release(std::span<const u32> addresses) {
+            std::vector<PatchWrite> restores = {};
+
+            for (const u32 address : addresses) {
+                const auto entry = this->after(address);
+                if (entry == this->entries.end()
+                    || entry->write.address != address)
+                    continue;
+
+                if (--entry->owners != 0)
+                    continue;
+
+                PatchWrite restore = entry->write;
+                restore.bytes      = entry->original;
+
+                restores.push_back(restore);
+                this->entries.erase(entry);
+            }
+
+            return restores;
+        }
+
+        [[nodiscard]] constexpr size_t size() const {
+            return this->entries.size();
+        }
+    };
+
+    /// The index of every patch of the plugin, see `Patch::tryEnable`.
+    inline PatchIndex& patchIndex() {
+        static PatchIndex index = {};
+        return index;
+    }
+} // namespace LibMacchiato
@@ -18,20 +18,25 @@
 #pragma once
 
 #include "../Assembler.h"
+#include "../Assembler/Block.h"
+#include "../Assembler/Emitter.h"
 #include "../Log.h"
 #include "../Utils/Memory.h"
+#include "Batch.h"
 #include "Error.h"
+#include "Snapshot.h"
 
 #include <sdl-utils/Types.h>
 
 #include <coreinit/cache.h>
 #include <coreinit/memorymap.h>
 
+#include <array>
 #include <cstdint>
 #include <expected>
-#include <format>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
@@ -46,23 +51,6 @@ namespace LibMacchiato {
         BranchIfNotEqual,
     };
 
-    namespace {
-        inline std::string branchTypeToString(const BranchType branchType) {
-            switch (branchType) {
-            case BranchType::Branch:
-                return "b";
-            case BranchType::BranchLink:
-                return "bl";
-            case BranchType::BranchIfEqual:
-                return "beq";
-            case BranchType::BranchIfNotEqual:
-                return "bne";
-            }
-
-            return "unk";
-        }
-    } // namespace
-
     struct LinePatch {
       private:
         LinePatch(uintptr_t address, uintptr_t enableAssembly,
@@ -71,7 +59,7 @@ namespace LibMacchiato {
             , enableAssembly(enableAssembly)
             , disableAssembly(disableAssembly) {}
 
-        inline void apply(bool enable) {
+        inline void apply(PatchBatch& batch, bool enable) {
             u32 address = reinterpret_cast<u32>(this->address);
 
             if (!this->disableAssembly.has_value()) [[unlikely]] {
@@ -83,7 +71,13 @@ namespace LibMacchiato {
             enable ? assembly = static_cast<u32>(this->enableAssembly)
                    : assembly = static_cast<u32>(this->disableAssembly.value());
 
-            Utils::Memory::writeInstruction(address, assembly);
+            batch.writeWord(address, assembly);
+        }
+
+        inline void apply(bool enable) {
+            PatchBatch batch = {};
+            this->apply(batch, enable);
+            batch.commit(Utils::Memory::KernelMemory{});
         }
 
         // TODO:
@@ -104,6 +98,27 @@ namespace LibMacchiato {
         void enable() { this->apply(true); }
         void disable() { this->apply(false); }
 
+        /// Adds the write to `batch` instead of writing it right away.
+        void enable(PatchBatch& batch) { this->apply(batch, true); }
+        void disable(PatchBatch& batch) { this->apply(batch, false); }
+
+        /// Adds the word to `snapshot` if the original is not known yet.
+        void cover(OriginalSnapshot& snapshot) const {
+            if (!this->disableAssembly.has_value())
+                snapshot.cover(static_cast<u32>(this->address), sizeof(u32));
+        }
+
+        /// Takes the original word from `snapshot`, instead of reading it
+        /// on its own later.
+        void takeOriginal(const OriginalSnapshot& snapshot) {
+            if (this->disableAssembly.has_value())
+                return;
+
+            if (const std::optional<u32> original =
+                    snapshot.word(static_cast<u32>(this->address)))
+                this->disableAssembly = original.value();
+        }
+
         [[nodiscard]] static LinePatch create(uintptr_t address,
                                               uintptr_t enableAssembly) {
             return LinePatch(address, enableAssembly, std::nullopt);
@@ -121,6 +136,14 @@ namespace LibMacchiato {
             return LinePatch::create(address, assembledCode.value());
         }
 
+        /// Assembles `instruction` at build time, see
+        /// `PPCAssembler::assembleLiteral`.
+        template <PPCAssembler::FixedString instruction>
+        [[nodiscard]] static LinePatch line(uintptr_t address) {
+            return LinePatch::create(
+                address, PPCAssembler::assembleLiteral<instruction>());
+        }
+
         [[nodiscard]] static std::expected<std::vector<LinePatch>, PatchError>
         multiline(const uintptr_t                address,
                   const std::vector<std::string> instructions) {
@@ -142,16 +165,55 @@ namespace LibMacchiato {
             return lines;
         }
 
+        /// Patches `source` in place with `PPCAssembler::assembleBlock`, one
+        /// `LinePatch` per word.
+        [[nodiscard]] static std::expected<std::vector<LinePatch>, PatchError>
+        block(const uintptr_t address, std::string_view source,
+              const PPCAssembler::SymbolTable& symbols = {}) {
+            std::expected<std::vector<u32>, PPCAssembler::BlockError> code =
+                PPCAssembler::assembleBlock(source, address, symbols);
+
+            if (!code.has_value())
+                return std::unexpected<PatchError>(code.error());
+
+            std::vector<LinePatch> lines;
+            lines.reserve(code->size());
+
+            for (size_t i = 0; i < code->size(); i++)
+                lines.push_back(LinePatch::create(address + sizeof(u32) * i,
+                                                  code.value()[i]));
+
+            return lines;
+        }
+
         [[nodiscard]] static std::expected<LinePatch, PatchError>
         shortBranch(BranchType branchType, uintptr_t address, void* function) {
-            auto      functionAddress = reinterpret_cast<uintptr_t>(function);
-            uintptr_t relativeAddress = functionAddress - address;
+            auto functionAddress = reinterpret_cast<uintptr_t>(function);
+
+            std::array<u32, 1>    code = {};
+            PPCAssembler::Emitter emitter(code, static_cast<u32>(address));
+
+            switch (branchType) {
+            case BranchType::Branch:
+                emitter.b(static_cast<u32>(functionAddress));
+                break;
+            case BranchType::BranchLink:
+                emitter.bl(static_cast<u32>(functionAddress));
+                break;
+            case BranchType::BranchIfEqual:
+                emitter.beq(static_cast<u32>(functionAddress));
+                break;
+            case BranchType::BranchIfNotEqual:
+                emitter.bne(static_cast<u32>(functionAddress));
+                break;
+            }
 
-            std::string branchTypeStr = branchTypeToString(branchType);
-            std::string instruction =
-                std::format("{} {}", branchTypeStr, relativeAddress);
+            std::expected<size_t, PPCAssembler::AssembleError> size =
+                emitter.finish();
+            if (!size.has_value())
+                return std::unexpected<PatchError>(size.error());
 
-            return LinePatch::line(address, instruction);
+            return LinePatch::create(address, code[0]);
         }
 
         template <typename Class, typename Return, typename... Args>
@@ -0,0 +1,165 @@
+/*
+ * libmacchiato - Front-end for the Macchiato modding environment
+ * Copyright (C) 2024 splatoon1enjoyer @ SDL Foundation
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "Batch.h"
+
+#include <sdl-utils/Types.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace LibMacchiato {
+    /*
+     * @brief The original bytes of the game under a set of patches. Every
+     * component adds the range it overwrites with `cover`, `capture` then
+     * reads each contiguous range once, with a single copy, and the
+     * components take their original bytes from it instead of reading them
+     * word by word.
+     */
+    struct OriginalSnapshot {
+      private:
+        // Covered ranges, their bytes are only read by `capture`.
+        std::vector<PatchRun> pending = {};
+
+        // Sorted, read, and neither overlapping nor touching.
+        std::vector<PatchRun> runs = {};
+
+        // Adds a captured run, merged with the ones it touches, so that a
+        // range read in two captures is still found whole by `contains`.
+        // Bytes captured earlier are kept where they overlap.
+        constexpr void insert(PatchRun run) {
+            auto at = this->runs.insert(
+                std::ranges::upper_bound(this->runs, run.address, {},
+                                         &PatchRun::address),
+                std::move(run));
+
+            if (at != this->runs.begin()
+                && std::prev(at)->end() >= at->address) {
+                PatchRun& before = *std::prev(at);
+                if (at->end() > before.end())
+                    before.bytes.insert(before.bytes.end(),
+                                        at->bytes.begin()
+                                            + (before.end() - at->address),
+                                        at->bytes.end());
+
+                at = std::prev(this->runs.erase(at));
+            }
+
+            while (std::next(at) != this->runs.end()
+                   && std::next(at)->address <= at->end()) {
+                const PatchRun& after = *std::next(at);
+                if (after.end() > at->end())
+                    at->bytes.insert(at->bytes.end(),
+                                     after.bytes.begin()
+                                         + (at->end() - after.address),
+                                     after.bytes.end());
+
+                this->runs.erase(std::next(at));
+            }
+        }
+
+      public:
+        constexpr void cover(u32 address, u32 size) {
+            if (size == 0)
+                return;
+
+            PatchRun range = {.address = address};
+            range.bytes.resize(size);
+
+            this->pending.push_back(std::move(range));
+        }
+
+        /// Reads the covered ranges, merged where they touch or overlap.
+        /// Ranges that are not mapped yet, e.g. of a module that is not
+        /// loaded, are left for the components to read later.
+        template <JournaledPatchMemory Memory>
+        constexpr void capture(Memory&& memory) {
+            std::ranges::sort(this->pending, {}, &PatchRun::address);
+
+            std::vector<PatchRun> merged = {};
+            for (auto& range : this->pending) {
+                if (!merged.empty() && range.address <= merged.back().end()) {
+                    if (range.end() > merged.back().end())
+                        merged.back().bytes.resize(range.end()
+                                                   - merged.back().address);
+                    continue;
+                }
+
+                merged.push_back(std::move(range));
+            }
+
+            this->pending.clear();
+
+            for (auto& run : merged) {
+                const auto size = static_cast<u32>(run.bytes.size());
+                if (!memory.isMapped(run.address, size))
+                    continue;
+
+                memory.read(run.address, run.bytes);
+                this->insert(std::move(run));
+            }
+        }
+
+        /// Whether the `size` bytes at `address` were captured, in one range.
+        [[nodiscard]] constexpr bool contains(u32 address, u32 size) const {
+            const auto after = std::ranges::upper_bound(
+                this->runs, address, {}, &PatchRun::address);
+
+            return after != this->runs.begin()
+                   && address + size <= std::prev(after)->end();
+        }
+
+        /// Copies the original bytes at `address`, if they were captured.
+        [[nodiscard]] constexpr bool read(u32 address,
+                                          std::span<u8> bytes) const {
+            if (!this->contains(address, static_cast<u32>(bytes.size())))
+                return false;
+
+            const PatchRun& run = *std::prev(std::ranges::upper_bound(
+                this->runs, address, {}, &PatchRun::address));
+
+            std::ranges::copy_n(run.bytes.begin() + (address - run.address),
+                                static_cast<std::ptrdiff_t>(bytes.size()),
+                                bytes.begin());
+
+            return true;
+        }
+
+        [[nodiscard]] constexpr std::optional<u32> word(u32 address) const {
+            std::array<u8, sizeof(u32)> bytes = {};
+            if (!this->read(address, bytes))
+                return std::nullopt;
+
+            return std::bit_cast<u32>(bytes);
+        }
+
+        /// Disjoint ranges captured so far, each one read with a single
+        /// copy unless later captures extended it.
+        [[nodiscard]] constexpr size_t size() const {
+            return this->runs.size();
+        }
+    };
+} // namespace LibMacchiato
@@ -17,6 +17,10 @@
 
 #pragma once
 
+#include "../Assembler/Disassembler.h"
+#include "../Assembler/Emitter.h"
+#include "../Assembler/Peephole.h"
+#include "../Assembler/Relocation.h"
 #include "../Assert.h"
 #include "../Log.h"
 
@@ -24,6 +28,8 @@
 #include "../Utils/Bind.h"
 #include "../Utils/Kernel.h"
 
+#include "CodeArena.h"
+#include "Error.h"
 #include "Hook.h"
 #include "Line.h"
 
@@ -34,6 +40,8 @@
 #include <expected>
 #include <functional>
 #include <optional>
+#include <span>
+#include <vector>
 #include <sdl-utils/Types.h>
 
 #include <coreinit/cache.h>
@@ -90,10 +98,31 @@ namespace LibMacchiato {
         inline void enable() { this->hook.enable(); }
         inline void disable() { this->hook.disable(); }
 
+        inline void enable(PatchBatch& batch) { this->hook.enable(batch); }
+        inline void disable(PatchBatch& batch) { this->hook.disable(batch); }
+
+        [[nodiscard]] inline const Hook& getHook() const noexcept {
+            return this->hook;
+        }
+
+        /// Gives the trampoline and the thunk of its hook back to `arena`,
+        /// for a trampoline that is dropped before it was ever enabled.
+        inline void release(CodeArena& arena) {
+            arena.shrink(reinterpret_cast<u32>(this->origFunction), 0);
+            this->hook.release(arena);
+        }
+
+        /*
+         * @brief Hooks `address` and places the instructions the hook
+         * overwrites in a trampoline, which `origFunction` points to, see
+         * `PPCAssembler::relocate`. Fails if the code around the hook branches
+         * into the middle of the overwritten instructions.
+         */
         template <typename Return, typename... Args>
-        [[nodiscard]] static TrampolinePatch
-        create(uintptr_t   address, Return (*&origFunction)(Args...),
-               const void* replFunction) {
+        [[nodiscard]] static std::expected<TrampolinePatch, PatchError>
+        tryCreate(uintptr_t   address, Return (*&origFunction)(Args...),
+                  const void* replFunction,
+                  CodeArena&  arena = defaultCodeArena()) {
             // If the function starts with a jump, that probably means that the
             // function has already been hooked. In that case, recursively
             // update the address to point to the previous trampoline.
@@ -101,60 +130,65 @@ namespace LibMacchiato {
             //     Utils::Assembly::getAdjustedAddressIfFirstInstructionIsBranch(
             //         address);
 
-            const Hook hook = Hook::create(address, replFunction);
-
-            std::vector<u32> trampBytes = {};
-
-            for (const auto& patch : hook.getBranchData()) {
-                const u32  assembly       = patch.getDisableAssembly();
-                const u32  opcode         = assembly & 0xFC000003;
-                const bool opcodeIsBranch = opcode == 0x48000000;
+            Hook hook = Hook::create(address, replFunction, arena);
+            hook.captureOriginal();
 
-                if (!opcodeIsBranch) {
-                    trampBytes.push_back(assembly);
-                    continue;
-                }
+            std::vector<u32> displacedBytes = {};
+            for (const auto& patch : hook.getBranchData())
+                displacedBytes.push_back(patch.getDisableAssembly());
 
-                u32 jumpOffset = assembly & 0x01FFFFFC;
+            const PPCAssembler::DisplacedCode displaced = {
+                .address = static_cast<u32>(address), .code = displacedBytes};
 
-                // Sign extension check
-                if ((jumpOffset & 0x02000000) != jumpOffset) {
-                    jumpOffset += 0xFE000000;
-                }
-
-                const u32 absoluteJumpAddress =
-                    jumpOffset + static_cast<u32>(patch.getAddress());
+            if (const std::optional<PPCAssembler::RelocationError> error =
+                    Hook::findBranchInto(displaced)) {
+                hook.release(arena);
+                return std::unexpected(error.value());
+            }
 
-                const std::expected<u32, PPCAssembler::AssembleError>
-                    shortBranch = PPCAssembler::assemble(
-                        std::format("ba {}", absoluteJumpAddress));
+            // Every moved instruction takes at most its longest relocation,
+            // plus the jump back to the rest of the function.
+            const size_t trampCapacity =
+                displacedBytes.size() * PPCAssembler::MAX_RELOCATED_SIZE
+                + Utils::Assembly::MAX_JUMP_SIZE;
+
+            // The memory is allocated first, so that the jumps can use the
+            // relative form when the trampoline is close enough.
+            const std::optional<u32> memAddress =
+                arena.allocateNear(address, trampCapacity * sizeof(u32))
+                    .or_else([&] {
+                        return arena.allocate(trampCapacity * sizeof(u32));
+                    });
+            if (!memAddress.has_value()) {
+                MFATAL("Failed to allocate memory for trampoline patch.");
+            }
 
-                if (shortBranch.has_value()) {
-                    trampBytes.push_back(shortBranch.value());
-                    continue;
-                }
+            void* mem = reinterpret_cast<void*>(memAddress.value());
 
-                std::vector<u32> jumpToOrigBytes =
-                    Utils::Assembly::jump(absoluteJumpAddress);
+            std::vector<u32>      trampBytes(trampCapacity);
+            PPCAssembler::Emitter emitter(trampBytes,
+                                          reinterpret_cast<u32>(mem));
 
-                trampBytes.insert(trampBytes.end(), jumpToOrigBytes.begin(),
-                                  jumpToOrigBytes.end());
+            if (const std::expected<size_t, PPCAssembler::AssembleError>
+                    relocated = PPCAssembler::relocate(emitter, displaced);
+                !relocated.has_value()) {
+                arena.shrink(memAddress.value(), 0);
+                hook.release(arena);
+                return std::unexpected(relocated.error());
             }
 
-            const u32 remainingFunctionStart =
-                address + hook.getBranchData().size() * sizeof(u32);
-            const std::vector<u32> jumpBackBytes =
-                Utils::Assembly::jump(remainingFunctionStart);
+            Utils::Assembly::jump(emitter, displaced.end());
 
-            trampBytes.insert(trampBytes.end(), jumpBackBytes.begin(),
-                              jumpBackBytes.end());
+            trampBytes.resize(emitter.finish().value());
 
-            const size_t trampBytesSize = trampBytes.size() * sizeof(u32);
+            [[maybe_unused]] const PPCAssembler::PeepholeStats stats =
+                PPCAssembler::optimizeSequence(trampBytes,
+                                               reinterpret_cast<u32>(mem));
+            MDBGINFO("Trampoline of {:#x} saved {} words", address,
+                     stats.wordsSaved);
 
-            void* mem = reinterpret_cast<void*>(new u8[trampBytesSize]);
-            if (!mem) {
-                MFATAL("Failed to allocate memory for trampoline patch.");
-            }
+            const size_t trampBytesSize = trampBytes.size() * sizeof(u32);
+            arena.shrink(memAddress.value(), trampBytesSize);
 
             Utils::Kernel::copyData(
                 OSEffectiveToPhysical(reinterpret_cast<u32>(mem)),
@@ -171,6 +205,21 @@ namespace LibMacchiato {
                                    reinterpret_cast<void*>(origFunction),
                                    replFunction, std::move(hook));
         }
+
+        template <typename Return, typename... Args>
+        [[nodiscard]] static TrampolinePatch
+        create(uintptr_t   address, Return (*&origFunction)(Args...),
+               const void* replFunction,
+               CodeArena&  arena = defaultCodeArena()) {
+            std::expected<TrampolinePatch, PatchError> trampoline =
+                TrampolinePatch::tryCreate(address, origFunction, replFunction,
+                                           arena);
+            if (!trampoline.has_value())
+                MFATAL("Failed to create trampoline of {:#x}: {}", address,
+                       patchErrorToStr(trampoline.error()));
+
+            return std::move(trampoline.value());
+        }
     };
 
 #define TRAMPOLINE(name, res, ...)                                             \
@@ -0,0 +1,127 @@
+/*
+ * libmacchiato - Front-end for the Macchiato modding environment
+ * Copyright (C) 2024 splatoon1enjoyer @ SDL Foundation
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "Batch.h"
+#include "Error.h"
+#include "Snapshot.h"
+
+#include <sdl-utils/Types.h>
+
+#include <cstddef>
+#include <expected>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace LibMacchiato {
+    /// The bytes a transaction overwrote, one run per run it wrote.
+    struct PatchJournal {
+        std::vector<PatchRun> runs = {};
+
+        [[nodiscard]] constexpr bool empty() const {
+            return this->runs.empty();
+        }
+
+        /// Writes the original bytes back, one copy per run, and empties the
+        /// journal.
+        template <PatchMemory Memory> constexpr void restore(Memory&& memory) {
+            for (const auto& run : this->runs)
+                writeRun(memory, run);
+
+            this->runs.clear();
+        }
+    };
+
+    /*
+     * @brief Writes `batch` all or nothing. Every run is checked before
+     * anything is written, and the original bytes are journaled, taken from
+     * `originals` where it captured them already, e.g. when the words were
+     * claimed, so that no range is read twice. If a run does not read back
+     * as written, the runs written so far are restored. On success, the
+     * journal undoes the whole transaction with `PatchJournal::restore`.
+     */
+    template <JournaledPatchMemory Memory>
+    constexpr std::expected<PatchJournal, PatchWriteError>
+    commitTransaction(PatchBatch& batch, OriginalSnapshot& originals,
+                      Memory&& memory) {
+        std::vector<PatchRun> runs = coalesceWrites(batch.writes);
+        batch.writes.clear();
+
+        for (const auto& run : runs) {
+            const auto size = static_cast<u32>(run.bytes.size());
+
+            if (run.target == PatchTarget::Code
+                && (run.address % sizeof(u32) != 0 || size % sizeof(u32) != 0))
+                return std::unexpected(PatchWriteError{
+                    .code    = PatchWriteErrorCode::UnalignedCode,
+                    .address = run.address});
+
+            if (!memory.isMapped(run.address, size))
+                return std::unexpected(PatchWriteError{
+                    .code    = PatchWriteErrorCode::UnmappedAddress,
+                    .address = run.address});
+
+            if (!originals.contains(run.address, size))
+                originals.cover(run.address, size);
+        }
+
+        originals.capture(memory);
+
+        PatchJournal journal = {};
+        journal.runs.reserve(runs.size());
+
+        for (const auto& run : runs) {
+            PatchRun original = {.address = run.address,
+                                 .target  = run.target,
+                                 .bytes   = std::vector<u8>(run.bytes.size())};
+            [[maybe_unused]] const bool captured =
+                originals.read(original.address, original.bytes);
+
+            journal.runs.push_back(std::move(original));
+        }
+
+        std::vector<u8> written = {};
+
+        for (size_t i = 0; i < runs.size(); i++) {
+            writeRun(memory, runs[i]);
+
+            written.resize(runs[i].bytes.size());
+            memory.read(runs[i].address, written);
+
+            if (written != runs[i].bytes) {
+                journal.runs.resize(i + 1);
+                journal.restore(memory);
+
+                return std::unexpected(
+                    PatchWriteError{.code    = PatchWriteErrorCode::WriteFailed,
+                                    .address = runs[i].address});
+            }
+        }
+
+        return journal;
+    }
+
+    /// `commitTransaction` that reads every original byte itself.
+    template <JournaledPatchMemory Memory>
+    constexpr std::expected<PatchJournal, PatchWriteError>
+    commitTransaction(PatchBatch& batch, Memory&& memory) {
+        OriginalSnapshot originals = {};
+        return commitTransaction(batch, originals, memory);
+    }
+} // namespace LibMacchiato
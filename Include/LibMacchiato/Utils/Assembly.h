@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../Assembler/Emitter.h"
 #include "../Patch/Line.h"
 
 #include <sdl-utils/Types.h>
@@ -7,16 +8,25 @@
 #include <vector>
 
 namespace LibMacchiato::Utils::Assembly {
+    /// Words taken by the longest jump, `lis/ori/mtctr/bctr`.
+    constexpr size_t MAX_JUMP_SIZE = 4;
+
     uintptr_t getAdjustedAddressIfFirstInstructionIsBranch(uintptr_t address);
 
     inline bool shortJumpIsPossible(uintptr_t address) {
-        return address <= 0x01FFFFFC;
+        return PPCAssembler::absoluteBranchFits(static_cast<u32>(address));
     }
 
     inline size_t getJumpSize(uintptr_t address) {
-        return shortJumpIsPossible(address) ? 1 : 4;
+        return shortJumpIsPossible(address) ? 1 : MAX_JUMP_SIZE;
     }
 
+    /// Emits the shortest jump to `dst` from the emitter's address, which
+    /// clobbers r11 and the count register if `dst` is out of range of both
+    /// `b` and `ba`.
+    void jump(PPCAssembler::Emitter& emitter, u32 dst);
+
+    /// Jump to `dst` that can be placed anywhere, i.e. `ba` or the long form.
     std::vector<u32>       jump(u32 dst);
     std::vector<LinePatch> jump(u32 address, u32 dst);
 } // namespace LibMacchiato::Utils::Assembly
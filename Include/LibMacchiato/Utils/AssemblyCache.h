@@ -0,0 +1,30 @@
+#pragma once
+
+#include "../Export.h"
+
+#include <sdl-utils/Types.h>
+
+#include <string>
+
+/*
+ * @brief Keeps the assembly cache of a plugin on the SD card between boots.
+ * The loader has no init or deinit hook that libmacchiato could run, so a
+ * plugin that wants the cache calls `load` when it starts, before it
+ * assembles anything, and `save` when it is unloaded. Without them nothing
+ * is cached and the assembler does not pay for cache keys either. See the
+ * README for where the calls go.
+ */
+namespace LibMacchiato::Utils::AssemblyCache {
+    /// Identifies a plugin build, the cache of any other build is discarded.
+    [[nodiscard]] u64 buildHash(const MacchiatoExport& macchiatoExport);
+
+    [[nodiscard]] std::string cachePath(const MacchiatoExport& macchiatoExport);
+
+    /// Installs the cache saved by the last boot of this build, or an empty
+    /// one. Returns whether a saved cache was found.
+    bool load(const MacchiatoExport& macchiatoExport);
+
+    /// Evicts the entries that this boot did not use and writes the installed
+    /// cache to the SD card if it changed.
+    bool save(const MacchiatoExport& macchiatoExport);
+} // namespace LibMacchiato::Utils::AssemblyCache
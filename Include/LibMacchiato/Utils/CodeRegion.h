@@ -0,0 +1,26 @@
+#pragma once
+
+#include <sdl-utils/Types.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+
+namespace LibMacchiato::Utils::Memory {
+    /// The `CodeRegion` of `CodePool`, slabs come from the heap of the
+    /// plugin, which the game can execute.
+    struct HeapCodeRegion {
+        [[nodiscard]] std::optional<u32> reserve(u32 size, u32 alignment) {
+            void* memory = std::aligned_alloc(alignment, size);
+            if (!memory)
+                return std::nullopt;
+
+            return static_cast<u32>(reinterpret_cast<uintptr_t>(memory));
+        }
+
+        void release(u32 address, [[maybe_unused]] u32 size) {
+            std::free(
+                reinterpret_cast<void*>(static_cast<uintptr_t>(address)));
+        }
+    };
+} // namespace LibMacchiato::Utils::Memory
@@ -10,6 +10,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <functional>
+#include <span>
 #include <string.h>
 
 namespace LibMacchiato::Utils::Memory {
@@ -79,6 +80,61 @@ namespace LibMacchiato::Utils::Memory {
 #endif
     }
 
+    /// Writes `bytes` at `address` with a single kernel copy, without
+    /// touching the caches.
+    inline void writeBytes(u32 address, std::span<const u8> bytes) {
+#ifndef MACCHIATO_TARGET_EMU
+        ::LibMacchiato::Utils::Kernel::copyData(
+            OSEffectiveToPhysical(address),
+            OSEffectiveToPhysical(reinterpret_cast<u32>(bytes.data())),
+            bytes.size());
+#else
+        std::memcpy(reinterpret_cast<void*>(address), bytes.data(),
+                    bytes.size());
+#endif
+    }
+
+    /// Reads `bytes.size()` bytes at `address` with a single kernel copy.
+    inline void readBytes(u32 address, std::span<u8> bytes) {
+#ifndef MACCHIATO_TARGET_EMU
+        ::LibMacchiato::Utils::Kernel::copyData(
+            OSEffectiveToPhysical(reinterpret_cast<u32>(bytes.data())),
+            OSEffectiveToPhysical(address), bytes.size());
+#else
+        std::memcpy(bytes.data(), reinterpret_cast<const void*>(address),
+                    bytes.size());
+#endif
+    }
+
+    /// The `PatchMemory` of the running game, see `PatchBatch::commit` and
+    /// `commitTransaction`.
+    struct KernelMemory {
+        void copy(u32 address, std::span<const u8> bytes) {
+            writeBytes(address, bytes);
+        }
+
+        void read(u32 address, std::span<u8> bytes) {
+            readBytes(address, bytes);
+        }
+
+        [[nodiscard]] bool isMapped(u32 address, u32 size) const {
+#ifndef MACCHIATO_TARGET_EMU
+            return size != 0 && OSEffectiveToPhysical(address) != 0
+                   && OSEffectiveToPhysical(address + size - 1) != 0;
+#else
+            return size != 0;
+#endif
+        }
+
+        void invalidateCode(u32 address, u32 size) {
+            invalidateICache(address, size);
+        }
+
+        void invalidateData(u32 address, u32 size) {
+            invalidateDCache(address, size);
+        }
+    };
+
     inline u32 readU32(u32 address) {
         u32 bytes = 0;
 
@@ -102,4 +102,8 @@ namespace LibMacchiato {
             return triplet;
         }
     };
+
+    // Keep in sync with the `project` version in `CMakeLists.txt`.
+    constexpr VersionTriplet LIBMACCHIATO_VERSION = {
+        .major = 1, .minor = 0, .patch = 0};
 } // namespace LibMacchiato
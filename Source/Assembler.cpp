@@ -16,343 +16,289 @@
  */
 
 #include "LibMacchiato/Assembler.h"
+#include "LibMacchiato/Assembler/Cache.h"
+#include "LibMacchiato/Assembler/Codegen.h"
 #include "LibMacchiato/Assembler/Error.h"
+#include "LibMacchiato/Assembler/Lexer.h"
+#include "LibMacchiato/Assembler/PerfectHash.h"
 
-#include <sdl-utils/NumUtil.h>
-#include <sdl-utils/StringUtil.h>
 #include <sdl-utils/Types.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <cstddef>
+#include <cstdlib>
 #include <expected>
+#include <mutex>
 #include <optional>
+#include <span>
 #include <string>
 #include <string_view>
-#include <unordered_map>
-#include <vector>
-
-//
-#include "LibMacchiato/Log.h"
 
 namespace LibMacchiato::PPCAssembler {
     namespace {
-        // Generated assembly gets cached because modules tend to use similar
-        // assemblies. Disable this functionality via:
-        // `MACCHIATO_NO_ASSEMBLY_MEMO=1`.
-        std::unordered_map<std::string, u32> assemblyMemo = {};
-    } // namespace
-
-    uint32_t generateMask(size_t bitWidth) {
-        return bitWidth == 32 ? 0xFFFFFFFF
-                              : (1U << static_cast<u32>(bitWidth)) - 1;
-    }
-
-    std::string format(const std::string& instruction) {
-        std::string result = instruction;
-        std::transform(result.begin(), result.end(), result.begin(),
-                       [](unsigned char c) { return std::tolower(c); });
-        return result;
-    }
-
-    std::expected<Operand, AssembleError>
-    tokenizeOperandSegment(const std::string_view segment) {
-        std::string segmentStr = std::string(segment);
-
-        if (segment.starts_with("0x")) {
-            std::optional<u32> immediate =
-                SDLUtils::hexStrToInt<u32>(segmentStr);
-            if (!immediate.has_value())
-                return std::unexpected<IntegerConversionFailure>(segmentStr);
-
-            return ImmediateOperand{.value = immediate.value()};
-        } else if (segment.starts_with("r")) {
-            segmentStr.erase(0, 1);
-
-            std::optional<u32> registerNum =
-                SDLUtils::strToInt<u32>(segmentStr);
-            if (!registerNum.has_value())
-                return std::unexpected<IntegerConversionFailure>(segmentStr);
-
-            std::optional<Register> reg = numToReg(registerNum.value());
-            if (!reg.has_value())
-                return std::unexpected<InvalidOperand>(
-                    InvalidOperand{.operand = segmentStr});
-
-            return DirectOperand{.regType = RegisterType::GPR,
-                                 .reg     = reg.value()};
-        } else if (segment.contains("(")) {
-            if (!segment.contains(")")) {
-                return std::unexpected<InvalidInstruction>(
-                    InvalidInstruction{});
+        constexpr size_t MEMO_SET_NUM   = 128;
+        constexpr size_t MEMO_WAY_NUM   = 4;
+        constexpr size_t MEMO_KEY_SIZE  = 47;
+        constexpr size_t MEMO_SHARD_NUM = 8;
+
+        // Instructions are memoized in their normalized spelling, so that
+        // `LI R3,1` and `li r3, 1` share one entry.
+        struct NormalizedKey {
+            std::array<char, MEMO_KEY_SIZE> data = {};
+            size_t                          size = 0;
+
+            [[nodiscard]] std::string_view view() const {
+                return std::string_view(this->data.data(), this->size);
             }
+        };
 
-            std::vector<std::string> indirectOperands =
-                SDLUtils::splitf(std::string(segment), '(');
-
-            std::string offsetStr       = indirectOperands[0];
-            std::string rightStr        = indirectOperands[1];
-            std::string baseRegisterStr = SDLUtils::splitf(rightStr, ')')[0];
+        constexpr bool isPunctuation(char c) {
+            return c == ',' || c == '(' || c == ')';
+        }
 
-            if (!std::string_view(baseRegisterStr).starts_with("r")) {
-                return std::unexpected<InvalidOperand>(
-                    InvalidOperand{.operand = baseRegisterStr});
-            }
+        // Lowercases `instruction` and collapses its whitespace into at most
+        // one space between tokens, dropping it around punctuation. Returns
+        // `std::nullopt` for instructions too long to be memoized.
+        std::optional<NormalizedKey> normalize(std::string_view instruction) {
+            NormalizedKey key          = {};
+            bool          pendingSpace = false;
+            char          previous     = '\0';
+
+            for (const char c : trim(instruction)) {
+                if (isSpace(c)) {
+                    pendingSpace = true;
+                    continue;
+                }
 
-            baseRegisterStr.erase(0, 1);
+                if (pendingSpace && !isPunctuation(c)
+                    && !isPunctuation(previous)) {
+                    if (key.size == MEMO_KEY_SIZE)
+                        return std::nullopt;
+                    key.data[key.size++] = ' ';
+                }
 
-            std::optional<u32> offset = std::nullopt;
+                if (key.size == MEMO_KEY_SIZE)
+                    return std::nullopt;
+                key.data[key.size++] = toLower(c);
 
-            if (std::string_view(offsetStr).starts_with("0x")) {
-                offset = SDLUtils::hexStrToInt<u32>(segmentStr);
-            } else {
-                offset = SDLUtils::strToInt<u32>(offsetStr);
+                pendingSpace = false;
+                previous     = c;
             }
 
-            if (!offset.has_value())
-                return std::unexpected<IntegerConversionFailure>(segmentStr);
-
-            std::optional<u32> baseRegister =
-                SDLUtils::strToInt<u32>(baseRegisterStr);
-            if (!baseRegister.has_value())
-                return std::unexpected<IntegerConversionFailure>(
-                    baseRegisterStr);
-
-            std::optional<Register> reg = numToReg(baseRegister.value());
-            if (!reg.has_value())
-                return std::unexpected<InvalidOperand>(
-                    InvalidOperand{.operand = baseRegisterStr});
-
-            return IndirectOperand{.offset = offset.value(),
-                                   .reg    = reg.value()};
+            return key;
         }
 
-        std::optional<u32> immediate = SDLUtils::strToInt<u32>(segmentStr);
-        if (!immediate.has_value())
-            return std::unexpected<IntegerConversionFailure>(segmentStr);
+        struct MemoEntry {
+            u64                             hash    = 0;
+            u32                             code    = 0;
+            u8                              keySize = 0;
+            std::array<char, MEMO_KEY_SIZE> key     = {};
 
-        return ImmediateOperand{.value = immediate.value()};
-    }
-
-    /// Generates the operands from the given input.
-    std::expected<OperandList, AssembleError>
-    tokenizeOperandsSegment(const std::string& operandSegment) {
-        std::vector<std::string> rawOperands =
-            SDLUtils::splitf(operandSegment, ',');
-        OperandList operands = {std::nullopt, std::nullopt, std::nullopt};
-
-        size_t i = 0;
+            [[nodiscard]] bool matches(u64 hash, std::string_view key) const {
+                return this->keySize != 0 && this->hash == hash
+                       && std::string_view(this->key.data(), this->keySize)
+                              == key;
+            }
+        };
+
+        struct MemoSet {
+            std::array<MemoEntry, MEMO_WAY_NUM> entries = {};
+
+            // Round-robin victim for the next insertion.
+            size_t next = 0;
+        };
+
+        /*
+         * @brief Set-associative cache with a fixed number of entries. Every
+         * key can only live in the `MEMO_WAY_NUM` entries of the set its hash
+         * selects, so a lookup compares a handful of entries and never
+         * allocates. Inserting into a full set evicts its oldest entry.
+         *
+         * The sets are split into shards with a lock each, so threads
+         * assembling different instructions rarely wait on each other.
+         */
+        struct MemoShard {
+            std::mutex mutex = {};
+
+            std::array<MemoSet, MEMO_SET_NUM / MEMO_SHARD_NUM> sets = {};
+
+            size_t hits      = 0;
+            size_t misses    = 0;
+            size_t size      = 0;
+            size_t evictions = 0;
+
+            MemoSet& setOf(u64 hash) {
+                return this->sets[static_cast<size_t>(hash)
+                                  & (this->sets.size() - 1)];
+            }
 
-        for (auto rawOperand = rawOperands.begin();
-             rawOperand != rawOperands.end(); rawOperand++) {
-            size_t i = std::distance(rawOperands.begin(), rawOperand);
+            [[nodiscard]] std::optional<u32> find(u64              hash,
+                                                  std::string_view key) {
+                std::lock_guard lock(this->mutex);
 
-            std::expected<Operand, AssembleError> operand =
-                tokenizeOperandSegment(*rawOperand);
+                for (const auto& entry : this->setOf(hash).entries) {
+                    if (entry.matches(hash, key)) {
+                        this->hits++;
+                        return entry.code;
+                    }
+                }
 
-            if (!operand.has_value()) {
-                return std::unexpected<AssembleError>(operand.error());
+                this->misses++;
+                return std::nullopt;
             }
 
-            operands[i] = operand.value();
+            void insert(u64 hash, std::string_view key, u32 code) {
+                std::lock_guard lock(this->mutex);
 
-            i++;
-        }
+                MemoSet& set = this->setOf(hash);
 
-        return operands;
-    }
-
-    std::expected<PPCInstruction, AssembleError>
-    getInstruction(const std::string& instruction) {
-        std::string trimmedInstruction = SDLUtils::trim(instruction);
+                // Another thread may have assembled the same instruction
+                // since the lookup missed.
+                for (const auto& entry : set.entries) {
+                    if (entry.matches(hash, key))
+                        return;
+                }
 
-        std::vector<std::string> instructionSegments =
-            SDLUtils::splitf(trimmedInstruction, ' ');
+                MemoEntry& entry = set.entries[set.next];
 
-        if (instructionSegments.empty()) {
-            return std::unexpected<EmptyInstruction>(EmptyInstruction{});
-        }
+                if (entry.keySize != 0)
+                    this->evictions++;
+                else
+                    this->size++;
 
-        std::string& mnemonicStr = instructionSegments[0];
+                entry.hash    = hash;
+                entry.code    = code;
+                entry.keySize = static_cast<u8>(key.size());
+                std::copy(key.begin(), key.end(), entry.key.begin());
 
-        std::optional<PPCMnemonic> mnemonic = strToMnemonic(mnemonicStr);
+                set.next = (set.next + 1) % MEMO_WAY_NUM;
+            }
 
-        if (!mnemonic.has_value())
-            return std::unexpected<InvalidMnemonic>(
-                InvalidMnemonic{.mnemonic = mnemonicStr});
+            void addStats(AssemblyMemoStats& stats) {
+                std::lock_guard lock(this->mutex);
 
-        std::vector<std::string> operandSegment(instructionSegments.begin() + 1,
-                                                instructionSegments.end());
+                stats.hits += this->hits;
+                stats.misses += this->misses;
+                stats.size += this->size;
+                stats.evictions += this->evictions;
+            }
 
-        std::string operandSegmentStr = {};
-        for (const auto& operand : operandSegment) {
-            operandSegmentStr = operandSegmentStr + operand;
-        }
+            void clear() {
+                std::lock_guard lock(this->mutex);
 
-        if (!operandSegmentStr.empty()) {
-            std::expected<OperandList, AssembleError> operands =
-                tokenizeOperandsSegment(operandSegmentStr);
+                this->sets.fill(MemoSet{});
 
-            if (!operands.has_value()) {
-                return std::unexpected<AssembleError>(operands.error());
+                this->hits      = 0;
+                this->misses    = 0;
+                this->size      = 0;
+                this->evictions = 0;
             }
+        };
 
-            return PPCInstruction{.mnemonic = mnemonic.value(),
-                                  .operands = operands.value()};
-        } else {
-            return PPCInstruction{.mnemonic = mnemonic.value(),
-                                  .operands = EMPTY_OPERAND_LIST};
-        }
-    }
+        struct AssemblyMemo {
+            std::array<MemoShard, MEMO_SHARD_NUM> shards = {};
 
-    /// Asserts that the input tokens match an instruction definition.
-    std::optional<PPCInstructionDef>
-    instructionize(const PPCMnemonic mnemonic, const OperandList& operands) {
-        for (const auto& instructionDef : PPC_INSTRUCTION_TABLE) {
-            if (instructionDef.mnemonic == mnemonic) {
-                if (instructionDef.isEqWithOperands(operands)) {
-                    return instructionDef;
-                } else {
-                    break;
-                }
+            // The set index uses the low bits of the hash, the shard the high
+            // ones.
+            MemoShard& shardOf(u64 hash) {
+                return this->shards[static_cast<size_t>(hash >> 32)
+                                    & (MEMO_SHARD_NUM - 1)];
             }
-        }
-
-        return std::nullopt;
-    }
 
-    std::expected<u32, AssembleError>
-    codegenSegment(const Operand& operand, const OperandDef& operandDef) {
-        size_t pos  = operandDef.pos;
-        size_t bits = operandDef.bits;
-
-        if (auto immediate = std::get_if<ImmediateOperand>(&operand)) {
-            if (!std::holds_alternative<ImmediateOperandDefType>(
-                    operandDef.type)) {
-                return std::unexpected<OperandMismatch>(OperandMismatch{
-                    .operand = operand, .expectedOperand = operandDef});
+            [[nodiscard]] std::optional<u32> find(u64              hash,
+                                                  std::string_view key) {
+                return this->shardOf(hash).find(hash, key);
             }
 
-            size_t bitsTaken = SDLUtils::countBitsTaken(immediate->value);
-
-            if (bitsTaken > bits) {
-                return std::unexpected<IntegerTooLarge>(IntegerTooLarge{
-                    .integer = immediate->value, .maxBits = bits});
+            void insert(u64 hash, std::string_view key, u32 code) {
+                this->shardOf(hash).insert(hash, key, code);
             }
 
-            return immediate->value << (32 - (pos + bits));
-        } else if (auto reg = std::get_if<DirectOperand>(&operand)) {
-            if (auto regDef =
-                    std::get_if<DirectOperandDefType>(&operandDef.type)) {
-                if (reg->regType != regDef->regType)
-                    return std::unexpected<RegisterTypeMismatch>(
-                        RegisterTypeMismatch{.regType = reg->regType,
-                                             .expectedRegType =
-                                                 regDef->regType});
-
-                u32    regNum    = regToNum(reg->reg);
-                size_t bitsTaken = SDLUtils::countBitsTaken(regNum);
-
-                if (bitsTaken > bits) {
-                    return std::unexpected<IntegerTooLarge>(IntegerTooLarge{
-                        .integer = immediate->value, .maxBits = bits});
-                }
-
-                return regNum << (32 - (pos + bits));
-            } else {
-                return std::unexpected<OperandMismatch>(OperandMismatch{
-                    .operand = operand, .expectedOperand = operandDef});
-            }
-        } else if (auto indirect = std::get_if<IndirectOperand>(&operand)) {
-            if (auto indirectDef =
-                    std::get_if<IndirectOperandDefType>(&operandDef.type)) {
-                u32 value = 0;
-
-                u32    base     = regToNum(indirect->reg);
-                size_t basePos  = pos;
-                size_t baseBits = bits - indirectDef->offsetBits;
-
-                u32    offset     = indirect->offset;
-                size_t offsetPos  = indirectDef->offsetPos;
-                size_t offsetBits = indirectDef->offsetBits;
-
-                if (SDLUtils::countBitsTaken(base) > baseBits) {
-                    return std::unexpected<IntegerTooLarge>(
-                        IntegerTooLarge{.integer = base, .maxBits = baseBits});
-                }
+            [[nodiscard]] AssemblyMemoStats stats() {
+                AssemblyMemoStats stats = {.capacity = MEMO_SET_NUM
+                                                       * MEMO_WAY_NUM};
 
-                if (SDLUtils::countBitsTaken(offset) > offsetBits) {
-                    return std::unexpected<IntegerTooLarge>(IntegerTooLarge{
-                        .integer = offset, .maxBits = offsetBits});
-                }
+                for (auto& shard : this->shards)
+                    shard.addStats(stats);
 
-                value |= base << (basePos - baseBits);
+                return stats;
+            }
 
-                return value;
-            } else {
-                return std::unexpected<OperandMismatch>(OperandMismatch{
-                    .operand = operand, .expectedOperand = operandDef});
+            void clear() {
+                for (auto& shard : this->shards)
+                    shard.clear();
             }
-        } else {
-            return std::unexpected<InvalidInstruction>(InvalidInstruction{});
-        }
-    }
+        };
 
-    // Generates the final assembly from the tokens.
-    std::expected<u32, AssembleError>
-    codegen(const PPCInstruction&    instruction,
-            const PPCInstructionDef& instructionDef) {
-        u32 data = 0;
-
-        data = (mnemonicToOpcode(instruction.mnemonic) & 0x3F) << 26;
-        data |= instructionDef.mask;
-
-        for (size_t i = 0; i < OPERAND_NUM; i++) {
-            if (instruction.operands[i].has_value()
-                && instructionDef.operands[i].has_value()) {
-                std::expected<u32, AssembleError> result =
-                    codegenSegment(instruction.operands[i].value(),
-                                   instructionDef.operands[i].value());
-
-                if (!result.has_value()) {
-                    return std::unexpected<AssembleError>(result.error());
-                }
+        static_assert(std::has_single_bit(MEMO_SET_NUM)
+                      && std::has_single_bit(MEMO_SHARD_NUM)
+                      && MEMO_SET_NUM >= MEMO_SHARD_NUM);
 
-                data |= result.value();
-            }
+        // Generated assembly gets cached because modules tend to use similar
+        // assemblies. Disable this functionality at build time with
+        // `MACCHIATO_NO_ASSEMBLY_MEMO`, or at runtime through the environment
+        // variable `MACCHIATO_NO_ASSEMBLY_MEMO=1` or
+        // `setAssemblyMemoEnabled`.
+        AssemblyMemo assemblyMemo = {};
+
+        bool memoEnabledByDefault() {
+#ifdef MACCHIATO_NO_ASSEMBLY_MEMO
+            return false;
+#else
+            const char* disable = std::getenv("MACCHIATO_NO_ASSEMBLY_MEMO");
+
+            return !disable || std::string_view(disable) != "1";
+#endif
         }
 
-        return data;
-    }
+        std::atomic<bool> assemblyMemoEnabled = memoEnabledByDefault();
+    } // namespace
 
     std::expected<u32, AssembleError>
     assemble(const std::string& instructionStr) {
-        const std::string formattedInstruction = format(instructionStr);
+        std::optional<NormalizedKey> key  = std::nullopt;
+        u64                          hash = 0;
 
-#ifndef MACCHIATO_NO_ASSEMBLY_MEMO
-        if (assemblyMemo.contains(formattedInstruction))
-            return assemblyMemo[formattedInstruction];
-#endif
+        if (assemblyMemoEnabled.load(std::memory_order_relaxed)) {
+            key = normalize(instructionStr);
 
-        const std::expected<PPCInstruction, AssembleError> instruction =
-            getInstruction(formattedInstruction);
-        if (!instruction.has_value())
-            return std::unexpected<AssembleError>(instruction.error());
+            if (key.has_value()) {
+                hash = hashString(key->view());
 
-        std::optional<PPCInstructionDef> instructionDef = instructionize(
-            instruction.value().mnemonic, instruction.value().operands);
-        if (!instructionDef.has_value())
-            return std::unexpected<InvalidInstruction>(InvalidInstruction{});
+                if (std::optional<u32> code =
+                        assemblyMemo.find(hash, key->view());
+                    code.has_value())
+                    return code.value();
+            }
+        }
+
+        std::optional<u32> cached = findCachedInstruction(instructionStr);
 
+        // Lexing only views `instructionStr`, so assembling does not touch the
+        // heap.
         std::expected<u32, AssembleError> code =
-            codegen(instruction.value(), instructionDef.value());
+            cached.has_value() ? cached.value() : assembleView(instructionStr);
 
         if (!code.has_value()) {
             return std::unexpected<AssembleError>(code.error());
         }
 
-#ifndef MACCHIATO_NO_ASSEMBLY_MEMO
-        assemblyMemo[formattedInstruction] = code.value();
-#endif
+        if (key.has_value())
+            assemblyMemo.insert(hash, key->view(), code.value());
+        if (!cached.has_value())
+            cacheAssembly(instructionStr, std::span(&code.value(), 1));
 
         return code;
     }
+
+    AssemblyMemoStats getAssemblyMemoStats() { return assemblyMemo.stats(); }
+
+    void setAssemblyMemoEnabled(bool enabled) {
+        assemblyMemoEnabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    void clearAssemblyMemo() { assemblyMemo.clear(); }
 } // namespace LibMacchiato::PPCAssembler
@@ -0,0 +1,867 @@
+/*
+ * libmacchiato - Front-end for the Macchiato modding environment
+ * Copyright (C) 2024 splatoon1enjoyer @ SDL Foundation
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "LibMacchiato/Assembler/Block.h"
+#include "LibMacchiato/Assembler/Cache.h"
+#include "LibMacchiato/Assembler/Codegen.h"
+#include "LibMacchiato/Assembler/Disassembler.h"
+#include "LibMacchiato/Assembler/Emitter.h"
+#include "LibMacchiato/Assembler/Error.h"
+#include "LibMacchiato/Assembler/Lexer.h"
+#include "LibMacchiato/Assembler/Literal.h"
+#include "LibMacchiato/Assembler/Range.h"
+
+#include <sdl-utils/Types.h>
+
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cstddef>
+#include <expected>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace LibMacchiato::PPCAssembler {
+    using namespace Literals;
+
+    namespace {
+        // The skip of a conditional branch and `lis/ori/mtctr/bctr`.
+        constexpr size_t MAX_BRANCH_SIZE = 5 * sizeof(u32);
+        constexpr size_t MAX_ALIGN_POWER = 12;
+
+        enum class StatementType {
+            Instruction,
+            Branch,
+            Load,
+            Long,
+            Float,
+            Align,
+        };
+
+        enum class BranchForm {
+            // The branch itself.
+            Short,
+            // `ba` or `bla` in place of `b` or `bl`.
+            Absolute,
+            // A conditional branch with the inverted condition that skips
+            // over a `b` to the target.
+            Near,
+            // `li32 r11` followed by `mtctr/bctr(l)`, behind the inverted
+            // condition for conditional branches.
+            Long,
+        };
+
+        struct Statement {
+            StatementType    type = StatementType::Instruction;
+            size_t           line = 0;
+            std::string_view text = {};
+
+            // Branches and loads, `text` holds the target or the value and
+            // `operands` the operands before it, e.g. the CR field of `beq`
+            // or the register of `li32`.
+            std::string_view operands = {};
+
+            // Value of `text` once laid out, unless it refers to a label.
+            u32 target = 0;
+
+            // Branches only. `jmp` and `call` are `b` and `bl` that also
+            // take an absolute address as their target.
+            PPCMnemonic mnemonic = PPCMnemonic::B;
+            BranchForm  form     = BranchForm::Short;
+            bool        pseudo   = false;
+
+            // Loads only, whether the value takes `lis/ori` instead of `li`
+            // or `lis`.
+            bool split = false;
+
+            // Aligns only.
+            size_t alignment = 0;
+
+            // Offset and size in bytes within the block.
+            size_t offset = 0;
+            size_t size   = 0;
+        };
+
+        struct Program {
+            // The whole block, every `std::string_view` below points into it
+            // and so do the spans of the errors.
+            std::string_view source = {};
+
+            std::vector<Statement> statements = {};
+
+            // Label name to the index of the statement that follows it.
+            std::map<std::string_view, size_t, std::less<>> labels = {};
+
+            size_t size = 0;
+        };
+
+        constexpr bool equalsIgnoreCase(std::string_view lhs,
+                                        std::string_view rhs) {
+            if (lhs.size() != rhs.size())
+                return false;
+
+            for (size_t i = 0; i < lhs.size(); i++) {
+                if (toLower(lhs[i]) != toLower(rhs[i]))
+                    return false;
+            }
+
+            return true;
+        }
+
+        // Branches whose last operand is a target and can therefore refer
+        // to labels or symbols.
+        std::optional<PPCMnemonic> branchMnemonic(std::string_view mnemonic) {
+            for (const PPCMnemonic branch :
+                 {PPCMnemonic::B, PPCMnemonic::BA, PPCMnemonic::BL,
+                  PPCMnemonic::BC, PPCMnemonic::BEQ, PPCMnemonic::BNE,
+                  PPCMnemonic::BLT, PPCMnemonic::BGE, PPCMnemonic::BGT,
+                  PPCMnemonic::BLE}) {
+                if (equalsIgnoreCase(mnemonic, mnemonicToStr(branch)))
+                    return branch;
+            }
+
+            return std::nullopt;
+        }
+
+        std::optional<PPCMnemonic>
+        pseudoBranchMnemonic(std::string_view mnemonic) {
+            if (equalsIgnoreCase(mnemonic, "jmp"))
+                return PPCMnemonic::B;
+            if (equalsIgnoreCase(mnemonic, "call"))
+                return PPCMnemonic::BL;
+
+            return std::nullopt;
+        }
+
+        bool isLoadMnemonic(std::string_view mnemonic) {
+            return equalsIgnoreCase(mnemonic, "li32")
+                   || equalsIgnoreCase(mnemonic, "la");
+        }
+
+        constexpr bool isConditional(PPCMnemonic mnemonic) {
+            return mnemonic != PPCMnemonic::B && mnemonic != PPCMnemonic::BA
+                   && mnemonic != PPCMnemonic::BL;
+        }
+
+        // The simplified mnemonic that branches in exactly the opposite case,
+        // for stepping over a branch that cannot reach its target.
+        constexpr std::optional<PPCMnemonic>
+        invertCondition(PPCMnemonic mnemonic) {
+            switch (mnemonic) {
+            case PPCMnemonic::BEQ:
+                return PPCMnemonic::BNE;
+            case PPCMnemonic::BNE:
+                return PPCMnemonic::BEQ;
+            case PPCMnemonic::BLT:
+                return PPCMnemonic::BGE;
+            case PPCMnemonic::BGE:
+                return PPCMnemonic::BLT;
+            case PPCMnemonic::BGT:
+                return PPCMnemonic::BLE;
+            case PPCMnemonic::BLE:
+                return PPCMnemonic::BGT;
+            default:
+                return std::nullopt;
+            }
+        }
+
+        BlockError blockError(size_t line, AssembleError error) {
+            return BlockError{.line = line, .error = error};
+        }
+
+        // Makes `error`, raised by `part` of the block, relative to the whole
+        // block. Errors that already point into `part` keep their place in
+        // it, the others are about all of `part`.
+        AssembleError inBlock(const Program& program, std::string_view part,
+                              const AssembleError& error) {
+            if (error.hasSpan())
+                return error.shifted(part.data() - program.source.data());
+
+            return error.at(program.source, part);
+        }
+
+        std::expected<Statement, AssembleError>
+        parseDirective(std::string_view text) {
+            size_t nameEnd = 0;
+            while (nameEnd < text.size() && !isSpace(text[nameEnd]))
+                nameEnd++;
+
+            const std::string_view name     = text.substr(0, nameEnd);
+            const std::string_view argument = trim(text.substr(nameEnd));
+
+            if (argument.empty())
+                return std::unexpected(assembleError(
+                    AssembleErrorCode::InvalidDirective, text, text));
+
+            if (equalsIgnoreCase(name, ".long"))
+                return Statement{.type = StatementType::Long,
+                                 .text = argument};
+
+            if (equalsIgnoreCase(name, ".float"))
+                return Statement{.type = StatementType::Float,
+                                 .text = argument};
+
+            if (equalsIgnoreCase(name, ".align")) {
+                std::optional<u32> power = lexInteger(argument);
+                if (!power.has_value() || power.value() > MAX_ALIGN_POWER)
+                    return std::unexpected(assembleError(
+                        AssembleErrorCode::InvalidDirective, text, argument));
+
+                return Statement{.type      = StatementType::Align,
+                                 .text      = argument,
+                                 .alignment = size_t{1} << power.value()};
+            }
+
+            return std::unexpected(assembleError(
+                AssembleErrorCode::InvalidDirective, text, name));
+        }
+
+        Statement parseInstruction(std::string_view text) {
+            size_t mnemonicEnd = 0;
+            while (mnemonicEnd < text.size() && !isSpace(text[mnemonicEnd]))
+                mnemonicEnd++;
+
+            const std::string_view mnemonic = text.substr(0, mnemonicEnd);
+            const std::string_view operands = trim(text.substr(mnemonicEnd));
+
+            const size_t comma = operands.rfind(',');
+            const std::string_view target =
+                comma == std::string_view::npos
+                    ? operands
+                    : trim(operands.substr(comma + 1));
+            const std::string_view leading =
+                comma == std::string_view::npos
+                    ? std::string_view()
+                    : trim(operands.substr(0, comma));
+
+            // Numeric targets keep their single line meaning.
+            if (std::optional<PPCMnemonic> branch = branchMnemonic(mnemonic);
+                branch.has_value() && isSymbolicExpression(target)
+                && (leading.empty() || isConditional(branch.value())))
+                return Statement{.type     = StatementType::Branch,
+                                 .text     = target,
+                                 .operands = leading,
+                                 .mnemonic = branch.value()};
+
+            if (std::optional<PPCMnemonic> branch =
+                    pseudoBranchMnemonic(mnemonic);
+                branch.has_value() && leading.empty() && !target.empty())
+                return Statement{.type     = StatementType::Branch,
+                                 .text     = target,
+                                 .mnemonic = branch.value(),
+                                 .pseudo   = true};
+
+            if (isLoadMnemonic(mnemonic) && !leading.empty())
+                return Statement{.type     = StatementType::Load,
+                                 .text     = target,
+                                 .operands = leading};
+
+            return Statement{.type = StatementType::Instruction, .text = text};
+        }
+
+        std::expected<Program, BlockError> parse(std::string_view source,
+                                                 const SymbolTable& symbols) {
+            Program program = {.source = source};
+            size_t  line    = 0;
+
+            while (!source.empty()) {
+                line++;
+
+                const size_t     lineEnd = source.find('\n');
+                std::string_view text    = source.substr(0, lineEnd);
+                source = lineEnd == std::string_view::npos
+                             ? std::string_view()
+                             : source.substr(lineEnd + 1);
+
+                text = trim(text.substr(0, text.find_first_of("#;")));
+
+                if (const size_t colon = text.find(':');
+                    colon != std::string_view::npos
+                    && isIdentifier(trim(text.substr(0, colon)))) {
+                    const std::string_view label = trim(text.substr(0, colon));
+
+                    if (program.labels.contains(label)
+                        || symbols.find(label) != symbols.end())
+                        return std::unexpected(blockError(
+                            line,
+                            assembleError(AssembleErrorCode::DuplicateLabel,
+                                          program.source, label)));
+
+                    program.labels.emplace(label, program.statements.size());
+                    text = trim(text.substr(colon + 1));
+                }
+
+                if (text.empty())
+                    continue;
+
+                if (text.starts_with('.')) {
+                    std::expected<Statement, AssembleError> directive =
+                        parseDirective(text);
+                    if (!directive.has_value())
+                        return std::unexpected(blockError(
+                            line, inBlock(program, text, directive.error())));
+
+                    program.statements.push_back(directive.value());
+                } else {
+                    program.statements.push_back(parseInstruction(text));
+                }
+
+                program.statements.back().line = line;
+            }
+
+            return program;
+        }
+
+        std::optional<u32> resolve(const Program&     program,
+                                   std::string_view   name,
+                                   u32                address,
+                                   const SymbolTable& symbols) {
+            if (auto label = program.labels.find(name);
+                label != program.labels.end()) {
+                const size_t index = label->second;
+
+                return address
+                       + static_cast<u32>(
+                           index < program.statements.size()
+                               ? program.statements[index].offset
+                               : program.size);
+            }
+
+            if (auto symbol = symbols.find(name); symbol != symbols.end())
+                return symbol->second;
+
+            return std::nullopt;
+        }
+
+        // Evaluates an expression over the labels of `program`, placed at
+        // `address`, and `symbols`.
+        std::expected<u32, AssembleError>
+        evaluate(const Program& program, std::string_view text, u32 address,
+                 const SymbolTable& symbols) {
+            return evaluateExpression(text, [&](std::string_view name) {
+                return resolve(program, name, address, symbols);
+            });
+        }
+
+        // Whether the value of `text` moves with the layout.
+        bool refersToLabel(const Program& program, std::string_view text) {
+            return anyExpressionSymbol(text, [&](std::string_view name) {
+                return program.labels.contains(name);
+            });
+        }
+
+        // Value of the target of a branch or of a load that does not refer
+        // to a label, which does not depend on the layout.
+        std::expected<u32, AssembleError>
+        constantValue(const Statement& statement, const SymbolTable& symbols) {
+            return evaluateExpression(
+                statement.text,
+                [&](std::string_view name) -> std::optional<u32> {
+                    if (auto symbol = symbols.find(name);
+                        symbol != symbols.end())
+                        return symbol->second;
+
+                    return std::nullopt;
+                });
+        }
+
+        std::expected<u32, AssembleError>
+        targetOf(const Program& program, const Statement& statement,
+                 u32 address, const SymbolTable& symbols) {
+            if (refersToLabel(program, statement.text))
+                return evaluate(program, statement.text, address, symbols);
+
+            return statement.target;
+        }
+
+        size_t branchSize(const Statement& branch) {
+            const size_t skipSize =
+                isConditional(branch.mnemonic) ? sizeof(u32) : 0;
+
+            switch (branch.form) {
+            case BranchForm::Short:
+            case BranchForm::Absolute:
+                return sizeof(u32);
+            case BranchForm::Near:
+                return skipSize + sizeof(u32);
+            case BranchForm::Long:
+                return skipSize
+                       + indirectBranchSize(branch.target) * sizeof(u32);
+            }
+
+            return sizeof(u32);
+        }
+
+        // The next larger form for a branch that cannot reach its target, if
+        // there is one. `bc` has no simplified opposite to skip with.
+        std::optional<BranchForm> relaxedForm(const Statement& branch) {
+            if (branch.form == BranchForm::Long)
+                return std::nullopt;
+
+            if (!isConditional(branch.mnemonic))
+                return branch.form == BranchForm::Short
+                               && branch.mnemonic != PPCMnemonic::BA
+                           ? BranchForm::Absolute
+                           : BranchForm::Long;
+
+            if (!invertCondition(branch.mnemonic).has_value())
+                return std::nullopt;
+
+            return branch.form == BranchForm::Short ? BranchForm::Near
+                                                    : BranchForm::Long;
+        }
+
+        bool branchFits(const Statement& branch, u32 target, u32 address) {
+            if (branch.form == BranchForm::Long)
+                return true;
+
+            if (branch.form == BranchForm::Absolute
+                || branch.mnemonic == PPCMnemonic::BA)
+                return absoluteBranchFits(target);
+
+            // A near branch reaches its target with the `b` after the skip,
+            // which has the range of an unconditional branch.
+            const u32 pc = address + static_cast<u32>(branch.offset)
+                           + (branch.form == BranchForm::Near ? sizeof(u32)
+                                                               : 0);
+
+            if (isConditional(branch.mnemonic)
+                && branch.form == BranchForm::Short)
+                return conditionalBranchFits(pc, target);
+
+            return relativeBranchFits(pc, target);
+        }
+
+        size_t statementSize(const Statement&   statement,
+                             std::optional<u32> address) {
+            if (statement.type == StatementType::Align) {
+                if (!address.has_value())
+                    return statement.alignment > sizeof(u32)
+                               ? statement.alignment - sizeof(u32)
+                               : 0;
+
+                const size_t misalignment =
+                    (address.value() + statement.offset) % statement.alignment;
+
+                return misalignment == 0 ? 0
+                                         : statement.alignment - misalignment;
+            }
+
+            if (statement.type == StatementType::Branch)
+                return branchSize(statement);
+
+            if (statement.type == StatementType::Load)
+                return statement.split ? 2 * sizeof(u32) : sizeof(u32);
+
+            return sizeof(u32);
+        }
+
+        // Assigns every statement its offset. With an unknown `address`, the
+        // layout is the largest one that any address can produce.
+        std::expected<void, BlockError>
+        layout(Program& program, std::optional<u32> address,
+               const SymbolTable& symbols) {
+            for (auto& statement : program.statements) {
+                if (statement.type != StatementType::Branch
+                    && statement.type != StatementType::Load)
+                    continue;
+
+                // Labels move with the layout, so their loads start small
+                // and grow like the branches below.
+                if (refersToLabel(program, statement.text)) {
+                    statement.split = !address.has_value();
+                    continue;
+                }
+
+                std::expected<u32, AssembleError> target =
+                    constantValue(statement, symbols);
+                if (!target.has_value())
+                    return std::unexpected(blockError(
+                        statement.line,
+                        inBlock(program, statement.text, target.error())));
+
+                statement.target = target.value();
+                statement.split  = loadImmediateSize(target.value()) > 1;
+
+                if (statement.type == StatementType::Branch
+                    && !address.has_value())
+                    statement.form =
+                        relaxedForm(statement).has_value() ? BranchForm::Long
+                                                           : BranchForm::Short;
+            }
+
+            // Branches and loads only ever grow, so this settles after at most
+            // a few rounds per statement.
+            bool changed = true;
+            while (changed) {
+                changed       = false;
+                size_t offset = 0;
+
+                for (auto& statement : program.statements) {
+                    statement.offset = offset;
+                    statement.size   = statementSize(statement, address);
+
+                    offset += statement.size;
+                }
+
+                program.size = offset;
+
+                if (!address.has_value())
+                    break;
+
+                for (auto& statement : program.statements) {
+                    if (statement.type == StatementType::Load
+                        && refersToLabel(program, statement.text)) {
+                        std::expected<u32, AssembleError> value =
+                            targetOf(program, statement, address.value(),
+                                     symbols);
+                        if (!value.has_value())
+                            return std::unexpected(blockError(
+                                statement.line,
+                                inBlock(program, statement.text,
+                                        value.error())));
+
+                        if (!statement.split
+                            && loadImmediateSize(value.value()) > 1) {
+                            statement.split = true;
+                            changed         = true;
+                        }
+                        continue;
+                    }
+
+                    if (statement.type != StatementType::Branch
+                        || refersToLabel(program, statement.text))
+                        continue;
+
+                    std::optional<BranchForm> relaxed =
+                        relaxedForm(statement);
+                    if (relaxed.has_value()
+                        && !branchFits(statement, statement.target,
+                                       address.value())) {
+                        statement.form = relaxed.value();
+                        changed        = true;
+                    }
+                }
+            }
+
+            return {};
+        }
+
+        // Whether the code of a laid out block is the same wherever it is
+        // placed, i.e. it only refers to its own labels relative to itself.
+        // Anything less obvious is taken to depend on the address.
+        bool isPositionIndependent(const Program& program) {
+            for (const auto& statement : program.statements) {
+                switch (statement.type) {
+                case StatementType::Align:
+                    return false;
+                case StatementType::Branch:
+                    if (!program.labels.contains(statement.text)
+                        || statement.mnemonic == PPCMnemonic::BA
+                        || (statement.form != BranchForm::Short
+                            && statement.form != BranchForm::Near))
+                        return false;
+                    break;
+                case StatementType::Instruction:
+                case StatementType::Load:
+                case StatementType::Long:
+                    if (refersToLabel(program, statement.text))
+                        return false;
+                    break;
+                case StatementType::Float:
+                    break;
+                }
+            }
+
+            return true;
+        }
+
+        // The code of a block depends on the symbols it was given and, unless
+        // it is position independent, on where it is placed. Those blocks go
+        // without an address so that their entries survive the heap moving
+        // between boots.
+        std::string blockCacheKey(std::string_view   source,
+                                  std::optional<u32> address,
+                                  const SymbolTable& symbols) {
+            std::string key = std::string(source);
+
+            key += '\0';
+            key += address.has_value() ? immediateToStr(address.value()) : "*";
+            for (const auto& [name, value] : symbols) {
+                key += '\0';
+                key += name;
+                key += '=';
+                key += immediateToStr(value);
+            }
+
+            return key;
+        }
+
+        // Tokenizes the operands of a conditional branch, followed by its
+        // displacement. Errors point into `operands`.
+        std::expected<PPCInstruction, AssembleError>
+        conditionalBranch(PPCMnemonic mnemonic, std::string_view operands,
+                          u32 displacement) {
+            PPCInstruction instruction = {.mnemonic = mnemonic,
+                                          .operands = EMPTY_OPERAND_LIST};
+            std::string_view condition = operands;
+            size_t           i         = 0;
+
+            while (!condition.empty()) {
+                const size_t           comma = condition.find(',');
+                const std::string_view segment =
+                    trim(condition.substr(0, comma));
+
+                std::expected<Operand, AssembleError> operand =
+                    lexOperand(segment);
+                if (!operand.has_value())
+                    return std::unexpected(operand.error().shifted(
+                        segment.data() - operands.data()));
+                if (i + 1 >= OPERAND_NUM)
+                    return std::unexpected(
+                        assembleError(AssembleErrorCode::InstructionTooLarge,
+                                      operands, condition));
+
+                instruction.operands[i++] = operand.value();
+
+                condition = comma == std::string_view::npos
+                                ? std::string_view()
+                                : condition.substr(comma + 1);
+            }
+
+            instruction.operands[i] = ImmediateOperand{.value = displacement};
+            return instruction;
+        }
+
+        // Errors of the emitters below are relative to the whole block.
+        std::expected<void, AssembleError>
+        emitBranch(std::vector<u32>& code, const Program& program,
+                   const Statement& branch, u32 target, u32 address) {
+            std::array<u32, MAX_BRANCH_SIZE / sizeof(u32)> words = {};
+            Emitter emitter(words, address + static_cast<u32>(branch.offset));
+
+            if (isConditional(branch.mnemonic)) {
+                // Either the branch itself or the skip over the longer forms.
+                const bool skip = branch.form != BranchForm::Short;
+                std::expected<PPCInstruction, AssembleError> instruction =
+                    conditionalBranch(
+                        skip ? invertCondition(branch.mnemonic).value()
+                             : branch.mnemonic,
+                        branch.operands,
+                        skip ? static_cast<u32>(branchSize(branch))
+                             : target - emitter.pc());
+                if (!instruction.has_value())
+                    return std::unexpected(inBlock(program, branch.operands,
+                                                   instruction.error()));
+
+                emitter.instruction(instruction.value());
+            }
+
+            if (branch.form == BranchForm::Long) {
+                emitter.li32(Register::R11, target).mtctr(Register::R11);
+                branch.mnemonic == PPCMnemonic::BL ? emitter.bctrl()
+                                                   : emitter.bctr();
+            } else if (branch.form == BranchForm::Absolute) {
+                branch.mnemonic == PPCMnemonic::BL ? emitter.bla(target)
+                                                   : emitter.ba(target);
+            } else if (branch.mnemonic == PPCMnemonic::BA) {
+                emitter.ba(target);
+            } else if (branch.mnemonic == PPCMnemonic::BL) {
+                emitter.bl(target);
+            } else if (!isConditional(branch.mnemonic)
+                       || branch.form == BranchForm::Near) {
+                emitter.b(target);
+            }
+
+            // Operands at fault can only be the ones of the condition, the
+            // displacement is ours.
+            std::expected<size_t, AssembleError> size = emitter.finish();
+            if (!size.has_value())
+                return std::unexpected(inBlock(
+                    program,
+                    size.error().operand != NO_OPERAND ? branch.operands
+                                                       : branch.text,
+                    size.error()));
+
+            code.insert(code.end(), words.begin(),
+                        words.begin() + size.value());
+            return {};
+        }
+
+        std::expected<void, AssembleError>
+        emitLoad(std::vector<u32>& code, const Program& program,
+                 const Statement& load, u32 value) {
+            std::expected<Operand, AssembleError> operand =
+                lexOperand(load.operands);
+            if (!operand.has_value())
+                return std::unexpected(
+                    inBlock(program, load.operands, operand.error()));
+
+            const DirectOperand* dst =
+                std::get_if<DirectOperand>(&operand.value());
+            if (dst == nullptr)
+                return std::unexpected(inBlock(
+                    program, load.operands,
+                    assembleError(AssembleErrorCode::InvalidOperand)));
+            if (dst->regType != RegisterType::GPR)
+                return std::unexpected(
+                    inBlock(program, load.operands,
+                            registerTypeMismatch(dst->regType,
+                                                 RegisterType::GPR)));
+
+            std::array<u32, 2> words = {};
+            Emitter            emitter(words, 0);
+
+            // A load laid out for a larger value keeps its size.
+            if (load.split && loadImmediateSize(value) == 1)
+                emitter.lis(dst->reg, static_cast<u16>(value >> 16))
+                    .ori(dst->reg, dst->reg, static_cast<u16>(value));
+            else
+                emitter.li32(dst->reg, value);
+
+            std::expected<size_t, AssembleError> size = emitter.finish();
+            if (!size.has_value())
+                return std::unexpected(
+                    inBlock(program, load.text, size.error()));
+
+            code.insert(code.end(), words.begin(),
+                        words.begin() + size.value());
+            return {};
+        }
+
+        std::expected<u32, AssembleError> evaluateFloat(std::string_view text) {
+            f32 value = 0;
+
+            const auto [end, error] =
+                std::from_chars(text.data(), text.data() + text.size(), value);
+            if (error != std::errc() || end != text.data() + text.size())
+                return std::unexpected(assembleError(
+                    AssembleErrorCode::IntegerConversionFailure, text, text));
+
+            return std::bit_cast<u32>(value);
+        }
+
+        std::expected<void, AssembleError>
+        emit(std::vector<u32>& code, const Program& program,
+             const Statement& statement, u32 address,
+             const SymbolTable& symbols) {
+            std::expected<u32, AssembleError> word = 0;
+
+            switch (statement.type) {
+            case StatementType::Instruction:
+                word = assembleView(statement.text, [&](std::string_view name) {
+                    return resolve(program, name, address, symbols);
+                });
+                break;
+            case StatementType::Branch:
+            case StatementType::Load: {
+                std::expected<u32, AssembleError> target =
+                    targetOf(program, statement, address, symbols);
+                if (!target.has_value())
+                    return std::unexpected(
+                        inBlock(program, statement.text, target.error()));
+
+                return statement.type == StatementType::Branch
+                           ? emitBranch(code, program, statement,
+                                        target.value(), address)
+                           : emitLoad(code, program, statement, target.value());
+            }
+            case StatementType::Long:
+                word = evaluate(program, statement.text, address, symbols);
+                break;
+            case StatementType::Float:
+                word = evaluateFloat(statement.text);
+                break;
+            case StatementType::Align:
+                code.insert(code.end(), statement.size / sizeof(u32),
+                            "nop"_ppc);
+                return {};
+            }
+
+            if (!word.has_value())
+                return std::unexpected(
+                    inBlock(program, statement.text, word.error()));
+
+            code.push_back(word.value());
+            return {};
+        }
+    } // namespace
+
+    std::expected<std::vector<u32>, BlockError>
+    assembleBlock(std::string_view source, u32 address,
+                  const SymbolTable& symbols) {
+        // Building the keys copies the source and every symbol, which is
+        // wasted without a cache to look them up in.
+        const bool cached = isAssemblyCacheInstalled();
+        if (cached) {
+            for (const std::optional<u32> placement :
+                 {std::optional<u32>(), std::optional<u32>(address)}) {
+                if (std::optional<std::vector<u32>> words = findCachedAssembly(
+                        blockCacheKey(source, placement, symbols));
+                    words.has_value())
+                    return words.value();
+            }
+        }
+
+        std::expected<Program, BlockError> program = parse(source, symbols);
+        if (!program.has_value())
+            return std::unexpected(program.error());
+
+        std::expected<void, BlockError> laidOut =
+            layout(program.value(), address, symbols);
+        if (!laidOut.has_value())
+            return std::unexpected(laidOut.error());
+
+        std::vector<u32> code = {};
+        code.reserve(program->size / sizeof(u32));
+
+        for (const auto& statement : program->statements) {
+            std::expected<void, AssembleError> emitted =
+                emit(code, program.value(), statement, address, symbols);
+            if (!emitted.has_value())
+                return std::unexpected(
+                    blockError(statement.line, emitted.error()));
+        }
+
+        if (cached)
+            cacheAssembly(isPositionIndependent(program.value())
+                              ? blockCacheKey(source, std::nullopt, symbols)
+                              : blockCacheKey(source, address, symbols),
+                          code);
+
+        return code;
+    }
+
+    std::expected<size_t, BlockError>
+    measureBlock(std::string_view source, const SymbolTable& symbols) {
+        std::expected<Program, BlockError> program = parse(source, symbols);
+        if (!program.has_value())
+            return std::unexpected(program.error());
+
+        std::expected<void, BlockError> laidOut =
+            layout(program.value(), std::nullopt, symbols);
+        if (!laidOut.has_value())
+            return std::unexpected(laidOut.error());
+
+        return program->size;
+    }
+} // namespace LibMacchiato::PPCAssembler
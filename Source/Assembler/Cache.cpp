@@ -0,0 +1,218 @@
+/*
+ * libmacchiato - Front-end for the Macchiato modding environment
+ * Copyright (C) 2024 splatoon1enjoyer @ SDL Foundation
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "LibMacchiato/Assembler/Cache.h"
+
+#include <sdl-utils/Types.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace LibMacchiato::PPCAssembler {
+    namespace {
+        template <typename T>
+        void writeValue(std::vector<u8>& data, const T& value) {
+            const size_t offset = data.size();
+
+            data.resize(offset + sizeof(T));
+            std::memcpy(data.data() + offset, &value, sizeof(T));
+        }
+
+        struct Reader {
+            std::span<const u8> data   = {};
+            size_t              offset = 0;
+
+            [[nodiscard]] bool canRead(size_t size) const {
+                return size <= this->data.size() - this->offset;
+            }
+
+            template <typename T> [[nodiscard]] std::optional<T> read() {
+                if (!this->canRead(sizeof(T)))
+                    return std::nullopt;
+
+                T value;
+                std::memcpy(&value, this->data.data() + this->offset,
+                            sizeof(T));
+                this->offset += sizeof(T);
+
+                return value;
+            }
+        };
+
+        std::mutex                   installedCacheMutex = {};
+        std::optional<AssemblyCache> installedCache      = std::nullopt;
+
+        // Lets `assemble` skip the lock when no cache is installed.
+        std::atomic<bool> cacheInstalled = false;
+    } // namespace
+
+    std::optional<std::span<const u32>>
+    AssemblyCache::find(std::string_view key) {
+        auto it = this->entries.find(key);
+        if (it == this->entries.end())
+            return std::nullopt;
+
+        it->second.used = true;
+        return std::span<const u32>(it->second.words);
+    }
+
+    void AssemblyCache::insert(std::string_view     key,
+                               std::span<const u32> words) {
+        if (this->entries
+                .try_emplace(std::string(key),
+                             Entry{.words = std::vector<u32>(words.begin(),
+                                                             words.end()),
+                                   .used  = true})
+                .second)
+            this->dirty = true;
+    }
+
+    void AssemblyCache::evictUnused() {
+        if (std::erase_if(this->entries,
+                          [](const auto& entry) { return !entry.second.used; })
+            > 0)
+            this->dirty = true;
+    }
+
+    std::vector<u8> AssemblyCache::serialize() const {
+        std::vector<u8> data = {};
+
+        writeValue(data, ASSEMBLY_CACHE_MAGIC);
+        writeValue(data, ASSEMBLY_CACHE_FORMAT_VERSION);
+        writeValue(data, this->buildHash);
+        writeValue(data, static_cast<u32>(this->entries.size()));
+
+        for (const auto& [key, entry] : this->entries) {
+            writeValue(data, static_cast<u32>(key.size()));
+            writeValue(data, static_cast<u32>(entry.words.size()));
+
+            data.insert(data.end(), key.begin(), key.end());
+            for (const u32 word : entry.words)
+                writeValue(data, word);
+        }
+
+        return data;
+    }
+
+    std::optional<AssemblyCache>
+    AssemblyCache::deserialize(std::span<const u8> data, u64 buildHash) {
+        Reader reader = {.data = data};
+
+        if (reader.read<u32>() != ASSEMBLY_CACHE_MAGIC
+            || reader.read<u32>() != ASSEMBLY_CACHE_FORMAT_VERSION
+            || reader.read<u64>() != buildHash)
+            return std::nullopt;
+
+        std::optional<u32> entryNum = reader.read<u32>();
+        if (!entryNum.has_value())
+            return std::nullopt;
+
+        AssemblyCache cache = {.buildHash = buildHash};
+
+        for (u32 i = 0; i < entryNum.value(); i++) {
+            std::optional<u32> keySize = reader.read<u32>();
+            std::optional<u32> wordNum = reader.read<u32>();
+            if (!keySize.has_value() || !wordNum.has_value()
+                || !reader.canRead(keySize.value()))
+                return std::nullopt;
+
+            std::string key(
+                reinterpret_cast<const char*>(data.data() + reader.offset),
+                keySize.value());
+            reader.offset += keySize.value();
+
+            if (!reader.canRead(size_t{wordNum.value()} * sizeof(u32)))
+                return std::nullopt;
+
+            std::vector<u32> words(wordNum.value());
+            for (u32& word : words)
+                word = reader.read<u32>().value();
+
+            cache.entries[std::move(key)].words = std::move(words);
+        }
+
+        if (reader.offset != data.size())
+            return std::nullopt;
+
+        return cache;
+    }
+
+    void installAssemblyCache(AssemblyCache cache) {
+        std::lock_guard lock(installedCacheMutex);
+
+        installedCache = std::move(cache);
+        cacheInstalled.store(true, std::memory_order_release);
+    }
+
+    std::optional<AssemblyCache> uninstallAssemblyCache() {
+        std::lock_guard lock(installedCacheMutex);
+
+        cacheInstalled.store(false, std::memory_order_release);
+        return std::exchange(installedCache, std::nullopt);
+    }
+
+    bool isAssemblyCacheInstalled() {
+        return cacheInstalled.load(std::memory_order_acquire);
+    }
+
+    std::optional<std::vector<u32>> findCachedAssembly(std::string_view key) {
+        if (!cacheInstalled.load(std::memory_order_acquire))
+            return std::nullopt;
+
+        std::lock_guard lock(installedCacheMutex);
+        if (!installedCache.has_value())
+            return std::nullopt;
+
+        std::optional<std::span<const u32>> words = installedCache->find(key);
+        if (!words.has_value())
+            return std::nullopt;
+
+        return std::vector<u32>(words->begin(), words->end());
+    }
+
+    std::optional<u32> findCachedInstruction(std::string_view key) {
+        if (!cacheInstalled.load(std::memory_order_acquire))
+            return std::nullopt;
+
+        std::lock_guard lock(installedCacheMutex);
+        if (!installedCache.has_value())
+            return std::nullopt;
+
+        std::optional<std::span<const u32>> words = installedCache->find(key);
+        if (!words.has_value() || words->size() != 1)
+            return std::nullopt;
+
+        return words->front();
+    }
+
+    void cacheAssembly(std::string_view key, std::span<const u32> words) {
+        if (!cacheInstalled.load(std::memory_order_acquire))
+            return;
+
+        std::lock_guard lock(installedCacheMutex);
+        if (installedCache.has_value())
+            installedCache->insert(key, words);
+    }
+} // namespace LibMacchiato::PPCAssembler
@@ -0,0 +1,12 @@
+// Executable memory for the stubs of hooks, see `sharedCodePool`. It lives
+// in the text of the module, which the loader places close enough to the
+// code of the title for a single `b` to reach it.
+.section .text
+.align 5
+
+.global MacchiatoCodeCave
+MacchiatoCodeCave:
+        .space 0x8000
+
+.global MacchiatoCodeCaveEnd
+MacchiatoCodeCaveEnd:
@@ -0,0 +1,38 @@
+/*
+ * libmacchiato - Front-end for the Macchiato modding environment
+ * Copyright (C) 2024 splatoon1enjoyer @ SDL Foundation
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "LibMacchiato/Patch/CodeArena.h"
+
+extern "C" const u32 MacchiatoCodeCave[];
+extern "C" const u32 MacchiatoCodeCaveEnd[];
+
+namespace LibMacchiato {
+    CodePool& sharedCodePool() {
+        static CodePool pool;
+
+        // The cave is registered once, every arena takes its stubs from it.
+        [[maybe_unused]] static const bool reserved = [] {
+            const u32 cave    = reinterpret_cast<u32>(MacchiatoCodeCave);
+            const u32 caveEnd = reinterpret_cast<u32>(MacchiatoCodeCaveEnd);
+
+            pool.addCave(cave, caveEnd - cave);
+            return true;
+        }();
+
+        return pool;
+    }
+} // namespace LibMacchiato
@@ -19,84 +19,55 @@
 #include "LibMacchiato/Assembler.h"
 #include "LibMacchiato/Utils/Memory.h"
 
-#include <format>
+#include <array>
 #include <optional>
+#include <span>
+#include <vector>
 
 namespace LibMacchiato::Utils::Assembly {
     uintptr_t getAdjustedAddressIfFirstInstructionIsBranch(uintptr_t address) {
-        u32 addressData   = Utils::Memory::readU32(static_cast<u32>(address));
-        u32 addressOpcode = addressData & 0xFC000000;
-
-        bool addressOpcodeIsBranch = (addressOpcode & 0x48000000) == 0x48000000;
-
-        if (!addressOpcodeIsBranch)
+        u32 addressData = Utils::Memory::readU32(static_cast<u32>(address));
+
+        // Only plain jumps forward execution, `bl` returns to the function.
+        std::optional<PPCAssembler::PPCInstruction> instruction =
+            PPCAssembler::disassemble(addressData);
+        if (!instruction.has_value()
+            || (instruction->mnemonic != PPCAssembler::PPCMnemonic::B
+                && instruction->mnemonic != PPCAssembler::PPCMnemonic::BA))
             return address;
 
-        u32 aa         = (addressData & 0x00000002) >> 1;
-        u32 lk         = addressData & 0x00000001;
-        u32 jumpOffset = addressData & 0x03FFFFFC;
-
-        bool branchUsesAbsoluteAddress = aa == 1 && lk == 0;
-
-        if (branchUsesAbsoluteAddress) {
-            address = jumpOffset >> 2;
-        } else {
-            // bool jumpOffsetIsNegative = (jumpOffset & 0x02000000) ==
-            // 0x02000000;
-            bool jumpOffsetIsNegative = (jumpOffset & 0x02000000) != jumpOffset;
-
-            if (jumpOffsetIsNegative) {
-                jumpOffset += 0xFE000000;
-            }
-
-            address += jumpOffset;
-        }
+        address = PPCAssembler::branchTarget(addressData,
+                                             static_cast<u32>(address))
+                      .value();
 
         return getAdjustedAddressIfFirstInstructionIsBranch(address);
     }
 
-    std::optional<u32> shortJump(u32 dst) {
-        if (dst > 0x01FFFFFC)
-            return std::nullopt;
+    void jump(PPCAssembler::Emitter& emitter, u32 dst) { emitter.jmp(dst); }
 
-        return PPCAssembler::assemble(std::format("ba {}", dst)).value();
-    }
-
-    std::vector<u32> longJump(u32 dst) {
-        std::pair<u16, u16> jumpAddressHalfs =
-            Utils::Memory::splitAddress(static_cast<uintptr_t>(dst));
-
-        std::vector<u32> jump = {
-            PPCAssembler::assemble(
-                std::format("lis r11, {}",
-                            std::to_string(jumpAddressHalfs.first)))
-                .value(),
+    std::vector<u32> jump(u32 dst) {
+        std::array<u32, MAX_JUMP_SIZE> jumpBytes = {};
 
-            PPCAssembler::assemble("ori r11, r11, "
-                                   + std::to_string(jumpAddressHalfs.second))
-                .value(),
-            PPCAssembler::assemble("mtctr r11").value(),
-            PPCAssembler::assemble("bctr").value()};
+        PPCAssembler::Emitter emitter(jumpBytes, 0);
+        emitter.absoluteJmp(dst);
 
-        return jump;
+        return std::vector<u32>(jumpBytes.begin(),
+                                jumpBytes.begin() + emitter.finish().value());
     }
 
-    std::vector<u32> jump(u32 dst) {
-        std::optional<u32> maybeShortJump = shortJump(dst);
+    std::vector<LinePatch> jump(u32 address, u32 dst) {
+        std::array<u32, MAX_JUMP_SIZE> jumpBytes = {};
 
-        if (maybeShortJump.has_value())
-            return {maybeShortJump.value()};
+        PPCAssembler::Emitter emitter(jumpBytes, address);
+        jump(emitter, dst);
 
-        return longJump(dst);
-    }
+        const size_t jumpSize = emitter.finish().value();
 
-    std::vector<LinePatch> jump(u32 address, u32 dst) {
-        std::vector<u32>       jumpBytes = jump(dst);
-        std::vector<LinePatch> result    = {};
+        std::vector<LinePatch> result = {};
 
         u32 offset = 0;
 
-        for (const auto byte : jumpBytes) {
+        for (const auto byte : std::span(jumpBytes).first(jumpSize)) {
             result.push_back(LinePatch::create(address + offset, byte));
 
             offset += sizeof(u32);
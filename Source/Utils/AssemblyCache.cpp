@@ -0,0 +1,115 @@
+/*
+ * libmacchiato - Front-end for the Macchiato modding environment
+ * Copyright (C) 2024 splatoon1enjoyer @ SDL Foundation
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "LibMacchiato/Utils/AssemblyCache.h"
+#include "LibMacchiato/Assembler/Cache.h"
+#include "LibMacchiato/Assembler/PerfectHash.h"
+#include "LibMacchiato/Log.h"
+#include "LibMacchiato/Utils/Filesystem.h"
+#include "LibMacchiato/Version.h"
+
+#include <sdl-utils/Types.h>
+
+#include <format>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace LibMacchiato::Utils::AssemblyCache {
+    namespace {
+        std::string versionToKey(const VersionTriplet& version) {
+            return std::format("{}.{}.{}", version.major, version.minor,
+                               version.patch);
+        }
+    } // namespace
+
+    u64 buildHash(const MacchiatoExport& macchiatoExport) {
+        const std::string build = std::format(
+            "{}\n{}\n{}\n{}\n{}\n{:016X}", macchiatoExport.pluginName,
+            versionToKey(macchiatoExport.pluginVersion),
+            versionToKey(macchiatoExport.macchiatoApiVersion),
+            versionToKey(LIBMACCHIATO_VERSION),
+            PPCAssembler::ASSEMBLY_CACHE_FORMAT_VERSION,
+            PPCAssembler::ASSEMBLER_FINGERPRINT);
+
+        return PPCAssembler::hashString(build);
+    }
+
+    std::string cachePath(const MacchiatoExport& macchiatoExport) {
+        return std::format("{}/cache/{}.asm", FS::MACCHIATO_BASE_PATH,
+                           macchiatoExport.pluginName);
+    }
+
+    bool load(const MacchiatoExport& macchiatoExport) {
+        const u64         hash = buildHash(macchiatoExport);
+        const std::string path = cachePath(macchiatoExport);
+
+        std::optional<PPCAssembler::AssemblyCache> cache = std::nullopt;
+
+        if (FS::fileExists(path)) {
+            if (std::optional<std::vector<u8>> data = FS::readFile(path);
+                data.has_value())
+                cache = PPCAssembler::AssemblyCache::deserialize(data.value(),
+                                                                 hash);
+
+            if (!cache.has_value())
+                MWARN("Discarding stale assembly cache \"{}\"", path);
+        }
+
+        const bool loaded = cache.has_value();
+
+        PPCAssembler::installAssemblyCache(
+            loaded ? std::move(cache.value())
+                   : PPCAssembler::AssemblyCache{.buildHash = hash});
+
+        return loaded;
+    }
+
+    bool save(const MacchiatoExport& macchiatoExport) {
+        std::optional<PPCAssembler::AssemblyCache> cache =
+            PPCAssembler::uninstallAssemblyCache();
+        if (!cache.has_value())
+            return false;
+
+        cache->evictUnused();
+
+        bool saved = !cache->dirty;
+
+        if (!saved && FS::createDirectory(std::format(
+                          "{}/cache", FS::MACCHIATO_BASE_PATH))) {
+            const std::vector<u8> data = cache->serialize();
+
+            saved = FS::writeFile(
+                cachePath(macchiatoExport),
+                std::string_view(reinterpret_cast<const char*>(data.data()),
+                                 data.size()));
+        }
+
+        if (saved)
+            cache->dirty = false;
+        else
+            MERROR("Failed to save assembly cache \"{}\"",
+                   cachePath(macchiatoExport));
+
+        PPCAssembler::installAssemblyCache(std::move(cache.value()));
+
+        return saved;
+    }
+} // namespace LibMacchiato::Utils::AssemblyCache